@@ -50,6 +50,25 @@ public class Funapi : ModuleRules
       PublicDefinitions.Add("FUNAPI_HAVE_RPC=1");
     }
 
+    if (Target.Platform == UnrealTargetPlatform.Linux ||
+        Target.Platform == UnrealTargetPlatform.Android) {
+      PublicDefinitions.Add("FUNAPI_HAVE_EPOLL=1");
+      PublicDefinitions.Add("FUNAPI_HAVE_EVENTFD=1");
+    }
+    else {
+      PublicDefinitions.Add("FUNAPI_HAVE_EPOLL=0");
+      PublicDefinitions.Add("FUNAPI_HAVE_EVENTFD=0");
+    }
+
+    if (Target.Platform == UnrealTargetPlatform.Linux) {
+      PublicDefinitions.Add("FUNAPI_HAVE_MMSG=1");
+      PublicDefinitions.Add("FUNAPI_HAVE_KTLS=1");
+    }
+    else {
+      PublicDefinitions.Add("FUNAPI_HAVE_MMSG=0");
+      PublicDefinitions.Add("FUNAPI_HAVE_KTLS=0");
+    }
+
     if (Target.Platform == UnrealTargetPlatform.Win32 ||
         Target.Platform == UnrealTargetPlatform.Win64) {
       PublicDefinitions.Add("FUNAPI_PLATFORM_WINDOWS=1");
@@ -66,6 +85,14 @@ public class Funapi : ModuleRules
       );
     }
 
+    // NOTE: LZ4 라이브러리는 ThirdParty 에 포함되어 있지 않다.
+    // 사용하려면 플랫폼별 liblz4 와 lz4.h 를 ThirdParty 에 추가하고 1 로 바꾼다.
+    PublicDefinitions.Add("FUNAPI_HAVE_LZ4=0");
+
+    // NOTE: ThirdParty 의 zstd 헤더에는 zdict.h 가 없다. 사전 학습(ZDICT_trainFromBuffer)을
+    // 쓰려면 라이브러리와 같은 버전의 zdict.h 를 ThirdParty/include 에 추가하고 1 로 바꾼다.
+    PublicDefinitions.Add("FUNAPI_HAVE_ZDICT=0");
+
     if (Target.Platform == UnrealTargetPlatform.Linux) {
       PublicDefinitions.Add("FUNAPI_HAVE_ZSTD=0");
       PublicDefinitions.Add("FUNAPI_HAVE_SODIUM=0");
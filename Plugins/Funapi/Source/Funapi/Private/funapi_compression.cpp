@@ -12,6 +12,7 @@
 
 #include "funapi_utils.h"
 #include "funapi_session.h"
+#include "funapi_header_view.h"
 
 #if FUNAPI_HAVE_ZLIB
 extern "C" {
@@ -25,6 +26,14 @@ extern "C" {
 #include <zstd.h>
 #endif
 
+#if FUNAPI_HAVE_ZSTD && FUNAPI_HAVE_ZDICT
+#include <zdict.h>
+#endif
+
+#if FUNAPI_HAVE_LZ4
+#include <lz4.h>
+#endif
+
 #define kProtocolHttpCompressionField "X-iFun-C" // http header
 
 namespace fun {
@@ -41,32 +50,199 @@ class Compressor : public std::enable_shared_from_this<Compressor>
 
   virtual CompressionType GetCompressionType() = 0;
 
-  virtual bool Compress(const fun::vector<uint8_t> &in, fun::vector<uint8_t> &out) = 0;
-  virtual bool Decompress(const fun::vector<uint8_t> &in, fun::vector<uint8_t> &out) = 0;
+  // out 의 out_offset 위치부터 압축 결과를 쓴다. out_offset 앞의 내용은 유지된다.
+  virtual bool Compress(const uint8_t *in, const size_t in_size,
+                        fun::vector<uint8_t> &out, const size_t out_offset) = 0;
+  virtual bool Decompress(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size) = 0;
+
+  // 연결 동안 이어지는 스트림으로 압축한다. 메시지마다 flush 하므로 결과만으로 복원할 수 있지만
+  // 이전 메시지를 참조하므로 결과가 입력보다 커도 그대로 보내야 한다.
+  virtual bool CompressStream(const uint8_t *in, const size_t in_size,
+                              fun::vector<uint8_t> &out, const size_t out_offset) = 0;
+  // out_size 는 압축 전 길이이다.
+  virtual bool DecompressStream(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size) = 0;
+  virtual void ResetStream() = 0;
 };
 
 
 #define ZLIB_WS (-15)
 
 
+////////////////////////////////////////////////////////////////////////////////
+// CompressorContextPool implementation.
+
+// NOTE: 압축 컨텍스트는 만들 때 수십~수백 KB 를 할당하므로 메시지마다 만들지 않고 재사용한다.
+// 트랜스포트는 보통 네트워크 스레드에서만 압축하므로 컨텍스트는 하나만 만들어지고,
+// 여러 스레드에서 동시에 압축하는 경우에만 동시에 쓰는 수만큼 늘어난다.
+template <typename T>
+class CompressorContextPool
+{
+ public:
+  typedef std::function<T*()> CreateHandler;
+  typedef std::function<void(T*)> DestroyHandler;
+
+  // 빌린 컨텍스트를 범위를 벗어날 때 돌려준다.
+  class ScopedContext
+  {
+   public:
+    explicit ScopedContext(CompressorContextPool &pool)
+    : pool_(pool), context_(pool.Acquire()) {
+    }
+
+    ~ScopedContext() {
+      if (context_) {
+        pool_.Release(context_);
+      }
+    }
+
+    T* Get() const {
+      return context_;
+    }
+
+   private:
+    CompressorContextPool &pool_;
+    T *context_;
+  };
+
+  CompressorContextPool(const CreateHandler &create_handler,
+                        const DestroyHandler &destroy_handler)
+  : create_handler_(create_handler), destroy_handler_(destroy_handler) {
+  }
+
+  ~CompressorContextPool() {
+    for (auto context : contexts_) {
+      destroy_handler_(context);
+    }
+  }
+
+  // 만들지 못하면 nullptr 를 반환한다.
+  T* Acquire() {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!contexts_.empty()) {
+        T *context = contexts_.back();
+        contexts_.pop_back();
+        return context;
+      }
+    }
+
+    return create_handler_();
+  }
+
+  void Release(T *context) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    contexts_.push_back(context);
+  }
+
+ private:
+  std::mutex mutex_;
+  fun::vector<T*> contexts_;
+  CreateHandler create_handler_;
+  DestroyHandler destroy_handler_;
+};
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // CompressorZlib implementation.
 class CompressorZlib : public Compressor
 {
  public:
-  CompressorZlib() = default;
-  virtual ~CompressorZlib() = default;
+  CompressorZlib();
+  virtual ~CompressorZlib();
 
   CompressionType GetCompressionType();
 
-  bool Compress(const fun::vector<uint8_t> &in, fun::vector<uint8_t> &out);
-  bool Decompress(const fun::vector<uint8_t> &in, fun::vector<uint8_t> &out);
+  bool Compress(const uint8_t *in, const size_t in_size,
+                fun::vector<uint8_t> &out, const size_t out_offset);
+  bool Decompress(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size);
+
+  bool CompressStream(const uint8_t *in, const size_t in_size,
+                      fun::vector<uint8_t> &out, const size_t out_offset);
+  bool DecompressStream(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size);
+  void ResetStream();
 
  private:
   size_t GetMaximumLength(size_t in_size);
+
+#if FUNAPI_HAVE_ZLIB
+  static z_stream* CreateDeflateStream();
+  static void DestroyDeflateStream(z_stream *zstr);
+  static z_stream* CreateInflateStream();
+  static void DestroyInflateStream(z_stream *zstr);
+
+  // 스트림은 한 번만 초기화하고 메시지마다 deflateReset/inflateReset 으로 재사용한다.
+  CompressorContextPool<z_stream> deflate_streams_;
+  CompressorContextPool<z_stream> inflate_streams_;
+
+  // 스트림 압축에 쓰는 연결 단위 스트림. 처음 쓸 때 만든다.
+  z_stream *stream_deflate_ = nullptr;
+  z_stream *stream_inflate_ = nullptr;
+#endif
 };
 
 
+CompressorZlib::CompressorZlib()
+#if FUNAPI_HAVE_ZLIB
+: deflate_streams_(&CompressorZlib::CreateDeflateStream, &CompressorZlib::DestroyDeflateStream),
+  inflate_streams_(&CompressorZlib::CreateInflateStream, &CompressorZlib::DestroyInflateStream)
+#endif
+{
+}
+
+
+CompressorZlib::~CompressorZlib() {
+  ResetStream();
+}
+
+
+#if FUNAPI_HAVE_ZLIB
+z_stream* CompressorZlib::CreateDeflateStream() {
+  z_stream *zstr = new z_stream;
+  memset(zstr, 0, sizeof(z_stream));
+  zstr->zalloc = Z_NULL;
+  zstr->zfree = Z_NULL;
+  zstr->opaque = Z_NULL;
+
+  if (::deflateInit2(zstr, 3, Z_DEFLATED, ZLIB_WS, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+    DebugUtils::Log("Failed to initialize zlib stream.");
+    delete zstr;
+    return nullptr;
+  }
+
+  return zstr;
+}
+
+
+void CompressorZlib::DestroyDeflateStream(z_stream *zstr) {
+  ::deflateEnd(zstr);
+  delete zstr;
+}
+
+
+z_stream* CompressorZlib::CreateInflateStream() {
+  z_stream *zstr = new z_stream;
+  memset(zstr, 0, sizeof(z_stream));
+  zstr->zalloc = Z_NULL;
+  zstr->zfree = Z_NULL;
+  zstr->opaque = Z_NULL;
+
+  if (::inflateInit2(zstr, ZLIB_WS) != Z_OK) {
+    DebugUtils::Log("Failed to initialize zlib stream.");
+    delete zstr;
+    return nullptr;
+  }
+
+  return zstr;
+}
+
+
+void CompressorZlib::DestroyInflateStream(z_stream *zstr) {
+  ::inflateEnd(zstr);
+  delete zstr;
+}
+#endif
+
+
 size_t CompressorZlib::GetMaximumLength(size_t in_size) {
   return 18 + in_size + 5 * (in_size / 16383 + 1);
 }
@@ -82,42 +258,61 @@ CompressionType CompressorZlib::GetCompressionType()
 }
 
 
-bool CompressorZlib::Compress(const fun::vector<uint8_t> &in, fun::vector<uint8_t> &out)
+bool CompressorZlib::Compress(const uint8_t *in, const size_t in_size,
+                              fun::vector<uint8_t> &out, const size_t out_offset)
 {
 #if FUNAPI_HAVE_ZLIB
-  const size_t in_size = in.size();
+  CompressorContextPool<z_stream>::ScopedContext context(deflate_streams_);
+  z_stream *zstr = context.Get();
+  if (zstr == nullptr || ::deflateReset(zstr) != Z_OK) {
+    return false;
+  }
+
   const size_t max_size = GetMaximumLength(in_size);
-  out.resize(max_size);
+  out.resize(out_offset + max_size);
 
-  z_stream zstr;
-  zstr.zalloc = Z_NULL;
-  zstr.zfree = Z_NULL;
-  zstr.opaque = Z_NULL;
+  zstr->next_in = const_cast<uint8_t*>(in);
+  zstr->avail_in = static_cast<unsigned int>(in_size);
+  zstr->next_out = out.data() + out_offset;
+  zstr->avail_out = static_cast<unsigned int>(max_size);
 
-  zstr.next_in = const_cast<uint8_t*>(in.data());
-  zstr.avail_in = static_cast<unsigned int>(in_size);
-  zstr.next_out = out.data();
-  zstr.avail_out = static_cast<unsigned int>(max_size);
+  if (::deflate(zstr, Z_FINISH) != Z_STREAM_END) {
+    return false;
+  }
 
-  int result = ::deflateInit2(&zstr, 3, Z_DEFLATED, ZLIB_WS, 9, Z_DEFAULT_STRATEGY);
-  if (result != Z_OK) {
+  const size_t out_size = max_size - zstr->avail_out;
+  if (out_size >= in_size) {
     return false;
   }
 
-  result = deflate(&zstr, Z_FINISH);
-  if (result != Z_STREAM_END) {
-    deflateEnd(&zstr);
+  out.resize(out_offset + out_size);
+#endif
+
+  return true;
+}
+
+
+bool CompressorZlib::Decompress(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size)
+{
+#if FUNAPI_HAVE_ZLIB
+  CompressorContextPool<z_stream>::ScopedContext context(inflate_streams_);
+  z_stream *zstr = context.Get();
+  if (zstr == nullptr || ::inflateReset(zstr) != Z_OK) {
     return false;
   }
 
-  const size_t out_size = max_size - zstr.avail_out;
-  if (out_size >= in_size) {
+  zstr->next_in = const_cast<uint8_t*>(in);
+  zstr->avail_in = static_cast<unsigned int>(in_size);
+  zstr->next_out = out;
+  zstr->avail_out = static_cast<unsigned int>(out_size);
+
+  if (::inflate(zstr, Z_FINISH) != Z_STREAM_END) {
+    DebugUtils::Log("Failed to compress (zlib).");
     return false;
   }
 
-  out.resize(out_size);
-  result = deflateEnd(&zstr);
-  if (result != Z_OK) {
+  if (zstr->avail_out != 0) {
+    DebugUtils::Log("Failed to finish compression (zlib).");
     return false;
   }
 #endif
@@ -126,35 +321,86 @@ bool CompressorZlib::Compress(const fun::vector<uint8_t> &in, fun::vector<uint8_
 }
 
 
-bool CompressorZlib::Decompress(const fun::vector<uint8_t> &in, fun::vector<uint8_t> &out)
+// NOTE: Z_SYNC_FLUSH 는 빈 stored block(00 00 ff ff)으로 끝나므로 permessage-deflate(RFC 7692)
+// 처럼 보낼 때 떼고 받을 때 붙인다.
+static const uint8_t kZlibSyncFlushTail[] = { 0x00, 0x00, 0xff, 0xff };
+
+
+bool CompressorZlib::CompressStream(const uint8_t *in, const size_t in_size,
+                                    fun::vector<uint8_t> &out, const size_t out_offset)
 {
 #if FUNAPI_HAVE_ZLIB
-  z_stream zstr;
-  zstr.zalloc = Z_NULL;
-  zstr.zfree = Z_NULL;
-  zstr.opaque = Z_NULL;
-
-  zstr.next_in = const_cast<uint8_t*>(in.data());
-  zstr.avail_in = static_cast<unsigned int>(in.size());
-  zstr.next_out = out.data();
-  zstr.avail_out = static_cast<unsigned int>(out.size());
-
-  int result = ::inflateInit2(&zstr, ZLIB_WS);
-  if (result != Z_OK) {
-    DebugUtils::Log("Failed to initialize zlib stream.");
+  if (stream_deflate_ == nullptr) {
+    stream_deflate_ = CreateDeflateStream();
+    if (stream_deflate_ == nullptr) {
+      return false;
+    }
+  }
+
+  out.resize(out_offset + GetMaximumLength(in_size) + sizeof(kZlibSyncFlushTail));
+
+  stream_deflate_->next_in = const_cast<uint8_t*>(in);
+  stream_deflate_->avail_in = static_cast<unsigned int>(in_size);
+
+  size_t out_size = 0;
+  while (true) {
+    stream_deflate_->next_out = out.data() + out_offset + out_size;
+    stream_deflate_->avail_out = static_cast<unsigned int>(out.size() - out_offset - out_size);
+
+    const int result = ::deflate(stream_deflate_, Z_SYNC_FLUSH);
+    if (result != Z_OK && result != Z_BUF_ERROR) {
+      return false;
+    }
+
+    out_size = out.size() - out_offset - stream_deflate_->avail_out;
+    if (stream_deflate_->avail_out != 0) {
+      // flush 가 끝났다.
+      break;
+    }
+
+    out.resize(out.size() * 2);
+  }
+
+  if (out_size < sizeof(kZlibSyncFlushTail) ||
+      memcmp(out.data() + out_offset + out_size - sizeof(kZlibSyncFlushTail),
+             kZlibSyncFlushTail, sizeof(kZlibSyncFlushTail)) != 0) {
     return false;
   }
 
-  result = inflate(&zstr, Z_FINISH);
-  if (result != Z_STREAM_END) {
-    ::inflateEnd(&zstr);
-    DebugUtils::Log("Failed to compress (zlib).");
+  out.resize(out_offset + out_size - sizeof(kZlibSyncFlushTail));
+#endif
+
+  return true;
+}
+
+
+bool CompressorZlib::DecompressStream(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size)
+{
+#if FUNAPI_HAVE_ZLIB
+  if (stream_inflate_ == nullptr) {
+    stream_inflate_ = CreateInflateStream();
+    if (stream_inflate_ == nullptr) {
+      return false;
+    }
+  }
+
+  stream_inflate_->next_out = out;
+  stream_inflate_->avail_out = static_cast<unsigned int>(out_size);
+
+  stream_inflate_->next_in = const_cast<uint8_t*>(in);
+  stream_inflate_->avail_in = static_cast<unsigned int>(in_size);
+  int result = ::inflate(stream_inflate_, Z_SYNC_FLUSH);
+  if ((result != Z_OK && result != Z_BUF_ERROR) || stream_inflate_->avail_in != 0) {
+    DebugUtils::Log("Failed to decompress stream (zlib).");
     return false;
   }
 
-  result = ::inflateEnd(&zstr);
-  if (result != Z_OK || zstr.avail_out != 0) {
-    DebugUtils::Log("Failed to finish compression (zlib).");
+  stream_inflate_->next_in = const_cast<uint8_t*>(kZlibSyncFlushTail);
+  stream_inflate_->avail_in = sizeof(kZlibSyncFlushTail);
+  result = ::inflate(stream_inflate_, Z_SYNC_FLUSH);
+  if ((result != Z_OK && result != Z_BUF_ERROR) ||
+      stream_inflate_->avail_in != 0 || stream_inflate_->avail_out != 0) {
+    DebugUtils::Log("Failed to decompress stream (zlib).");
     return false;
   }
 #endif
@@ -163,27 +409,63 @@ bool CompressorZlib::Decompress(const fun::vector<uint8_t> &in, fun::vector<uint
 }
 
 
+void CompressorZlib::ResetStream()
+{
+#if FUNAPI_HAVE_ZLIB
+  if (stream_deflate_) {
+    DestroyDeflateStream(stream_deflate_);
+    stream_deflate_ = nullptr;
+  }
+
+  if (stream_inflate_) {
+    DestroyInflateStream(stream_inflate_);
+    stream_inflate_ = nullptr;
+  }
+#endif
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // CompressorZstd implementation.
 class CompressorZstd : public Compressor
 {
  public:
-  CompressorZstd() = default;
+  CompressorZstd();
   virtual ~CompressorZstd();
 
   CompressionType GetCompressionType();
 
-  bool Compress(const fun::vector<uint8_t> &in, fun::vector<uint8_t> &out);
-  bool Decompress(const fun::vector<uint8_t> &in, fun::vector<uint8_t> &out);
+  bool Compress(const uint8_t *in, const size_t in_size,
+                fun::vector<uint8_t> &out, const size_t out_offset);
+  bool Decompress(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size);
+
+  bool CompressStream(const uint8_t *in, const size_t in_size,
+                      fun::vector<uint8_t> &out, const size_t out_offset);
+  bool DecompressStream(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size);
+  void ResetStream();
 
   void SetDictBase64String(const fun::string &zstd_dict_base64string);
+  void SetDict(const fun::vector<uint8_t> &dict_buf);
+
+  // 사전 ID 로 구분하는 사전. 등록한 사전 ID 를 반환하고 사전 ID 가 없는 사전이면 0 을 반환한다.
+  uint32_t AddDict(const fun::vector<uint8_t> &dict_buf);
+  bool HasDict(const uint32_t dict_id);
+  bool Compress(const uint32_t dict_id,
+                const uint8_t *in, const size_t in_size,
+                fun::vector<uint8_t> &out, const size_t out_offset);
+  bool Decompress(const uint32_t dict_id, const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size);
 
  private:
 #if FUNAPI_HAVE_ZSTD
-  size_t DoCompressSmall(::ZSTD_CCtx *ctxt, const void *src, size_t src_size, void *dst, size_t dst_size);
-  size_t DoCompress(::ZSTD_CCtx *ctxt, const void *src, size_t src_size, void *dst, size_t dst_size);
-  size_t DoDecompressSmall(::ZSTD_DCtx *ctxt, void *dst, size_t dst_size, const void *src, size_t src_size);
-  size_t DoDecompress(::ZSTD_DCtx *ctxt, void *dst, size_t dst_size, const void *src, size_t src_size);
+  bool Compress(const ::ZSTD_CDict *cdict,
+                const uint8_t *in, const size_t in_size,
+                fun::vector<uint8_t> &out, const size_t out_offset);
+  bool Decompress(const ::ZSTD_DDict *ddict, const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size);
+
+  size_t DoCompressSmall(::ZSTD_CCtx *ctxt, const ::ZSTD_CDict *cdict, const void *src, size_t src_size, void *dst, size_t dst_size);
+  size_t DoCompress(::ZSTD_CCtx *ctxt, const ::ZSTD_CDict *cdict, const void *src, size_t src_size, void *dst, size_t dst_size);
+  size_t DoDecompressSmall(::ZSTD_DCtx *ctxt, const ::ZSTD_DDict *ddict, void *dst, size_t dst_size, const void *src, size_t src_size);
+  size_t DoDecompress(::ZSTD_DCtx *ctxt, const ::ZSTD_DDict *ddict, void *dst, size_t dst_size, const void *src, size_t src_size);
 #endif
 
   void Cleanup();
@@ -191,6 +473,22 @@ class CompressorZstd : public Compressor
 #if FUNAPI_HAVE_ZSTD
   ::ZSTD_CDict *cdict_ = NULL;
   ::ZSTD_DDict *ddict_ = NULL;
+
+  // 사전 ID 로 찾는 사전. 연결 설정 중에만 추가하므로 압축 중에는 바뀌지 않는다.
+  struct Dict {
+    ::ZSTD_CDict *cdict;
+    ::ZSTD_DDict *ddict;
+  };
+  fun::unordered_map<uint32_t, Dict> dicts_;
+
+  // 컨텍스트는 재사용하고 메시지마다 ZSTD_compressBegin* 으로 다시 시작한다.
+  // 사전은 미리 만들어 둔 CDict/DDict 를 참조만 하므로 다시 읽지 않는다.
+  CompressorContextPool<::ZSTD_CCtx> cctxs_;
+  CompressorContextPool<::ZSTD_DCtx> dctxs_;
+
+  // 스트림 압축은 연결 동안 하나의 프레임을 끝내지 않고 이어서 쓴다.
+  ::ZSTD_CStream *cstream_ = NULL;
+  ::ZSTD_DStream *dstream_ = NULL;
 #endif
 };
 
@@ -201,8 +499,28 @@ class CompressorZstd : public Compressor
 #define kZstdNoFrameParam {0, 0, 1}
 #endif
 
+CompressorZstd::CompressorZstd()
+#if FUNAPI_HAVE_ZSTD
+: cctxs_([]() { return ::ZSTD_createCCtx(); },
+         [](::ZSTD_CCtx *ctxt) { ::ZSTD_freeCCtx(ctxt); }),
+  dctxs_([]() { return ::ZSTD_createDCtx(); },
+         [](::ZSTD_DCtx *ctxt) { ::ZSTD_freeDCtx(ctxt); })
+#endif
+{
+}
+
+
 CompressorZstd::~CompressorZstd() {
+  ResetStream();
   Cleanup();
+
+#if FUNAPI_HAVE_ZSTD
+  for (auto &iter : dicts_) {
+    ::ZSTD_freeCDict(iter.second.cdict);
+    ::ZSTD_freeDDict(iter.second.ddict);
+  }
+  dicts_.clear();
+#endif
 }
 
 
@@ -222,11 +540,11 @@ void CompressorZstd::Cleanup() {
 
 
 #if FUNAPI_HAVE_ZSTD
-size_t CompressorZstd::DoCompressSmall(::ZSTD_CCtx *ctxt, const void *src, size_t src_size, void *dst, size_t dst_size) {
+size_t CompressorZstd::DoCompressSmall(::ZSTD_CCtx *ctxt, const ::ZSTD_CDict *cdict, const void *src, size_t src_size, void *dst, size_t dst_size) {
   size_t rv = 0;
 
-  if (cdict_) {
-    ::ZSTD_compressBegin_usingCDict_advanced(ctxt, cdict_, kZstdNoFrameParam, src_size);
+  if (cdict) {
+    ::ZSTD_compressBegin_usingCDict_advanced(ctxt, cdict, kZstdNoFrameParam, src_size);
   }
   else {
     ::ZSTD_parameters param = {
@@ -249,10 +567,10 @@ size_t CompressorZstd::DoCompressSmall(::ZSTD_CCtx *ctxt, const void *src, size_
 
 
 #if FUNAPI_HAVE_ZSTD
-size_t CompressorZstd::DoCompress(::ZSTD_CCtx *ctxt, const void *src, size_t src_size, void *dst, size_t dst_size) {
+size_t CompressorZstd::DoCompress(::ZSTD_CCtx *ctxt, const ::ZSTD_CDict *cdict, const void *src, size_t src_size, void *dst, size_t dst_size) {
   size_t rv =0;
-  if (cdict_) {
-    rv = ::ZSTD_compress_usingCDict(ctxt, dst, dst_size, src, src_size, cdict_);
+  if (cdict) {
+    rv = ::ZSTD_compress_usingCDict(ctxt, dst, dst_size, src, src_size, cdict);
   }
   else {
     rv = ::ZSTD_compressCCtx(ctxt, dst, dst_size, src, src_size, kZstdCompressionLevel);
@@ -268,10 +586,10 @@ size_t CompressorZstd::DoCompress(::ZSTD_CCtx *ctxt, const void *src, size_t src
 
 
 #if FUNAPI_HAVE_ZSTD
-size_t CompressorZstd::DoDecompressSmall(::ZSTD_DCtx *ctxt, void *dst, size_t dst_size, const void *src, size_t src_size) {
+size_t CompressorZstd::DoDecompressSmall(::ZSTD_DCtx *ctxt, const ::ZSTD_DDict *ddict, void *dst, size_t dst_size, const void *src, size_t src_size) {
   size_t rv = 0;
-  if (ddict_) {
-    ::ZSTD_decompressBegin_usingDDict(ctxt, ddict_);
+  if (ddict) {
+    ::ZSTD_decompressBegin_usingDDict(ctxt, ddict);
   }
   else {
     ::ZSTD_decompressBegin(ctxt);
@@ -291,10 +609,10 @@ size_t CompressorZstd::DoDecompressSmall(::ZSTD_DCtx *ctxt, void *dst, size_t ds
 
 
 #if FUNAPI_HAVE_ZSTD
-size_t CompressorZstd::DoDecompress(::ZSTD_DCtx *ctxt, void *dst, size_t dst_size, const void *src, size_t src_size) {
+size_t CompressorZstd::DoDecompress(::ZSTD_DCtx *ctxt, const ::ZSTD_DDict *ddict, void *dst, size_t dst_size, const void *src, size_t src_size) {
   size_t rv = 0;
-  if (ddict_) {
-    rv = ::ZSTD_decompress_usingDDict(ctxt, dst, dst_size, src, src_size, ddict_);
+  if (ddict) {
+    rv = ::ZSTD_decompress_usingDDict(ctxt, dst, dst_size, src, src_size, ddict);
   }
   else {
     rv = ::ZSTD_decompressDCtx(ctxt, dst, dst_size, src, src_size);
@@ -322,87 +640,283 @@ CompressionType CompressorZstd::GetCompressionType()
 }
 
 
-bool CompressorZstd::Compress(const fun::vector<uint8_t> &in, fun::vector<uint8_t> &out)
+bool CompressorZstd::Compress(const uint8_t *in, const size_t in_size,
+                              fun::vector<uint8_t> &out, const size_t out_offset)
+{
+#if FUNAPI_HAVE_ZSTD
+  return Compress(cdict_, in, in_size, out, out_offset);
+#else
+  return true;
+#endif
+}
+
+
+bool CompressorZstd::Compress(const uint32_t dict_id,
+                              const uint8_t *in, const size_t in_size,
+                              fun::vector<uint8_t> &out, const size_t out_offset)
 {
 #if FUNAPI_HAVE_ZSTD
-  ::ZSTD_CCtx *ctxt = ::ZSTD_createCCtx();
+  auto iter = dicts_.find(dict_id);
+  if (iter == dicts_.cend()) {
+    return false;
+  }
+
+  return Compress(iter->second.cdict, in, in_size, out, out_offset);
+#else
+  return false;
+#endif
+}
+
+
+#if FUNAPI_HAVE_ZSTD
+bool CompressorZstd::Compress(const ::ZSTD_CDict *cdict,
+                              const uint8_t *in, const size_t in_size,
+                              fun::vector<uint8_t> &out, const size_t out_offset)
+{
+  CompressorContextPool<::ZSTD_CCtx>::ScopedContext context(cctxs_);
+  ::ZSTD_CCtx *ctxt = context.Get();
   if (!ctxt) {
     DebugUtils::Log("Cannot allocate ZSTD_CCtx.");
     return false;
   }
 
-  const size_t in_size = in.size();
   const size_t max_size = ZSTD_compressBound(in_size);
-  out.resize(max_size);
+  out.resize(out_offset + max_size);
   size_t compressed_size = 0;
 
   if (in_size >= kZstdMinBlock || in_size == 0) {
     compressed_size = DoCompress(ctxt,
-                                 in.data(),
+                                 cdict,
+                                 in,
                                  in_size,
-                                 out.data(),
+                                 out.data() + out_offset,
                                  max_size);
   } else {
     compressed_size = DoCompressSmall(ctxt,
-                                      in.data(),
+                                      cdict,
+                                      in,
                                       in_size,
-                                      out.data(),
+                                      out.data() + out_offset,
                                       max_size);
   }
-  ::ZSTD_freeCCtx(ctxt);
 
   if (in_size < compressed_size || compressed_size == 0) {
     return false;
   }
 
-  out.resize(compressed_size);
+  out.resize(out_offset + compressed_size);
+
+  return true;
+}
 #endif
 
+
+bool CompressorZstd::Decompress(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size)
+{
+#if FUNAPI_HAVE_ZSTD
+  return Decompress(ddict_, in, in_size, out, out_size);
+#else
   return true;
+#endif
 }
 
 
-bool CompressorZstd::Decompress(const fun::vector<uint8_t> &in, fun::vector<uint8_t> &out)
+bool CompressorZstd::Decompress(const uint32_t dict_id,
+                                const uint8_t *in, const size_t in_size,
+                                uint8_t *out, const size_t out_size)
 {
 #if FUNAPI_HAVE_ZSTD
-  size_t expected_size = out.size();
+  auto iter = dicts_.find(dict_id);
+  if (iter == dicts_.cend()) {
+    DebugUtils::Log("Unknown zstd dictionary id: %u", dict_id);
+    return false;
+  }
 
-  size_t out_size = 0;
-  ::ZSTD_DCtx *ctxt = ::ZSTD_createDCtx();
+  return Decompress(iter->second.ddict, in, in_size, out, out_size);
+#else
+  return false;
+#endif
+}
+
+
+#if FUNAPI_HAVE_ZSTD
+bool CompressorZstd::Decompress(const ::ZSTD_DDict *ddict,
+                                const uint8_t *in, const size_t in_size,
+                                uint8_t *out, const size_t out_size)
+{
+  size_t decompressed_size = 0;
+  CompressorContextPool<::ZSTD_DCtx>::ScopedContext context(dctxs_);
+  ::ZSTD_DCtx *ctxt = context.Get();
   if (!ctxt) {
     DebugUtils::Log("Cannot allocate ZSTD_DCtx");
     return false;
   }
 
-  if (expected_size == 0 || expected_size >= kZstdMinBlock) {
-    out_size = DoDecompress(ctxt,
-                            out.data(),
-                            expected_size,
-                            in.data(),
-                            in.size());
+  if (out_size == 0 || out_size >= kZstdMinBlock) {
+    decompressed_size = DoDecompress(ctxt,
+                                     ddict,
+                                     out,
+                                     out_size,
+                                     in,
+                                     in_size);
   } else {
-    out_size = DoDecompressSmall(ctxt,
-                                 out.data(),
-                                 expected_size,
-                                 in.data(),
-                                 in.size());
+    decompressed_size = DoDecompressSmall(ctxt,
+                                          ddict,
+                                          out,
+                                          out_size,
+                                          in,
+                                          in_size);
+  }
+
+  return (decompressed_size == out_size);
+}
+#endif
+
+
+bool CompressorZstd::CompressStream(const uint8_t *in, const size_t in_size,
+                                    fun::vector<uint8_t> &out, const size_t out_offset)
+{
+#if FUNAPI_HAVE_ZSTD
+  if (cstream_ == NULL) {
+    cstream_ = ::ZSTD_createCStream();
+    if (cstream_ == NULL) {
+      DebugUtils::Log("Cannot allocate ZSTD_CStream.");
+      return false;
+    }
+
+    const size_t rv = cdict_ ? ::ZSTD_initCStream_usingCDict(cstream_, cdict_)
+                             : ::ZSTD_initCStream(cstream_, kZstdCompressionLevel);
+    if (::ZSTD_isError(rv)) {
+      DebugUtils::Log("%s: %s", __func__, ::ZSTD_getErrorName(rv));
+      ::ZSTD_freeCStream(cstream_);
+      cstream_ = NULL;
+      return false;
+    }
+  }
+
+  // 첫 메시지에는 프레임 헤더가 붙는다.
+  out.resize(out_offset + ZSTD_compressBound(in_size) + ZSTD_FRAMEHEADERSIZE_MAX);
+
+  ::ZSTD_inBuffer input = { in, in_size, 0 };
+  ::ZSTD_outBuffer output = { out.data() + out_offset, out.size() - out_offset, 0 };
+
+  auto grow = [&out, &output, out_offset]() {
+    out.resize(out.size() * 2);
+    output.dst = out.data() + out_offset;
+    output.size = out.size() - out_offset;
+  };
+
+  while (input.pos < input.size) {
+    const size_t rv = ::ZSTD_compressStream(cstream_, &output, &input);
+    if (::ZSTD_isError(rv)) {
+      DebugUtils::Log("%s: %s", __func__, ::ZSTD_getErrorName(rv));
+      return false;
+    }
+
+    if (output.pos == output.size) {
+      grow();
+    }
+  }
+
+  while (true) {
+    const size_t remaining = ::ZSTD_flushStream(cstream_, &output);
+    if (::ZSTD_isError(remaining)) {
+      DebugUtils::Log("%s: %s", __func__, ::ZSTD_getErrorName(remaining));
+      return false;
+    }
+
+    if (remaining == 0) {
+      break;
+    }
+
+    grow();
+  }
+
+  out.resize(out_offset + output.pos);
+#endif
+
+  return true;
+}
+
+
+bool CompressorZstd::DecompressStream(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size)
+{
+#if FUNAPI_HAVE_ZSTD
+  if (dstream_ == NULL) {
+    dstream_ = ::ZSTD_createDStream();
+    if (dstream_ == NULL) {
+      DebugUtils::Log("Cannot allocate ZSTD_DStream.");
+      return false;
+    }
+
+    const size_t rv = ddict_ ? ::ZSTD_initDStream_usingDDict(dstream_, ddict_)
+                             : ::ZSTD_initDStream(dstream_);
+    if (::ZSTD_isError(rv)) {
+      DebugUtils::Log("%s: %s", __func__, ::ZSTD_getErrorName(rv));
+      ::ZSTD_freeDStream(dstream_);
+      dstream_ = NULL;
+      return false;
+    }
+  }
+
+  ::ZSTD_inBuffer input = { in, in_size, 0 };
+  ::ZSTD_outBuffer output = { out, out_size, 0 };
+
+  while (input.pos < input.size) {
+    const size_t in_pos = input.pos;
+    const size_t out_pos = output.pos;
+
+    const size_t rv = ::ZSTD_decompressStream(dstream_, &output, &input);
+    if (::ZSTD_isError(rv)) {
+      DebugUtils::Log("%s: %s", __func__, ::ZSTD_getErrorName(rv));
+      return false;
+    }
+
+    if (input.pos == in_pos && output.pos == out_pos) {
+      // 압축 전 길이보다 많은 데이터가 들어 있다.
+      DebugUtils::Log("%s: The uncompressed length does not match.", __func__);
+      return false;
+    }
   }
-  ::ZSTD_freeDCtx(ctxt);
 
-  return (out.size() == expected_size);
+  return (output.pos == out_size);
 #else
   return true;
 #endif
 }
 
 
-void CompressorZstd::SetDictBase64String(const fun::string &zstd_dict_base64string) {
+void CompressorZstd::ResetStream() {
 #if FUNAPI_HAVE_ZSTD
+  if (cstream_) {
+    ::ZSTD_freeCStream(cstream_);
+    cstream_ = NULL;
+  }
+
+  if (dstream_) {
+    ::ZSTD_freeDStream(dstream_);
+    dstream_ = NULL;
+  }
+#endif
+}
+
+
+void CompressorZstd::SetDictBase64String(const fun::string &zstd_dict_base64string) {
   fun::vector<uint8_t> dict_buf;
   if (false == FunapiUtil::DecodeBase64(zstd_dict_base64string, dict_buf)) {
     DebugUtils::Log("Cannot decode zstd_dict");
   }
 
+  SetDict(dict_buf);
+}
+
+
+void CompressorZstd::SetDict(const fun::vector<uint8_t> &dict_buf) {
+#if FUNAPI_HAVE_ZSTD
+  // 스트림은 사전을 참조하므로 같이 버린다.
+  ResetStream();
+  Cleanup();
+
   cdict_ = ::ZSTD_createCDict(dict_buf.data(), dict_buf.size(), kZstdCompressionLevel);
   ddict_ = ::ZSTD_createDDict(dict_buf.data(), dict_buf.size());
 
@@ -415,11 +929,332 @@ void CompressorZstd::SetDictBase64String(const fun::string &zstd_dict_base64stri
 }
 
 
-////////////////////////////////////////////////////////////////////////////////
-// Compressor implementation.
-// Factory
+uint32_t CompressorZstd::AddDict(const fun::vector<uint8_t> &dict_buf) {
+#if FUNAPI_HAVE_ZSTD
+  // 학습으로 만든 사전에만 사전 ID 가 있다. 내용만 있는 사전은 SetDict() 로 설정한다.
+  const uint32_t dict_id = ::ZSTD_getDictID_fromDict(dict_buf.data(), dict_buf.size());
+  if (dict_id == 0) {
+    DebugUtils::Log("The zstd dictionary has no dictionary id.");
+    return 0;
+  }
 
-std::shared_ptr<Compressor> Compressor::Create(CompressionType type) {
+  if (HasDict(dict_id)) {
+    return dict_id;
+  }
+
+  Dict dict;
+  dict.cdict = ::ZSTD_createCDict(dict_buf.data(), dict_buf.size(), kZstdCompressionLevel);
+  dict.ddict = ::ZSTD_createDDict(dict_buf.data(), dict_buf.size());
+  if (dict.cdict == NULL || dict.ddict == NULL) {
+    DebugUtils::Log("Failed to load zstd dictionary object. id: %u", dict_id);
+    ::ZSTD_freeCDict(dict.cdict);
+    ::ZSTD_freeDDict(dict.ddict);
+    return 0;
+  }
+
+  dicts_[dict_id] = dict;
+
+  return dict_id;
+#else
+  return 0;
+#endif
+}
+
+
+bool CompressorZstd::HasDict(const uint32_t dict_id) {
+#if FUNAPI_HAVE_ZSTD
+  return dicts_.find(dict_id) != dicts_.cend();
+#else
+  return false;
+#endif
+}
+
+
+#if FUNAPI_HAVE_LZ4
+////////////////////////////////////////////////////////////////////////////////
+// CompressorLz4 implementation.
+
+// NOTE: LZ4 는 압축률은 zstd 보다 낮지만 압축과 해제가 몇 배 빨라서 지연에 민감한 트랜스포트에 쓴다.
+// 블록 형식만 사용하므로 프레임 헤더가 붙지 않고, 압축 전 길이는 헤더의 C 필드로 전달된다.
+class CompressorLz4 : public Compressor
+{
+ public:
+  CompressorLz4();
+  virtual ~CompressorLz4();
+
+  CompressionType GetCompressionType();
+
+  bool Compress(const uint8_t *in, const size_t in_size,
+                fun::vector<uint8_t> &out, const size_t out_offset);
+  bool Decompress(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size);
+
+  bool CompressStream(const uint8_t *in, const size_t in_size,
+                      fun::vector<uint8_t> &out, const size_t out_offset);
+  bool DecompressStream(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size);
+  void ResetStream();
+
+  void SetDictBase64String(const fun::string &lz4_dict_base64string);
+
+ private:
+  // LZ4 는 최근 64KB 까지만 참조한다.
+  static const int kLz4DictSize = 64 * 1024;
+  static const int kLz4StreamBufferSize = 2 * kLz4DictSize;
+  static const int kLz4Acceleration = 1;
+
+  // 압축 상태는 16KB 정도이므로 재사용한다.
+  CompressorContextPool<::LZ4_stream_t> streams_;
+
+  // 사전은 LZ4_loadDict 로 한 번만 읽어 두고 메시지마다 상태를 복사해서 쓴다.
+  fun::vector<uint8_t> dict_;
+  ::LZ4_stream_t *dict_stream_ = NULL;
+
+  // 스트림 압축은 보낼 메시지를 cstream_buffer_ 에 이어서 복사한 뒤 압축해서
+  // 다음 메시지가 최근 64KB 를 참조할 수 있게 한다. 버퍼가 차면 마지막 64KB 만 앞으로 옮긴다.
+  // 받는 쪽은 해제한 메시지를 dstream_history_ 뒤에 붙이고 마지막 64KB 를 사전으로 쓴다.
+  ::LZ4_stream_t *cstream_ = NULL;
+  fun::vector<uint8_t> cstream_buffer_;
+  int cstream_buffer_pos_ = 0;
+  fun::vector<uint8_t> dstream_history_;
+  bool dstream_started_ = false;
+};
+
+
+CompressorLz4::CompressorLz4()
+  : streams_([]() { return ::LZ4_createStream(); },
+             [](::LZ4_stream_t *stream) { ::LZ4_freeStream(stream); })
+{
+}
+
+
+CompressorLz4::~CompressorLz4()
+{
+  ResetStream();
+
+  if (dict_stream_) {
+    ::LZ4_freeStream(dict_stream_);
+    dict_stream_ = NULL;
+  }
+}
+
+
+CompressionType CompressorLz4::GetCompressionType()
+{
+  return CompressionType::kLz4;
+}
+
+
+bool CompressorLz4::Compress(const uint8_t *in, const size_t in_size,
+                             fun::vector<uint8_t> &out, const size_t out_offset)
+{
+  if (in_size > LZ4_MAX_INPUT_SIZE) {
+    return false;
+  }
+
+  CompressorContextPool<::LZ4_stream_t>::ScopedContext context(streams_);
+  ::LZ4_stream_t *stream = context.Get();
+  if (!stream) {
+    DebugUtils::Log("Cannot allocate LZ4_stream_t.");
+    return false;
+  }
+
+  const int max_size = ::LZ4_compressBound(static_cast<int>(in_size));
+  out.resize(out_offset + max_size);
+
+  int compressed_size = 0;
+  if (dict_stream_) {
+    memcpy(stream, dict_stream_, sizeof(::LZ4_stream_t));
+    compressed_size = ::LZ4_compress_fast_continue(stream,
+                                                   reinterpret_cast<const char*>(in),
+                                                   reinterpret_cast<char*>(out.data() + out_offset),
+                                                   static_cast<int>(in_size),
+                                                   max_size,
+                                                   kLz4Acceleration);
+  }
+  else {
+    compressed_size = ::LZ4_compress_fast_extState(stream,
+                                                   reinterpret_cast<const char*>(in),
+                                                   reinterpret_cast<char*>(out.data() + out_offset),
+                                                   static_cast<int>(in_size),
+                                                   max_size,
+                                                   kLz4Acceleration);
+  }
+
+  if (compressed_size <= 0 || in_size < static_cast<size_t>(compressed_size)) {
+    return false;
+  }
+
+  out.resize(out_offset + compressed_size);
+
+  return true;
+}
+
+
+bool CompressorLz4::Decompress(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size)
+{
+  int decompressed_size = 0;
+  if (dict_.empty()) {
+    decompressed_size = ::LZ4_decompress_safe(reinterpret_cast<const char*>(in),
+                                              reinterpret_cast<char*>(out),
+                                              static_cast<int>(in_size),
+                                              static_cast<int>(out_size));
+  }
+  else {
+    decompressed_size = ::LZ4_decompress_safe_usingDict(reinterpret_cast<const char*>(in),
+                                                        reinterpret_cast<char*>(out),
+                                                        static_cast<int>(in_size),
+                                                        static_cast<int>(out_size),
+                                                        reinterpret_cast<const char*>(dict_.data()),
+                                                        static_cast<int>(dict_.size()));
+  }
+
+  return (decompressed_size >= 0 && static_cast<size_t>(decompressed_size) == out_size);
+}
+
+
+bool CompressorLz4::CompressStream(const uint8_t *in, const size_t in_size,
+                                   fun::vector<uint8_t> &out, const size_t out_offset)
+{
+  if (in_size > LZ4_MAX_INPUT_SIZE) {
+    return false;
+  }
+
+  if (cstream_ == NULL) {
+    cstream_ = ::LZ4_createStream();
+    if (cstream_ == NULL) {
+      DebugUtils::Log("Cannot allocate LZ4_stream_t.");
+      return false;
+    }
+
+    cstream_buffer_.resize(kLz4StreamBufferSize);
+    cstream_buffer_pos_ = 0;
+    ::LZ4_loadDict(cstream_,
+                   reinterpret_cast<const char*>(dict_.data()),
+                   static_cast<int>(dict_.size()));
+  }
+
+  char *buffer = reinterpret_cast<char*>(cstream_buffer_.data());
+  const int src_size = static_cast<int>(in_size);
+  if (cstream_buffer_pos_ + src_size > kLz4StreamBufferSize) {
+    cstream_buffer_pos_ = ::LZ4_saveDict(cstream_, buffer, kLz4DictSize);
+  }
+
+  // 버퍼에 들어가지 않는 큰 메시지는 그대로 압축하고 끝부분을 버퍼에 남긴다.
+  const bool buffered = (cstream_buffer_pos_ + src_size <= kLz4StreamBufferSize);
+  const char *src = reinterpret_cast<const char*>(in);
+  if (buffered) {
+    memcpy(buffer + cstream_buffer_pos_, in, in_size);
+    src = buffer + cstream_buffer_pos_;
+  }
+
+  const int max_size = ::LZ4_compressBound(src_size);
+  out.resize(out_offset + max_size);
+
+  const int compressed_size = ::LZ4_compress_fast_continue(cstream_,
+                                                           src,
+                                                           reinterpret_cast<char*>(out.data() + out_offset),
+                                                           src_size,
+                                                           max_size,
+                                                           kLz4Acceleration);
+  if (compressed_size <= 0) {
+    // 실패한 뒤의 상태는 쓸 수 없으므로 버린다.
+    ::LZ4_freeStream(cstream_);
+    cstream_ = NULL;
+    return false;
+  }
+
+  if (buffered) {
+    cstream_buffer_pos_ += src_size;
+  }
+  else {
+    cstream_buffer_pos_ = ::LZ4_saveDict(cstream_, buffer, kLz4DictSize);
+  }
+
+  out.resize(out_offset + compressed_size);
+
+  return true;
+}
+
+
+bool CompressorLz4::DecompressStream(const uint8_t *in, const size_t in_size, uint8_t *out, const size_t out_size)
+{
+  if (false == dstream_started_) {
+    dstream_started_ = true;
+    dstream_history_ = dict_;
+  }
+
+  const size_t history_size = (std::min)(dstream_history_.size(), static_cast<size_t>(kLz4DictSize));
+  const char *history = reinterpret_cast<const char*>(dstream_history_.data() + dstream_history_.size() - history_size);
+
+  const int decompressed_size = ::LZ4_decompress_safe_usingDict(reinterpret_cast<const char*>(in),
+                                                                reinterpret_cast<char*>(out),
+                                                                static_cast<int>(in_size),
+                                                                static_cast<int>(out_size),
+                                                                history,
+                                                                static_cast<int>(history_size));
+  if (decompressed_size < 0 || static_cast<size_t>(decompressed_size) != out_size) {
+    return false;
+  }
+
+  // 앞쪽을 메시지마다 지우지 않고 두 배가 넘을 때만 마지막 64KB 를 남긴다.
+  dstream_history_.insert(dstream_history_.end(), out, out + out_size);
+  if (dstream_history_.size() > 2 * kLz4DictSize) {
+    dstream_history_.erase(dstream_history_.begin(), dstream_history_.end() - kLz4DictSize);
+  }
+
+  return true;
+}
+
+
+void CompressorLz4::ResetStream() {
+  if (cstream_) {
+    ::LZ4_freeStream(cstream_);
+    cstream_ = NULL;
+  }
+
+  cstream_buffer_.clear();
+  cstream_buffer_pos_ = 0;
+  dstream_history_.clear();
+  dstream_started_ = false;
+}
+
+
+void CompressorLz4::SetDictBase64String(const fun::string &lz4_dict_base64string) {
+  fun::vector<uint8_t> dict_buf;
+  if (false == FunapiUtil::DecodeBase64(lz4_dict_base64string, dict_buf)) {
+    DebugUtils::Log("Cannot decode lz4_dict");
+    return;
+  }
+
+  // 스트림은 사전을 참조하므로 같이 버린다.
+  ResetStream();
+
+  // 마지막 64KB 만 참조되므로 나머지는 버린다.
+  if (dict_buf.size() > kLz4DictSize) {
+    dict_buf.erase(dict_buf.begin(), dict_buf.end() - kLz4DictSize);
+  }
+  dict_.swap(dict_buf);
+
+  if (dict_stream_ == NULL) {
+    dict_stream_ = ::LZ4_createStream();
+    if (dict_stream_ == NULL) {
+      DebugUtils::Log("Failed to load lz4 dictionary object.");
+      dict_.clear();
+      return;
+    }
+  }
+
+  ::LZ4_loadDict(dict_stream_,
+                 reinterpret_cast<const char*>(dict_.data()),
+                 static_cast<int>(dict_.size()));
+}
+#endif // FUNAPI_HAVE_LZ4
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Compressor implementation.
+// Factory
+
+std::shared_ptr<Compressor> Compressor::Create(CompressionType type) {
 #if FUNAPI_HAVE_ZLIB
   if (type == CompressionType::kDeflate)
     return std::make_shared<CompressorZlib>();
@@ -430,6 +1265,11 @@ std::shared_ptr<Compressor> Compressor::Create(CompressionType type) {
     return std::make_shared<CompressorZstd>();
 #endif
 
+#if FUNAPI_HAVE_LZ4
+  if (type == CompressionType::kLz4)
+    return std::make_shared<CompressorLz4>();
+#endif
+
   return nullptr;
 }
 
@@ -447,23 +1287,109 @@ class FunapiCompressionImpl : public std::enable_shared_from_this<FunapiCompress
   void SetCompressionType(const CompressionType type);
   void SetThreshold(int threshold);
   void SetZstdDictBase64String(const fun::string &zstd_dict_base64string);
+  void SetLz4DictBase64String(const fun::string &lz4_dict_base64string);
+
+  uint32_t AddZstdDictBase64String(const fun::string &zstd_dict_base64string);
+  bool SetZstdDictId(const uint32_t dict_id);
+  uint32_t GetZstdDictId();
+  uint32_t GetLatestZstdDictId();
+
+  void StartCapture(const size_t sample_interval, const size_t max_bytes);
+  void StopCapture();
+  bool IsCapturing();
+  fun::vector<fun::vector<uint8_t>> GetCapturedSamples();
 
   bool Compress(HeaderFields &header_fields, fun::vector<uint8_t> &body);
+  bool Compress(FunapiHeaderWriter &header, fun::vector<uint8_t> &body, const size_t offset,
+                const fun::string &msg_type);
   bool Decompress(HeaderFields &header_fields, fun::vector<uint8_t> &body);
+  bool Decompress(const FunapiHeaderView &header, fun::vector<uint8_t> &body);
+  bool Decompress(const FunapiHeaderView &header,
+                  const uint8_t *in, const size_t in_size,
+                  fun::vector<uint8_t> &out);
 
   void SetHeaderFieldsForHttpSend (HeaderFields &header_fields);
   void SetHeaderFieldsForHttpRecv (HeaderFields &header_fields);
 
   bool HasCompression(const CompressionType type);
 
+  void SetStreaming(const bool streaming);
+  bool IsStreaming();
+  void ResetStream();
+
+  void SetPolicy(const CompressionRule &rule);
+  fun::vector<CompressionStatistics> GetStatistics();
+
  private:
+  // 적응형 정책은 메시지 타입마다 압축률과 압축 시간의 지수 이동 평균을 구해서
+  // 압축률이 kAdaptiveMaxRatioPercent 보다 나쁘거나 절약한 바이트가 압축 시간에 비해 너무 적으면 압축을 쉰다.
+  // 쉬는 동안에도 probe_interval 개마다 한 번씩 압축해서 추정값을 갱신하고,
+  // 계속 효과가 없으면 probe_interval 을 kAdaptiveMaxProbeInterval 까지 늘린다.
+  static const int kAdaptiveMinSamples = 8;
+  static const uint32_t kAdaptiveMinProbeInterval = 64;
+  static const uint32_t kAdaptiveMaxProbeInterval = 1024;
+  static const int kAdaptiveMaxRatioPercent = 90;
+  static const int kAdaptiveMinSavedBytesPerMillisecond = 1000;
+  static const int kAdaptiveSmoothingDivisor = 8;
+
+  struct MessageTypeState {
+    CompressionPolicy policy = CompressionPolicy::kAdaptive;
+    int threshold = -1;
+
+    uint64_t compressed_count = 0;
+    uint64_t not_compressed_count = 0;
+    uint64_t skipped_count = 0;
+    uint64_t original_bytes = 0;
+    uint64_t sent_bytes = 0;
+    uint64_t compress_microseconds = 0;
+
+    int samples = 0;
+    double ratio = 1.0;
+    double saved_bytes = 0;
+    double microseconds = 0;
+
+    bool paused = false;
+    uint32_t probe_interval = kAdaptiveMinProbeInterval;
+    uint32_t skip_remaining = 0;
+  };
+
   bool CreateCompressor(const CompressionType type);
   std::shared_ptr<Compressor> GetCompressor(CompressionType type);
 
+  bool CompressBody(FunapiHeaderWriter &header, fun::vector<uint8_t> &body, const size_t offset);
+  bool IsCompressed(const FunapiHeaderView &header);
+  bool DecompressBody(const FunapiHeaderView &header,
+                      const uint8_t *in, const size_t in_size,
+                      uint8_t *out, const size_t out_size);
+  void Capture(const uint8_t *data, const size_t size);
+  void UpdateEstimate(MessageTypeState &state,
+                      const size_t original_size,
+                      const size_t sent_size,
+                      const bool compressed,
+                      const int64_t microseconds,
+                      const bool is_probe);
+
   fun::map<CompressionType, std::shared_ptr<Compressor>> compressors_;
   std::shared_ptr<Compressor> default_compressor_ = nullptr;
 
   int threshold_ = 128;
+  bool streaming_ = false;
+
+  // GetStatistics() 는 다른 스레드에서 호출할 수 있다.
+  std::mutex msg_types_mutex_;
+  fun::unordered_map<fun::string, MessageTypeState> msg_types_;
+
+  // 보낼 때 쓰는 사전 ID 와 마지막으로 등록한 사전 ID. 0 이면 사전 ID 없는 사전을 쓴다.
+  uint32_t zstd_dict_id_ = 0;
+  uint32_t latest_zstd_dict_id_ = 0;
+
+  // 사전 학습용 표본. 모으지 않을 때는 capture_interval_ 이 0 이다.
+  std::atomic<size_t> capture_interval_{0};
+  std::mutex capture_mutex_;
+  size_t capture_max_bytes_ = 0;
+  size_t capture_bytes_ = 0;
+  size_t capture_count_ = 0;
+  fun::vector<fun::vector<uint8_t>> captured_samples_;
 };
 
 
@@ -505,27 +1431,99 @@ bool FunapiCompressionImpl::CreateCompressor(const CompressionType type) {
 
 bool FunapiCompressionImpl::Decompress(HeaderFields &header_fields,
                                        fun::vector<uint8_t> &body) {
-  if (default_compressor_) {
-    HeaderFields::iterator it;
-    it = header_fields.find(kProtocolCompressionField);
-    if (it != header_fields.end()) {
-      size_t body_length = atoi(it->second.c_str());
-      if (body_length > 0) {
-        fun::vector<uint8_t> in(body.cbegin(), body.cend());
-        body.resize(body_length);
-        return default_compressor_->Decompress(in, body);
-      }
+  FunapiHeaderView header;
+  header.AddProtocolFields(header_fields);
+
+  return Decompress(header, body);
+}
+
+
+bool FunapiCompressionImpl::Decompress(const FunapiHeaderView &header,
+                                       fun::vector<uint8_t> &body) {
+  if (false == IsCompressed(header)) {
+    if (capture_interval_ > 0) {
+      Capture(body.data(), body.size());
     }
+
+    return true;
+  }
+
+  fun::vector<uint8_t> out;
+  const bool ret = Decompress(header, body.data(), body.size(), out);
+  body.swap(out);
+
+  return ret;
+}
+
+
+bool FunapiCompressionImpl::Decompress(const FunapiHeaderView &header,
+                                       const uint8_t *in, const size_t in_size,
+                                       fun::vector<uint8_t> &out) {
+  if (false == IsCompressed(header)) {
+    out.reserve(in_size + 1);
+    out.assign(in, in + in_size);
+  }
+  else {
+    const size_t out_size = header.GetUncompressedLength();
+    out.reserve(out_size + 1);
+    out.resize(out_size);
+    if (false == DecompressBody(header, in, in_size, out.data(), out_size)) {
+      return false;
+    }
+  }
+
+  if (capture_interval_ > 0) {
+    Capture(out.data(), out.size());
   }
 
   return true;
 }
 
 
+bool FunapiCompressionImpl::IsCompressed(const FunapiHeaderView &header) {
+  if (header.GetUncompressedLength() == 0) {
+    return false;
+  }
+
+#if FUNAPI_HAVE_ZSTD
+  if (header.GetDictionaryId() != 0) {
+    return true;
+  }
+#endif
+
+  return (default_compressor_ != nullptr);
+}
+
+
+bool FunapiCompressionImpl::DecompressBody(const FunapiHeaderView &header,
+                                           const uint8_t *in, const size_t in_size,
+                                           uint8_t *out, const size_t out_size) {
+#if FUNAPI_HAVE_ZSTD
+  // 사전 ID 가 있으면 그 사전으로 압축한 zstd 메시지이다.
+  if (header.GetDictionaryId() != 0) {
+    std::shared_ptr<Compressor> c = GetCompressor(CompressionType::kZstd);
+    if (!c) {
+      DebugUtils::Log("Received a message compressed with a zstd dictionary, but zstd is not set.");
+      return false;
+    }
+
+    return std::static_pointer_cast<CompressorZstd>(c)->Decompress(header.GetDictionaryId(),
+                                                                   in, in_size, out, out_size);
+  }
+#endif
+
+  if (header.IsStreamCompressed()) {
+    return default_compressor_->DecompressStream(in, in_size, out, out_size);
+  }
+
+  return default_compressor_->Decompress(in, in_size, out, out_size);
+}
+
+
 bool FunapiCompressionImpl::Compress(HeaderFields &header_fields, fun::vector<uint8_t> &body) {
   if (default_compressor_ && (body.size() >= threshold_)) {
     fun::vector<uint8_t> in(body.cbegin(), body.cend());
-    if (default_compressor_->Compress(in, body)) {
+    if (default_compressor_->Compress(in.data(), in.size(), body, 0)) {
       HeaderFields::iterator it = header_fields.find(kLengthHeaderField);
       if (it != header_fields.end()) {
         header_fields[kProtocolCompressionField] = it->second.c_str();
@@ -545,6 +1543,255 @@ bool FunapiCompressionImpl::Compress(HeaderFields &header_fields, fun::vector<ui
 }
 
 
+bool FunapiCompressionImpl::Compress(FunapiHeaderWriter &header,
+                                     fun::vector<uint8_t> &body,
+                                     const size_t offset,
+                                     const fun::string &msg_type) {
+  const size_t body_size = body.size() - offset;
+  if (capture_interval_ > 0) {
+    Capture(body.data() + offset, body_size);
+  }
+
+  if (!default_compressor_) {
+    return true;
+  }
+
+  bool is_probe = false;
+  {
+    std::unique_lock<std::mutex> lock(msg_types_mutex_);
+    MessageTypeState &state = msg_types_[msg_type];
+
+    const int threshold = state.threshold >= 0 ? state.threshold : threshold_;
+    if (body_size < threshold) {
+      return true;
+    }
+
+    if (state.policy == CompressionPolicy::kNever) {
+      ++state.skipped_count;
+      return true;
+    }
+
+    if (state.policy == CompressionPolicy::kAdaptive && state.paused) {
+      if (state.skip_remaining > 0) {
+        --state.skip_remaining;
+        ++state.skipped_count;
+        return true;
+      }
+
+      is_probe = true;
+    }
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const bool compressed = CompressBody(header, body, offset);
+  const int64_t microseconds = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+
+  {
+    std::unique_lock<std::mutex> lock(msg_types_mutex_);
+    UpdateEstimate(msg_types_[msg_type],
+                   body_size,
+                   body.size() - offset,
+                   compressed,
+                   microseconds,
+                   is_probe);
+  }
+
+  return compressed;
+}
+
+
+bool FunapiCompressionImpl::CompressBody(FunapiHeaderWriter &header,
+                                         fun::vector<uint8_t> &body,
+                                         const size_t offset) {
+  fun::vector<uint8_t> in(body.cbegin() + offset, body.cend());
+  if (streaming_) {
+    if (default_compressor_->CompressStream(in.data(), in.size(), body, offset)) {
+      header.SetUncompressedLength(header.GetLength());
+      header.SetStreamCompressed(true);
+      header.SetLength(body.size() - offset);
+      return true;
+    }
+
+    // 실패한 메시지가 스트림에 남아 있을 수 있으므로 이 연결에서는 메시지 단위로 압축한다.
+    DebugUtils::Log("Failed to compress stream. Falling back to per-message compression.");
+    streaming_ = false;
+    body.resize(offset);
+    body.insert(body.end(), in.cbegin(), in.cend());
+  }
+
+#if FUNAPI_HAVE_ZSTD
+  // 사전 ID 로 고른 사전은 받는 쪽이 알 수 있도록 헤더에 사전 ID 를 붙인다.
+  if (zstd_dict_id_ != 0 && default_compressor_->GetCompressionType() == CompressionType::kZstd) {
+    auto zstd_compressor = std::static_pointer_cast<CompressorZstd>(default_compressor_);
+    if (zstd_compressor->Compress(zstd_dict_id_, in.data(), in.size(), body, offset)) {
+      if (header.AddField(kCompressionDictionaryField, zstd_dict_id_)) {
+        header.SetUncompressedLength(header.GetLength());
+        header.SetLength(body.size() - offset);
+        return true;
+      }
+    }
+
+    body.resize(offset);
+    body.insert(body.end(), in.cbegin(), in.cend());
+  }
+#endif
+
+  if (default_compressor_->Compress(in.data(), in.size(), body, offset)) {
+    header.SetUncompressedLength(header.GetLength());
+    header.SetLength(body.size() - offset);
+    return true;
+  }
+
+  body.resize(offset);
+  body.insert(body.end(), in.cbegin(), in.cend());
+  return false;
+}
+
+
+void FunapiCompressionImpl::Capture(const uint8_t *data, const size_t size) {
+  std::unique_lock<std::mutex> lock(capture_mutex_);
+  const size_t interval = capture_interval_;
+  if (interval == 0 || (capture_count_++ % interval) != 0) {
+    return;
+  }
+
+  if (capture_bytes_ + size > capture_max_bytes_) {
+    capture_interval_ = 0;
+    DebugUtils::Log("Compression capture finished. samples: %d, bytes: %d",
+                    static_cast<int>(captured_samples_.size()),
+                    static_cast<int>(capture_bytes_));
+    return;
+  }
+
+  captured_samples_.emplace_back(data, data + size);
+  capture_bytes_ += size;
+}
+
+
+void FunapiCompressionImpl::StartCapture(const size_t sample_interval, const size_t max_bytes) {
+  std::unique_lock<std::mutex> lock(capture_mutex_);
+  captured_samples_.clear();
+  capture_max_bytes_ = max_bytes;
+  capture_bytes_ = 0;
+  capture_count_ = 0;
+  capture_interval_ = (sample_interval > 0) ? sample_interval : 1;
+}
+
+
+void FunapiCompressionImpl::StopCapture() {
+  capture_interval_ = 0;
+}
+
+
+bool FunapiCompressionImpl::IsCapturing() {
+  return capture_interval_ > 0;
+}
+
+
+fun::vector<fun::vector<uint8_t>> FunapiCompressionImpl::GetCapturedSamples() {
+  std::unique_lock<std::mutex> lock(capture_mutex_);
+  return captured_samples_;
+}
+
+
+void FunapiCompressionImpl::UpdateEstimate(MessageTypeState &state,
+                                           const size_t original_size,
+                                           const size_t sent_size,
+                                           const bool compressed,
+                                           const int64_t microseconds,
+                                           const bool is_probe) {
+  if (compressed) {
+    ++state.compressed_count;
+  }
+  else {
+    ++state.not_compressed_count;
+  }
+  state.original_bytes += original_size;
+  state.sent_bytes += sent_size;
+  state.compress_microseconds += microseconds;
+
+  const double ratio = static_cast<double>(sent_size) / original_size;
+  const double saved_bytes = static_cast<double>(original_size) - sent_size;
+
+  // 쉬는 동안의 추정값은 오래된 값이므로 확인용 압축 결과로 바꾼다.
+  if (state.samples == 0 || is_probe) {
+    state.ratio = ratio;
+    state.saved_bytes = saved_bytes;
+    state.microseconds = static_cast<double>(microseconds);
+  }
+  else {
+    state.ratio += (ratio - state.ratio) / kAdaptiveSmoothingDivisor;
+    state.saved_bytes += (saved_bytes - state.saved_bytes) / kAdaptiveSmoothingDivisor;
+    state.microseconds += (microseconds - state.microseconds) / kAdaptiveSmoothingDivisor;
+  }
+  ++state.samples;
+
+  if (state.policy != CompressionPolicy::kAdaptive || state.samples < kAdaptiveMinSamples) {
+    return;
+  }
+
+  // 측정된 시간이 0 이면 타이머 해상도보다 빠른 것이므로 시간 조건은 만족한 것으로 본다.
+  const bool pays_off = state.ratio * 100 <= kAdaptiveMaxRatioPercent &&
+      (state.microseconds <= 0 ||
+       state.saved_bytes * 1000 / state.microseconds >= kAdaptiveMinSavedBytesPerMillisecond);
+
+  if (pays_off) {
+    state.paused = false;
+    state.probe_interval = kAdaptiveMinProbeInterval;
+    state.skip_remaining = 0;
+    return;
+  }
+
+  if (state.paused) {
+    state.probe_interval *= 2;
+    if (state.probe_interval > kAdaptiveMaxProbeInterval) {
+      state.probe_interval = kAdaptiveMaxProbeInterval;
+    }
+  }
+  state.paused = true;
+  state.skip_remaining = state.probe_interval;
+}
+
+
+void FunapiCompressionImpl::SetPolicy(const CompressionRule &rule) {
+  std::unique_lock<std::mutex> lock(msg_types_mutex_);
+  MessageTypeState &state = msg_types_[rule.msg_type];
+  state.policy = rule.policy;
+  state.threshold = rule.threshold;
+  state.paused = false;
+  state.probe_interval = kAdaptiveMinProbeInterval;
+  state.skip_remaining = 0;
+}
+
+
+fun::vector<CompressionStatistics> FunapiCompressionImpl::GetStatistics() {
+  fun::vector<CompressionStatistics> statistics;
+
+  std::unique_lock<std::mutex> lock(msg_types_mutex_);
+  statistics.reserve(msg_types_.size());
+  for (auto &iter : msg_types_) {
+    const MessageTypeState &state = iter.second;
+
+    CompressionStatistics s;
+    s.msg_type = iter.first;
+    s.policy = state.policy;
+    s.compressed_count = state.compressed_count;
+    s.not_compressed_count = state.not_compressed_count;
+    s.skipped_count = state.skipped_count;
+    s.original_bytes = state.original_bytes;
+    s.sent_bytes = state.sent_bytes;
+    s.compress_microseconds = state.compress_microseconds;
+    s.ratio = state.ratio;
+    s.paused = state.paused;
+
+    statistics.push_back(s);
+  }
+
+  return statistics;
+}
+
+
 void FunapiCompressionImpl::SetHeaderFieldsForHttpSend (HeaderFields &header_fields) {
   HeaderFields::const_iterator it = header_fields.find(kProtocolCompressionField);
   if (it != header_fields.end()) {
@@ -584,6 +1831,24 @@ bool FunapiCompressionImpl::HasCompression(const CompressionType type) {
 }
 
 
+void FunapiCompressionImpl::SetStreaming(const bool streaming) {
+  streaming_ = streaming;
+}
+
+
+bool FunapiCompressionImpl::IsStreaming() {
+  return streaming_;
+}
+
+
+void FunapiCompressionImpl::ResetStream() {
+  streaming_ = false;
+  for (auto &iter : compressors_) {
+    iter.second->ResetStream();
+  }
+}
+
+
 void FunapiCompressionImpl::SetZstdDictBase64String(const fun::string &zstd_dict_base64string) {
 #if FUNAPI_HAVE_ZSTD
   if (zstd_dict_base64string.length() > 0) {
@@ -601,6 +1866,79 @@ void FunapiCompressionImpl::SetZstdDictBase64String(const fun::string &zstd_dict
 }
 
 
+uint32_t FunapiCompressionImpl::AddZstdDictBase64String(const fun::string &zstd_dict_base64string) {
+#if FUNAPI_HAVE_ZSTD
+  fun::vector<uint8_t> dict_buf;
+  if (false == FunapiUtil::DecodeBase64(zstd_dict_base64string, dict_buf)) {
+    DebugUtils::Log("Cannot decode zstd_dict");
+    return 0;
+  }
+
+  if (false == HasCompression(CompressionType::kZstd)) {
+    SetCompressionType(CompressionType::kZstd);
+  }
+
+  std::shared_ptr<Compressor> c = GetCompressor(CompressionType::kZstd);
+  if (!c) {
+    return 0;
+  }
+
+  const uint32_t dict_id = std::static_pointer_cast<CompressorZstd>(c)->AddDict(dict_buf);
+  if (dict_id != 0) {
+    latest_zstd_dict_id_ = dict_id;
+  }
+
+  return dict_id;
+#else
+  return 0;
+#endif
+}
+
+
+bool FunapiCompressionImpl::SetZstdDictId(const uint32_t dict_id) {
+#if FUNAPI_HAVE_ZSTD
+  if (dict_id != 0) {
+    std::shared_ptr<Compressor> c = GetCompressor(CompressionType::kZstd);
+    if (!c || false == std::static_pointer_cast<CompressorZstd>(c)->HasDict(dict_id)) {
+      return false;
+    }
+  }
+
+  zstd_dict_id_ = dict_id;
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+uint32_t FunapiCompressionImpl::GetZstdDictId() {
+  return zstd_dict_id_;
+}
+
+
+uint32_t FunapiCompressionImpl::GetLatestZstdDictId() {
+  return latest_zstd_dict_id_;
+}
+
+
+void FunapiCompressionImpl::SetLz4DictBase64String(const fun::string &lz4_dict_base64string) {
+#if FUNAPI_HAVE_LZ4
+  if (lz4_dict_base64string.length() > 0) {
+    if (false == HasCompression(CompressionType::kLz4)) {
+      SetCompressionType(CompressionType::kLz4);
+    }
+
+    std::shared_ptr<Compressor> c = GetCompressor(CompressionType::kLz4);
+    if (c) {
+      std::shared_ptr<CompressorLz4> lz4_compressor = std::static_pointer_cast<CompressorLz4>(c);
+      lz4_compressor->SetDictBase64String(lz4_dict_base64string);
+    }
+  }
+#endif
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // FunapiCompression implementation.
 
@@ -631,16 +1969,181 @@ void FunapiCompression::SetZstdDictBase64String(const fun::string &zstd_dict_bas
 #endif
 
 
+#if FUNAPI_HAVE_LZ4
+void FunapiCompression::SetLz4DictBase64String(const fun::string &lz4_dict_base64string) {
+  return impl_->SetLz4DictBase64String(lz4_dict_base64string);
+}
+#endif
+
+
+#if FUNAPI_HAVE_ZSTD
+uint32_t FunapiCompression::AddZstdDictBase64String(const fun::string &zstd_dict_base64string) {
+  return impl_->AddZstdDictBase64String(zstd_dict_base64string);
+}
+
+
+bool FunapiCompression::SetZstdDictId(const uint32_t dict_id) {
+  return impl_->SetZstdDictId(dict_id);
+}
+
+
+uint32_t FunapiCompression::GetZstdDictId() {
+  return impl_->GetZstdDictId();
+}
+
+
+uint32_t FunapiCompression::GetLatestZstdDictId() {
+  return impl_->GetLatestZstdDictId();
+}
+#endif
+
+
+#if FUNAPI_HAVE_ZSTD && FUNAPI_HAVE_ZDICT
+bool FunapiCompression::TrainZstdDictionary(const fun::vector<fun::vector<uint8_t>> &samples,
+                                            const size_t dict_capacity,
+                                            const uint32_t dict_id,
+                                            fun::string &zstd_dict_base64string,
+                                            ZstdDictionaryReport &report) {
+  static const size_t kTestSampleInterval = 10;
+
+  // ZDICT_trainFromBuffer 는 표본을 이어 붙인 버퍼와 표본 크기 목록을 받는다.
+  fun::vector<uint8_t> train_buffer;
+  fun::vector<size_t> train_sizes;
+  fun::vector<const fun::vector<uint8_t>*> test_samples;
+  for (size_t i = 0; i < samples.size(); ++i) {
+    if (i % kTestSampleInterval == kTestSampleInterval - 1) {
+      test_samples.push_back(&samples[i]);
+    }
+    else {
+      train_buffer.insert(train_buffer.end(), samples[i].cbegin(), samples[i].cend());
+      train_sizes.push_back(samples[i].size());
+    }
+  }
+
+  if (train_sizes.empty()) {
+    DebugUtils::Log("No samples to train a zstd dictionary.");
+    return false;
+  }
+
+  // 표본이 적으면 학습한 표본으로 압축률을 잰다.
+  if (test_samples.empty()) {
+    for (auto &sample : samples) {
+      test_samples.push_back(&sample);
+    }
+  }
+
+  fun::vector<uint8_t> dict_buf(dict_capacity);
+  const size_t dict_size = ::ZDICT_trainFromBuffer(dict_buf.data(),
+                                                   dict_buf.size(),
+                                                   train_buffer.data(),
+                                                   train_sizes.data(),
+                                                   static_cast<unsigned>(train_sizes.size()));
+  if (::ZDICT_isError(dict_size)) {
+    DebugUtils::Log("Failed to train a zstd dictionary: %s", ::ZDICT_getErrorName(dict_size));
+    return false;
+  }
+  dict_buf.resize(dict_size);
+
+  // 사전 형식은 4 바이트 매직 넘버 뒤에 little endian 사전 ID 가 온다.
+  if (dict_id != 0) {
+    for (int i = 0; i < 4; ++i) {
+      dict_buf[4 + i] = static_cast<uint8_t>((dict_id >> (8 * i)) & 0xff);
+    }
+  }
+
+  CompressorZstd without_dict;
+  CompressorZstd with_dict;
+  with_dict.SetDict(dict_buf);
+
+  size_t original_bytes = 0;
+  size_t without_dict_bytes = 0;
+  size_t with_dict_bytes = 0;
+  fun::vector<uint8_t> out;
+  for (auto sample : test_samples) {
+    original_bytes += sample->size();
+
+    out.clear();
+    without_dict_bytes += without_dict.Compress(sample->data(), sample->size(), out, 0) ? out.size() : sample->size();
+
+    out.clear();
+    with_dict_bytes += with_dict.Compress(sample->data(), sample->size(), out, 0) ? out.size() : sample->size();
+  }
+
+  report.dict_id = ::ZDICT_getDictID(dict_buf.data(), dict_buf.size());
+  report.dict_size = dict_buf.size();
+  report.train_sample_count = train_sizes.size();
+  report.test_sample_count = test_samples.size();
+  report.ratio_without_dict = original_bytes ? static_cast<double>(without_dict_bytes) / original_bytes : 1.0;
+  report.ratio_with_dict = original_bytes ? static_cast<double>(with_dict_bytes) / original_bytes : 1.0;
+
+  zstd_dict_base64string = FunapiUtil::EncodeBase64(dict_buf);
+
+  DebugUtils::Log("Trained a zstd dictionary. id: %u, size: %d, ratio: %.3f -> %.3f",
+                  report.dict_id,
+                  static_cast<int>(report.dict_size),
+                  report.ratio_without_dict,
+                  report.ratio_with_dict);
+
+  return true;
+}
+#endif
+
+
+void FunapiCompression::StartCapture(const size_t sample_interval, const size_t max_bytes) {
+  impl_->StartCapture(sample_interval, max_bytes);
+}
+
+
+void FunapiCompression::StopCapture() {
+  impl_->StopCapture();
+}
+
+
+bool FunapiCompression::IsCapturing() {
+  return impl_->IsCapturing();
+}
+
+
+fun::vector<fun::vector<uint8_t>> FunapiCompression::GetCapturedSamples() {
+  return impl_->GetCapturedSamples();
+}
+
+
 bool FunapiCompression::Compress(HeaderFields &header_fields, fun::vector<uint8_t> &body) {
   return impl_->Compress(header_fields, body);
 }
 
 
+bool FunapiCompression::Compress(FunapiHeaderWriter &header, fun::vector<uint8_t> &body, const size_t offset) {
+  return impl_->Compress(header, body, offset, "");
+}
+
+
+bool FunapiCompression::Compress(FunapiHeaderWriter &header,
+                                 fun::vector<uint8_t> &body,
+                                 const size_t offset,
+                                 const fun::string &msg_type) {
+  return impl_->Compress(header, body, offset, msg_type);
+}
+
+
 bool FunapiCompression::Decompress(HeaderFields &header_fields, fun::vector<uint8_t> &body) {
   return impl_->Decompress(header_fields, body);
 }
 
 
+bool FunapiCompression::Decompress(const FunapiHeaderView &header, fun::vector<uint8_t> &body) {
+  return impl_->Decompress(header, body);
+}
+
+
+bool FunapiCompression::Decompress(const FunapiHeaderView &header,
+                                   const uint8_t *in, const size_t in_size,
+                                   fun::vector<uint8_t> &out) {
+  return impl_->Decompress(header, in, in_size, out);
+}
+
+
 void FunapiCompression::SetHeaderFieldsForHttpSend (HeaderFields &header_fields) {
   return impl_->SetHeaderFieldsForHttpSend(header_fields);
 }
@@ -655,4 +2158,29 @@ bool FunapiCompression::HasCompression(const CompressionType type) {
   return impl_->HasCompression(type);
 }
 
+
+void FunapiCompression::SetStreaming(const bool streaming) {
+  impl_->SetStreaming(streaming);
+}
+
+
+bool FunapiCompression::IsStreaming() {
+  return impl_->IsStreaming();
+}
+
+
+void FunapiCompression::ResetStream() {
+  impl_->ResetStream();
+}
+
+
+void FunapiCompression::SetPolicy(const CompressionRule &rule) {
+  impl_->SetPolicy(rule);
+}
+
+
+fun::vector<CompressionStatistics> FunapiCompression::GetStatistics() {
+  return impl_->GetStatistics();
+}
+
 }  // namespace fun
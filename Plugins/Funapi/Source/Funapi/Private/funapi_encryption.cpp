@@ -12,6 +12,7 @@
 
 #include "funapi_utils.h"
 #include "funapi_session.h"
+#include "funapi_header_view.h"
 
 #if FUNAPI_HAVE_SODIUM
 #define SODIUM_STATIC
@@ -27,9 +28,6 @@
 // http header
 #define kProtocolHttpEncryptionField "X-iFun-Enc"
 
-// Funapi header-related constants.
-#define kEncryptionHeaderField "ENC"
-
 // Encryption-releated constants.
 #define kEncryptionHandshakeBegin "HELLO!"
 #define kDelim1 "-"
@@ -53,8 +51,12 @@ class Encryptor : public std::enable_shared_from_this<Encryptor> {
   virtual void HandShake(const fun::string &key);
   virtual const fun::string& GetHandShakeString();
 
-  virtual bool Encrypt(fun::vector<uint8_t> &body) = 0;
-  virtual bool Decrypt(fun::vector<uint8_t> &body) = 0;
+  bool Encrypt(fun::vector<uint8_t> &body);
+  bool Decrypt(fun::vector<uint8_t> &body);
+
+  // 버퍼의 일부분(예: 헤더 공간 뒤의 본문)을 제자리에서 암호화/복호화한다.
+  virtual bool Encrypt(uint8_t *data, const size_t size) = 0;
+  virtual bool Decrypt(uint8_t *data, const size_t size) = 0;
 
   bool IsHandShakeCompleted();
 
@@ -81,6 +83,16 @@ const fun::string& Encryptor::GetHandShakeString() {
 }
 
 
+bool Encryptor::Encrypt(fun::vector<uint8_t> &body) {
+  return Encrypt(body.data(), body.size());
+}
+
+
+bool Encryptor::Decrypt(fun::vector<uint8_t> &body) {
+  return Decrypt(body.data(), body.size());
+}
+
+
 bool Encryptor::IsHandShakeCompleted() {
   return handshake_completed_;
 }
@@ -95,8 +107,8 @@ public:
   EncryptionType GetEncryptionType();
   static fun::string GetEncryptionName();
 
-  bool Encrypt(fun::vector<uint8_t> &body);
-  bool Decrypt(fun::vector<uint8_t> &body);
+  bool Encrypt(uint8_t *data, const size_t size);
+  bool Decrypt(uint8_t *data, const size_t size);
 };
 
 
@@ -119,12 +131,12 @@ fun::string Encryptor0::GetEncryptionName() {
 }
 
 
-bool Encryptor0::Encrypt(fun::vector<uint8_t> &body) {
+bool Encryptor0::Encrypt(uint8_t *data, const size_t size) {
   return true;
 }
 
 
-bool Encryptor0::Decrypt(fun::vector<uint8_t> &body) {
+bool Encryptor0::Decrypt(uint8_t *data, const size_t size) {
   return true;
 }
 
@@ -230,8 +242,8 @@ class EncryptorChacha20 : public EncryptorSodium {
 
   void HandShake(const fun::string &key);
 
-  bool Encrypt(fun::vector<uint8_t> &body);
-  bool Decrypt(fun::vector<uint8_t> &body);
+  bool Encrypt(uint8_t *data, const size_t size);
+  bool Decrypt(uint8_t *data, const size_t size);
 
  private:
   void GenerateChacha20Secret(std::array<uint8_t, 32> *key,
@@ -267,36 +279,36 @@ fun::string EncryptorChacha20::GetEncryptionName() {
 }
 
 
-bool EncryptorChacha20::Encrypt(fun::vector<uint8_t> &body) {
+bool EncryptorChacha20::Encrypt(uint8_t *data, const size_t size) {
   if (handshake_completed_ == false)
     return false;
 
-  if (!body.empty()) {
-    ::crypto_stream_chacha20_xor_ic(body.data(),
-                                    body.data(),
-                                    body.size(),
+  if (size > 0) {
+    ::crypto_stream_chacha20_xor_ic(data,
+                                    data,
+                                    size,
                                     &enc_nonce_[0],
                                     enc_count_,
                                     &key_[0]);
-    enc_count_ += body.size();
+    enc_count_ += size;
   }
 
   return true;
 }
 
 
-bool EncryptorChacha20::Decrypt(fun::vector<uint8_t> &body) {
-  if (!body.empty()) {
-    if (0 != ::crypto_stream_chacha20_xor_ic(body.data(),
-                                             body.data(),
-                                             body.size(),
+bool EncryptorChacha20::Decrypt(uint8_t *data, const size_t size) {
+  if (size > 0) {
+    if (0 != ::crypto_stream_chacha20_xor_ic(data,
+                                             data,
+                                             size,
                                              &dec_nonce_[0],
                                              dec_count_,
                                              &key_[0])) {
       return false;
     }
 
-    dec_count_ += body.size();
+    dec_count_ += size;
   }
 
   return true;
@@ -356,8 +368,8 @@ public:
 
   void HandShake(const fun::string &key);
 
-  bool Encrypt(fun::vector<uint8_t> &body);
-  bool Decrypt(fun::vector<uint8_t> &body);
+  bool Encrypt(uint8_t *data, const size_t size);
+  bool Decrypt(uint8_t *data, const size_t size);
 };
 
 
@@ -379,12 +391,12 @@ fun::string EncryptorChacha20::GetEncryptionName() {
 }
 
 
-bool EncryptorChacha20::Encrypt(fun::vector<uint8_t> &body) {
+bool EncryptorChacha20::Encrypt(uint8_t *data, const size_t size) {
   return true;
 }
 
 
-bool EncryptorChacha20::Decrypt(fun::vector<uint8_t> &body) {
+bool EncryptorChacha20::Decrypt(uint8_t *data, const size_t size) {
   return true;
 }
 
@@ -406,8 +418,8 @@ class EncryptorAes128 : public EncryptorSodium {
 
   void HandShake(const fun::string &key);
 
-  bool Encrypt(fun::vector<uint8_t> &body);
-  bool Decrypt(fun::vector<uint8_t> &body);
+  bool Encrypt(uint8_t *data, const size_t size);
+  bool Decrypt(uint8_t *data, const size_t size);
 
  private:
   void GenerateAes128Secret(std::array<uint8_t, 1408> *key,
@@ -441,14 +453,14 @@ fun::string EncryptorAes128::GetEncryptionName() {
 }
 
 
-bool EncryptorAes128::Encrypt(fun::vector<uint8_t> &body) {
+bool EncryptorAes128::Encrypt(uint8_t *data, const size_t size) {
   if (handshake_completed_ == false)
     return false;
 
-  if (!body.empty()) {
-    ::crypto_stream_aes128ctr_xor_afternm(body.data(),
-                                          body.data(),
-                                          body.size(),
+  if (size > 0) {
+    ::crypto_stream_aes128ctr_xor_afternm(data,
+                                          data,
+                                          size,
                                           &enc_nonce_[0],
                                           &table_[0]);
     ::sodium_increment(&enc_nonce_[0], 16);
@@ -458,11 +470,11 @@ bool EncryptorAes128::Encrypt(fun::vector<uint8_t> &body) {
 }
 
 
-bool EncryptorAes128::Decrypt(fun::vector<uint8_t> &body) {
-  if (!body.empty()) {
-    if (0 != ::crypto_stream_aes128ctr_xor_afternm(body.data(),
-                                                   body.data(),
-                                                   body.size(),
+bool EncryptorAes128::Decrypt(uint8_t *data, const size_t size) {
+  if (size > 0) {
+    if (0 != ::crypto_stream_aes128ctr_xor_afternm(data,
+                                                   data,
+                                                   size,
                                                    &dec_nonce_[0],
                                                    &table_[0])) {
       return false;
@@ -510,8 +522,8 @@ class EncryptorAes128 : public EncryptorSodium {
 
   void HandShake(const fun::string &key);
 
-  bool Encrypt(fun::vector<uint8_t> &body);
-  bool Decrypt(fun::vector<uint8_t> &body);
+  bool Encrypt(uint8_t *data, const size_t size);
+  bool Decrypt(uint8_t *data, const size_t size);
 };
 
 
@@ -533,12 +545,12 @@ fun::string EncryptorAes128::GetEncryptionName() {
 }
 
 
-bool EncryptorAes128::Encrypt(fun::vector<uint8_t> &body) {
+bool EncryptorAes128::Encrypt(uint8_t *data, const size_t size) {
   return true;
 }
 
 
-bool EncryptorAes128::Decrypt(fun::vector<uint8_t> &body) {
+bool EncryptorAes128::Decrypt(uint8_t *data, const size_t size) {
   return true;
 }
 
@@ -600,9 +612,20 @@ class FunapiEncryptionImpl : public std::enable_shared_from_this<FunapiEncryptio
   bool Encrypt(HeaderFields &header_fields,
                fun::vector<uint8_t> &body,
                const EncryptionType encryption_type);
+  bool Encrypt(FunapiHeaderWriter &header,
+               fun::vector<uint8_t> &body,
+               const size_t offset,
+               const EncryptionType encryption_type);
   bool Decrypt(HeaderFields &header_fields,
                fun::vector<uint8_t> &body,
                fun::vector<EncryptionType>& encryption_types);
+  bool Decrypt(const FunapiHeaderView &header,
+               fun::vector<uint8_t> &body,
+               fun::vector<EncryptionType>& encryption_types);
+  bool Decrypt(const FunapiHeaderView &header,
+               uint8_t *data,
+               const size_t size,
+               fun::vector<EncryptionType>& encryption_types);
 
   void SetHeaderFieldsForHttpSend (HeaderFields &header_fields);
   void SetHeaderFieldsForHttpRecv (HeaderFields &header_fields);
@@ -664,43 +687,72 @@ bool FunapiEncryptionImpl::CreateEncryptor(const EncryptionType type) {
 bool FunapiEncryptionImpl::Decrypt(HeaderFields &header_fields,
                                    fun::vector<uint8_t> &body,
                                    fun::vector<EncryptionType>& encryption_types) {
-  fun::string encryption_header;
-  fun::string encryption_str("");
+  FunapiHeaderView header;
+  header.AddProtocolFields(header_fields);
 
-  HeaderFields::iterator it;
-  it = header_fields.find(kLengthHeaderField);
-  size_t body_length = atoi(it->second.c_str());
+  return Decrypt(header, body, encryption_types);
+}
 
-  it = header_fields.find(kEncryptionHeaderField);
-  if (it != header_fields.end()) {
-    size_t index = it->second.find(kDelim1);
-    encryption_header = it->second;
 
-    if (index != fun::string::npos) {
-      encryption_str = encryption_header.substr(0, index);
-      encryption_header = encryption_header.substr(index+1);
-    }
-    else if (encryption_header.compare(" ") != 0) {
-      encryption_str = encryption_header;
-    }
+static EncryptionType ToEncryptionType(const char *str, const size_t length) {
+  size_t number = 0;
+  if (FunapiHeaderView::ParseNumber(str, length, number)) {
+    return static_cast<EncryptionType>(number);
   }
 
-  if (encryption_str.compare(kEncryptionHandshakeBegin) == 0) {
-    if (encryption_header.length() > 0) {
-      size_t begin = 0;
-      size_t end = encryption_header.find(kDelim2);
-      EncryptionType type;
+  return EncryptionType::kNoneEncryption;
+}
 
-      while (end != fun::string::npos) {
-        type = static_cast<EncryptionType>(atoi(encryption_header.substr(begin, end-begin).c_str()));
-        CreateEncryptor(type);
 
-        begin = end + 1;
-        end = encryption_header.find(kDelim2, begin);
-      }
+bool FunapiEncryptionImpl::Decrypt(const FunapiHeaderView &header,
+                                   fun::vector<uint8_t> &body,
+                                   fun::vector<EncryptionType>& encryption_types) {
+  return Decrypt(header, body.data(), body.size(), encryption_types);
+}
+
+
+bool FunapiEncryptionImpl::Decrypt(const FunapiHeaderView &header,
+                                   uint8_t *data,
+                                   const size_t size,
+                                   fun::vector<EncryptionType>& encryption_types) {
+  const FunapiHeaderView::Field *field = header.GetEncryption();
+  if (field == nullptr) {
+    return true;
+  }
+
+  // ENC 필드는 "<type>-<handshake>" 형식이다.
+  // 구분자가 없으면 필드 전체를 type 과 handshake 로 사용한다.
+  const char *encryption_str = field->value;
+  size_t encryption_str_length = field->value_length;
+  const char *encryption_header = field->value;
+  size_t encryption_header_length = field->value_length;
+
+  const char *delim = static_cast<const char*>(memchr(field->value, kDelim1[0], field->value_length));
+  if (delim != nullptr) {
+    encryption_str_length = delim - field->value;
+    encryption_header = delim + 1;
+    encryption_header_length = field->value + field->value_length - encryption_header;
+  }
+  else if (field->value_length == 1 && field->value[0] == ' ') {
+    encryption_str_length = 0;
+  }
+
+  static const size_t kHandshakeBeginLength = strlen(kEncryptionHandshakeBegin);
+  if (encryption_str_length == kHandshakeBeginLength &&
+      memcmp(encryption_str, kEncryptionHandshakeBegin, kHandshakeBeginLength) == 0) {
+    if (encryption_header_length > 0) {
+      const char *begin = encryption_header;
+      const char *end = encryption_header + encryption_header_length;
+
+      while (begin <= end) {
+        const char *next = static_cast<const char*>(memchr(begin, kDelim2[0], end - begin));
+        if (next == nullptr) {
+          next = end;
+        }
 
-      type = static_cast<EncryptionType>(atoi(encryption_header.substr(begin).c_str()));
-      CreateEncryptor(type);
+        CreateEncryptor(ToEncryptionType(begin, next - begin));
+        begin = next + 1;
+      }
 
       if (HasEncryption(EncryptionType::kChacha20Encryption)) {
         encryption_types.push_back(EncryptionType::kChacha20Encryption);
@@ -717,23 +769,22 @@ bool FunapiEncryptionImpl::Decrypt(HeaderFields &header_fields,
       encryption_types.push_back(EncryptionType::kDefaultEncryption);
     }
   }
-  else if (encryption_str.length() > 0) {
-    EncryptionType type = static_cast<EncryptionType>(atoi(encryption_str.c_str()));
+  else if (encryption_str_length > 0) {
+    EncryptionType type = ToEncryptionType(encryption_str, encryption_str_length);
     if (type == EncryptionType::kIFunEngine1Encryption) {
       std::shared_ptr<Encryptor1> e1 = std::static_pointer_cast<Encryptor1>(GetEncryptor(type));
-
       if (e1) {
         if (false == e1->IsHandShakeCompleted()) {
           encryption_types.push_back(EncryptionType::kIFunEngine1Encryption);
-          e1->HandShake(encryption_header);
+          e1->HandShake(fun::string(encryption_header, encryption_header_length));
         }
       }
     }
 
-    if (body_length > 0) {
+    if (header.GetLength() > 0) {
       std::shared_ptr<Encryptor> e = GetEncryptor(type);
       if (e) {
-        e->Decrypt(body);
+        e->Decrypt(data, size);
       }
     }
   }
@@ -775,6 +826,38 @@ bool FunapiEncryptionImpl::Encrypt(HeaderFields &header_fields,
 }
 
 
+bool FunapiEncryptionImpl::Encrypt(FunapiHeaderWriter &header,
+                                   fun::vector<uint8_t> &body,
+                                   const size_t offset,
+                                   const EncryptionType encryption_type) {
+  std::shared_ptr<Encryptor> e = GetEncryptor(encryption_type);
+
+  if (e) {
+    const int type = static_cast<int>(e->GetEncryptionType());
+
+    if (e->IsHandShakeCompleted() == false) {
+      if (e->GetEncryptionType() == EncryptionType::kIFunEngine1Encryption) {
+        return false;
+      }
+
+      const fun::string &handshake = e->GetHandShakeString();
+      header.SetEncryption(type, handshake.c_str(), handshake.length());
+
+      body.resize(offset);
+      header.SetLength(0);
+
+      return true;
+    }
+
+    header.SetEncryption(type);
+
+    return e->Encrypt(body.data() + offset, body.size() - offset);
+  }
+
+  return true;
+}
+
+
 void FunapiEncryptionImpl::SetHeaderFieldsForHttpSend (HeaderFields &header_fields) {
   HeaderFields::const_iterator it = header_fields.find(kEncryptionHeaderField);
   if (it != header_fields.end()) {
@@ -887,6 +970,14 @@ bool FunapiEncryption::Encrypt(HeaderFields &header_fields,
 }
 
 
+bool FunapiEncryption::Encrypt(FunapiHeaderWriter &header,
+                               fun::vector<uint8_t> &body,
+                               const size_t offset,
+                               const EncryptionType encryption_type) {
+  return impl_->Encrypt(header, body, offset, encryption_type);
+}
+
+
 bool FunapiEncryption::Decrypt(HeaderFields &header_fields,
                                fun::vector<uint8_t> &body,
                                fun::vector<EncryptionType>& encryption_types) {
@@ -894,6 +985,21 @@ bool FunapiEncryption::Decrypt(HeaderFields &header_fields,
 }
 
 
+bool FunapiEncryption::Decrypt(const FunapiHeaderView &header,
+                               fun::vector<uint8_t> &body,
+                               fun::vector<EncryptionType>& encryption_types) {
+  return impl_->Decrypt(header, body, encryption_types);
+}
+
+
+bool FunapiEncryption::Decrypt(const FunapiHeaderView &header,
+                               uint8_t *data,
+                               const size_t size,
+                               fun::vector<EncryptionType>& encryption_types) {
+  return impl_->Decrypt(header, data, size, encryption_types);
+}
+
+
 void FunapiEncryption::SetHeaderFieldsForHttpSend (HeaderFields &header_fields) {
   return impl_->SetHeaderFieldsForHttpSend(header_fields);
 }
@@ -14,8 +14,8 @@ class Encryptor1 : public Encryptor {
   EncryptionType GetEncryptionType();
   static fun::string GetEncryptionName();
 
-  bool Encrypt(fun::vector<uint8_t> &body);
-  bool Decrypt(fun::vector<uint8_t> &body);
+  bool Encrypt(uint8_t *data, const size_t size);
+  bool Decrypt(uint8_t *data, const size_t size);
 };
 
 
@@ -37,12 +37,12 @@ fun::string Encryptor1::GetEncryptionName() {
 }
 
 
-bool Encryptor1::Encrypt(fun::vector<uint8_t> &body) {
+bool Encryptor1::Encrypt(uint8_t *data, const size_t size) {
   return true;
 }
 
 
-bool Encryptor1::Decrypt(fun::vector<uint8_t> &body) {
+bool Encryptor1::Decrypt(uint8_t *data, const size_t size) {
   return true;
 }
 
@@ -57,8 +57,8 @@ class Encryptor2 : public Encryptor {
   EncryptionType GetEncryptionType();
   static fun::string GetEncryptionName();
 
-  bool Encrypt(fun::vector<uint8_t> &body);
-  bool Decrypt(fun::vector<uint8_t> &body);
+  bool Encrypt(uint8_t *data, const size_t size);
+  bool Decrypt(uint8_t *data, const size_t size);
 };
 
 
@@ -80,11 +80,11 @@ fun::string Encryptor2::GetEncryptionName() {
 }
 
 
-bool Encryptor2::Encrypt(fun::vector<uint8_t> &body) {
+bool Encryptor2::Encrypt(uint8_t *data, const size_t size) {
   return true;
 }
 
 
-bool Encryptor2::Decrypt(fun::vector<uint8_t> &body) {
+bool Encryptor2::Decrypt(uint8_t *data, const size_t size) {
   return true;
 }
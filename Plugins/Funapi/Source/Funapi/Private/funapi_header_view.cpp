@@ -0,0 +1,748 @@
+// Copyright (C) 2020 iFunFactory Inc. All Rights Reserved.
+//
+// This work is confidential and proprietary to iFunFactory Inc. and
+// must not be used, disclosed, copied, or distributed without the prior
+// consent of iFunFactory Inc.
+
+#include "funapi_header_view.h"
+
+#ifdef FUNAPI_UE4
+#include "FunapiPrivatePCH.h"
+#endif
+
+#include "funapi_session.h"
+#include "funapi_compression.h"
+
+namespace fun {
+
+static bool IsFieldName(const FunapiHeaderView::Field &field, const char *name) {
+  size_t length = strlen(name);
+  return field.name_length == length && memcmp(field.name, name, length) == 0;
+}
+
+
+FunapiHeaderView::FunapiHeaderView() {
+}
+
+
+void FunapiHeaderView::Clear() {
+  field_count_ = 0;
+
+  has_version_ = false;
+  has_length_ = false;
+  encryption_index_ = -1;
+
+  binary_ = false;
+  plugin_version_number_ = -1;
+
+  version_number_ = -1;
+  length_valid_ = false;
+  length_number_ = 0;
+  uncompressed_length_ = 0;
+  stream_compressed_ = false;
+  dictionary_id_ = 0;
+}
+
+
+bool FunapiHeaderView::Add(const char *name, const size_t name_length,
+                           const char *value, const size_t value_length) {
+  if (field_count_ >= kMaxFields) {
+    return false;
+  }
+
+  const int index = field_count_++;
+  Field &field = fields_[index];
+  field.name = name;
+  field.name_length = name_length;
+  field.value = value;
+  field.value_length = value_length;
+
+  size_t number = 0;
+  if (IsFieldName(field, kVersionHeaderField)) {
+    has_version_ = true;
+    version_number_ = ParseNumber(value, value_length, number) ? static_cast<long>(number) : -1;
+  }
+  else if (IsFieldName(field, kLengthHeaderField)) {
+    has_length_ = true;
+    length_valid_ = ParseNumber(value, value_length, length_number_);
+  }
+  else if (IsFieldName(field, kProtocolCompressionField)) {
+    uncompressed_length_ = ParseNumber(value, value_length, number) ? number : 0;
+  }
+  else if (IsFieldName(field, kProtocolStreamCompressionField)) {
+    uncompressed_length_ = ParseNumber(value, value_length, number) ? number : 0;
+    stream_compressed_ = true;
+  }
+  else if (IsFieldName(field, kCompressionDictionaryField)) {
+    dictionary_id_ = ParseNumber(value, value_length, number) ? static_cast<uint32_t>(number) : 0;
+  }
+  else if (IsFieldName(field, kEncryptionHeaderField)) {
+    encryption_index_ = index;
+  }
+
+  return true;
+}
+
+
+bool FunapiHeaderView::AddProtocolFields(const HeaderFields &header_fields) {
+  static const char* kProtocolFields[] = {
+    kVersionHeaderField,
+    kLengthHeaderField,
+    kProtocolCompressionField,
+    kProtocolStreamCompressionField,
+    kCompressionDictionaryField,
+    kEncryptionHeaderField,
+  };
+
+  for (auto name : kProtocolFields) {
+    auto it = header_fields.find(name);
+    if (it != header_fields.cend()) {
+      if (false == Add(it->first.c_str(), it->first.length(),
+                       it->second.c_str(), it->second.length())) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+int FunapiHeaderView::GetFieldCount() const {
+  return field_count_;
+}
+
+
+const FunapiHeaderView::Field& FunapiHeaderView::GetField(const int index) const {
+  return fields_[index];
+}
+
+
+const FunapiHeaderView::Field* FunapiHeaderView::Find(const char *name) const {
+  for (int i = 0; i < field_count_; ++i) {
+    if (IsFieldName(fields_[i], name)) {
+      return &fields_[i];
+    }
+  }
+
+  return nullptr;
+}
+
+
+bool FunapiHeaderView::HasVersion() const {
+  return has_version_;
+}
+
+
+long FunapiHeaderView::GetVersion() const {
+  return version_number_;
+}
+
+
+bool FunapiHeaderView::HasLength() const {
+  return has_length_;
+}
+
+
+bool FunapiHeaderView::IsLengthValid() const {
+  return length_valid_;
+}
+
+
+size_t FunapiHeaderView::GetLength() const {
+  return length_number_;
+}
+
+
+size_t FunapiHeaderView::GetUncompressedLength() const {
+  return uncompressed_length_;
+}
+
+
+bool FunapiHeaderView::IsStreamCompressed() const {
+  return stream_compressed_;
+}
+
+
+uint32_t FunapiHeaderView::GetDictionaryId() const {
+  return dictionary_id_;
+}
+
+
+const FunapiHeaderView::Field* FunapiHeaderView::GetEncryption() const {
+  if (encryption_index_ < 0) {
+    return nullptr;
+  }
+
+  return &fields_[encryption_index_];
+}
+
+
+fun::string FunapiHeaderView::ToString() const {
+  fun::string ret("{");
+  if (binary_) {
+    // 바이너리 헤더의 숫자 필드는 필드 목록에 없다.
+    fun::stringstream ss;
+    ss << "(" << kBinaryHeaderField << ")";
+    if (uncompressed_length_ > 0) {
+      ss << "(" << (stream_compressed_ ? kProtocolStreamCompressionField : kProtocolCompressionField)
+         << "=" << uncompressed_length_ << ")";
+    }
+    ss << "(" << kLengthHeaderField << "=" << length_number_ << ")";
+    if (plugin_version_number_ >= 0) {
+      ss << "(" << kPluginVersionHeaderField << "=" << plugin_version_number_ << ")";
+    }
+    ss << "(" << kVersionHeaderField << "=" << version_number_ << ")";
+    ret.append(ss.str());
+  }
+
+  for (int i = 0; i < field_count_; ++i) {
+    ret.append("(");
+    ret.append(fields_[i].name, fields_[i].name_length);
+    ret.append("=");
+    ret.append(fields_[i].value, fields_[i].value_length);
+    ret.append(")");
+  }
+  ret.append("}");
+
+  return ret;
+}
+
+
+bool FunapiHeaderView::ParseNumber(const char *str, const size_t length, size_t &number) {
+  if (length == 0) {
+    return false;
+  }
+
+  size_t n = 0;
+  for (size_t i = 0; i < length; ++i) {
+    if (str[i] < '0' || str[i] > '9') {
+      return false;
+    }
+
+    const size_t digit = static_cast<size_t>(str[i] - '0');
+    if (n > (SIZE_MAX - digit) / 10) {
+      // 값이 size_t 를 넘는다.
+      return false;
+    }
+    n = n * 10 + digit;
+  }
+
+  number = n;
+  return true;
+}
+
+
+bool FunapiHeaderView::ParseVarint(const uint8_t *&ptr, const uint8_t *end, size_t &number) {
+  size_t n = 0;
+  for (unsigned shift = 0; ptr < end; shift += 7) {
+    const uint8_t b = *ptr++;
+    if (shift >= sizeof(size_t) * 8 ||
+        (shift > 0 && (static_cast<size_t>(b & 0x7F) >> (sizeof(size_t) * 8 - shift)) != 0)) {
+      // 값이 size_t 를 넘는다.
+      ptr = nullptr;
+      return false;
+    }
+
+    n |= static_cast<size_t>(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) {
+      number = n;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+bool FunapiHeaderView::IsBinaryHeader(const uint8_t first_byte) {
+  return (first_byte & kBinaryHeaderMarker) != 0;
+}
+
+
+bool FunapiHeaderView::ParseBinaryString(const uint8_t *&ptr, const uint8_t *end,
+                                         const char *&str, size_t &length) {
+  if (false == ParseVarint(ptr, end, length) || length > static_cast<size_t>(end - ptr)) {
+    return false;
+  }
+
+  str = reinterpret_cast<const char*>(ptr);
+  ptr += length;
+  return true;
+}
+
+
+// NOTE: 필드를 읽지 못했을 때 ptr 가 nullptr 이면(ParseVarint 의 overflow) 잘못된 헤더이고
+// 그렇지 않으면 헤더가 덜 도착한 것이다.
+FunapiHeaderView::BinaryParseResult FunapiHeaderView::ParseBinary(const uint8_t *data,
+                                                                  const size_t size,
+                                                                  size_t &header_size) {
+  Clear();
+
+  if (size < 2) {
+    return BinaryParseResult::kIncomplete;
+  }
+
+  if (false == IsBinaryHeader(data[0])) {
+    return BinaryParseResult::kInvalid;
+  }
+
+  const uint8_t *ptr = data + 2;
+  const uint8_t *end = data + size;
+  const uint8_t flags = data[1];
+
+  auto failed = [&ptr]() {
+    return ptr == nullptr ? BinaryParseResult::kInvalid : BinaryParseResult::kIncomplete;
+  };
+
+  binary_ = true;
+  has_version_ = true;
+  version_number_ = data[0] & ~kBinaryHeaderMarker;
+
+  if (false == ParseVarint(ptr, end, length_number_)) {
+    return failed();
+  }
+  has_length_ = true;
+  length_valid_ = true;
+
+  if (flags & kBinaryCompressedFlag) {
+    if (false == ParseVarint(ptr, end, uncompressed_length_)) {
+      return failed();
+    }
+    stream_compressed_ = (flags & kBinaryStreamCompressedFlag) != 0;
+  }
+
+  if (flags & kBinaryEncryptionFieldFlag) {
+    const char *value = nullptr;
+    size_t value_length = 0;
+    if (false == ParseBinaryString(ptr, end, value, value_length)) {
+      return failed();
+    }
+
+    Add(kEncryptionHeaderField, strlen(kEncryptionHeaderField), value, value_length);
+  }
+  else if (flags & kBinaryEncryptionTypeMask) {
+    const size_t type =
+        static_cast<size_t>(EncryptionType::kDefaultEncryption) + (flags & kBinaryEncryptionTypeMask);
+    const size_t length = FunapiHeaderWriter::FormatNumber(encryption_value_, type);
+    Add(kEncryptionHeaderField, strlen(kEncryptionHeaderField), encryption_value_, length);
+  }
+
+  if (flags & kBinaryPluginVersionFlag) {
+    size_t number = 0;
+    if (false == ParseVarint(ptr, end, number)) {
+      return failed();
+    }
+    plugin_version_number_ = static_cast<long>(number);
+  }
+
+  if (flags & kBinaryExtraFieldsFlag) {
+    size_t count = 0;
+    if (false == ParseVarint(ptr, end, count)) {
+      return failed();
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      const char *name = nullptr;
+      size_t name_length = 0;
+      const char *value = nullptr;
+      size_t value_length = 0;
+      if (false == ParseBinaryString(ptr, end, name, name_length) ||
+          false == ParseBinaryString(ptr, end, value, value_length)) {
+        return failed();
+      }
+
+      if (false == Add(name, name_length, value, value_length)) {
+        return BinaryParseResult::kInvalid;
+      }
+    }
+  }
+
+  header_size = ptr - data;
+  return BinaryParseResult::kComplete;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// FunapiHeaderWriter implementation.
+
+FunapiHeaderWriter::FunapiHeaderWriter() {
+}
+
+
+void FunapiHeaderWriter::SetBinary(const bool binary) {
+  binary_ = binary;
+}
+
+
+bool FunapiHeaderWriter::IsBinary() const {
+  return binary_;
+}
+
+
+bool FunapiHeaderWriter::AddField(const char *name, const size_t number) {
+  if (extra_field_count_ >= kMaxExtraFields) {
+    return false;
+  }
+
+  extra_fields_[extra_field_count_].name = name;
+  extra_fields_[extra_field_count_].number = number;
+  ++extra_field_count_;
+  return true;
+}
+
+
+bool FunapiHeaderWriter::FindField(const char *name, size_t &number) const {
+  for (int i = 0; i < extra_field_count_; ++i) {
+    if (strcmp(extra_fields_[i].name, name) == 0) {
+      number = extra_fields_[i].number;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+void FunapiHeaderWriter::SetVersion(const int version) {
+  version_ = version;
+}
+
+
+void FunapiHeaderWriter::SetPluginVersion(const int plugin_version) {
+  plugin_version_ = plugin_version;
+}
+
+
+void FunapiHeaderWriter::SetLength(const size_t length) {
+  length_ = length;
+}
+
+
+size_t FunapiHeaderWriter::GetLength() const {
+  return length_;
+}
+
+
+void FunapiHeaderWriter::SetUncompressedLength(const size_t length) {
+  uncompressed_length_ = length;
+}
+
+
+size_t FunapiHeaderWriter::GetUncompressedLength() const {
+  return uncompressed_length_;
+}
+
+
+void FunapiHeaderWriter::SetStreamCompressed(const bool stream_compressed) {
+  stream_compressed_ = stream_compressed;
+}
+
+
+void FunapiHeaderWriter::SetEncryption(const int encryption_type,
+                                       const char *handshake,
+                                       const size_t handshake_length) {
+  has_encryption_ = true;
+  encryption_type_ = encryption_type;
+  handshake_ = handshake;
+  handshake_length_ = handshake_length;
+}
+
+
+// NOTE: 필드는 이전에 사용하던 fun::map 과 같은 순서(C, ENC, LEN, PVER, VER)로 쓴다.
+size_t FunapiHeaderWriter::GetSize() const {
+  if (binary_) {
+    return GetBinarySize();
+  }
+
+  // "<name>:<value>\n"
+  size_t size = 0;
+
+  if (uncompressed_length_ > 0) {
+    const char *name = stream_compressed_ ? kProtocolStreamCompressionField : kProtocolCompressionField;
+    size += strlen(name) + 2 + GetNumberLength(uncompressed_length_);
+  }
+
+  if (has_encryption_) {
+    size += strlen(kEncryptionHeaderField) + 2 + GetNumberLength(encryption_type_);
+    if (handshake_ != nullptr) {
+      size += 1 + handshake_length_;
+    }
+  }
+
+  for (int i = 0; i < extra_field_count_; ++i) {
+    size += strlen(extra_fields_[i].name) + 2 + GetNumberLength(extra_fields_[i].number);
+  }
+
+  size += strlen(kLengthHeaderField) + 2 + GetNumberLength(length_);
+
+  if (plugin_version_ >= 0) {
+    size += strlen(kPluginVersionHeaderField) + 2 + GetNumberLength(plugin_version_);
+  }
+
+  size += strlen(kVersionHeaderField) + 2 + GetNumberLength(version_);
+
+  // End of header.
+  size += 1;
+
+  return size;
+}
+
+
+size_t FunapiHeaderWriter::WriteField(char *out, const char *name, const size_t number) const {
+  size_t name_length = strlen(name);
+  memcpy(out, name, name_length);
+
+  char *ptr = out + name_length;
+  *ptr++ = ':';
+  ptr += FormatNumber(ptr, number);
+  *ptr++ = '\n';
+
+  return ptr - out;
+}
+
+
+size_t FunapiHeaderWriter::Write(uint8_t *out) const {
+  if (binary_) {
+    return WriteBinary(out);
+  }
+
+  char *ptr = reinterpret_cast<char*>(out);
+
+  if (uncompressed_length_ > 0) {
+    const char *name = stream_compressed_ ? kProtocolStreamCompressionField : kProtocolCompressionField;
+    ptr += WriteField(ptr, name, uncompressed_length_);
+  }
+
+  if (has_encryption_) {
+    ptr += WriteField(ptr, kEncryptionHeaderField, encryption_type_);
+    if (handshake_ != nullptr) {
+      // "ENC:<type>-<handshake>\n"
+      --ptr;
+      *ptr++ = '-';
+      memcpy(ptr, handshake_, handshake_length_);
+      ptr += handshake_length_;
+      *ptr++ = '\n';
+    }
+  }
+
+  for (int i = 0; i < extra_field_count_; ++i) {
+    ptr += WriteField(ptr, extra_fields_[i].name, extra_fields_[i].number);
+  }
+
+  ptr += WriteField(ptr, kLengthHeaderField, length_);
+
+  if (plugin_version_ >= 0) {
+    ptr += WriteField(ptr, kPluginVersionHeaderField, plugin_version_);
+  }
+
+  ptr += WriteField(ptr, kVersionHeaderField, version_);
+
+  *ptr++ = '\n';
+
+  return ptr - reinterpret_cast<char*>(out);
+}
+
+
+bool FunapiHeaderWriter::IsCompactEncryption() const {
+  // handshake 가 없으면 암호화 타입만 플래그에 넣는다.
+  const int base = static_cast<int>(EncryptionType::kDefaultEncryption);
+  return handshake_ == nullptr &&
+         encryption_type_ > base &&
+         encryption_type_ - base <= FunapiHeaderView::kBinaryEncryptionTypeMask;
+}
+
+
+size_t FunapiHeaderWriter::GetEncryptionValueLength() const {
+  // "<type>-<handshake>"
+  size_t length = GetNumberLength(encryption_type_);
+  if (handshake_ != nullptr) {
+    length += 1 + handshake_length_;
+  }
+
+  return length;
+}
+
+
+size_t FunapiHeaderWriter::GetBinarySize() const {
+  // marker | version, flags, LEN
+  size_t size = 2 + GetVarintLength(length_);
+
+  if (uncompressed_length_ > 0) {
+    size += GetVarintLength(uncompressed_length_);
+  }
+
+  if (has_encryption_ && false == IsCompactEncryption()) {
+    const size_t length = GetEncryptionValueLength();
+    size += GetVarintLength(length) + length;
+  }
+
+  if (plugin_version_ >= 0) {
+    size += GetVarintLength(plugin_version_);
+  }
+
+  if (extra_field_count_ > 0) {
+    size += GetVarintLength(extra_field_count_);
+    for (int i = 0; i < extra_field_count_; ++i) {
+      const size_t name_length = strlen(extra_fields_[i].name);
+      const size_t value_length = GetNumberLength(extra_fields_[i].number);
+      size += GetVarintLength(name_length) + name_length;
+      size += GetVarintLength(value_length) + value_length;
+    }
+  }
+
+  return size;
+}
+
+
+size_t FunapiHeaderWriter::WriteBinary(uint8_t *out) const {
+  uint8_t flags = 0;
+  if (uncompressed_length_ > 0) {
+    flags |= FunapiHeaderView::kBinaryCompressedFlag;
+    if (stream_compressed_) {
+      flags |= FunapiHeaderView::kBinaryStreamCompressedFlag;
+    }
+  }
+  if (has_encryption_) {
+    if (IsCompactEncryption()) {
+      flags |= static_cast<uint8_t>(encryption_type_ - static_cast<int>(EncryptionType::kDefaultEncryption));
+    }
+    else {
+      flags |= FunapiHeaderView::kBinaryEncryptionFieldFlag;
+    }
+  }
+  if (plugin_version_ >= 0) {
+    flags |= FunapiHeaderView::kBinaryPluginVersionFlag;
+  }
+  if (extra_field_count_ > 0) {
+    flags |= FunapiHeaderView::kBinaryExtraFieldsFlag;
+  }
+
+  uint8_t *ptr = out;
+  *ptr++ = static_cast<uint8_t>(FunapiHeaderView::kBinaryHeaderMarker | (version_ & 0x7F));
+  *ptr++ = flags;
+  ptr += WriteVarint(ptr, length_);
+
+  if (flags & FunapiHeaderView::kBinaryCompressedFlag) {
+    ptr += WriteVarint(ptr, uncompressed_length_);
+  }
+
+  if (flags & FunapiHeaderView::kBinaryEncryptionFieldFlag) {
+    ptr += WriteVarint(ptr, GetEncryptionValueLength());
+    ptr += FormatNumber(reinterpret_cast<char*>(ptr), encryption_type_);
+    if (handshake_ != nullptr) {
+      *ptr++ = '-';
+      memcpy(ptr, handshake_, handshake_length_);
+      ptr += handshake_length_;
+    }
+  }
+
+  if (flags & FunapiHeaderView::kBinaryPluginVersionFlag) {
+    ptr += WriteVarint(ptr, plugin_version_);
+  }
+
+  if (flags & FunapiHeaderView::kBinaryExtraFieldsFlag) {
+    ptr += WriteVarint(ptr, extra_field_count_);
+    for (int i = 0; i < extra_field_count_; ++i) {
+      const size_t name_length = strlen(extra_fields_[i].name);
+      ptr += WriteVarint(ptr, name_length);
+      memcpy(ptr, extra_fields_[i].name, name_length);
+      ptr += name_length;
+
+      ptr += WriteVarint(ptr, GetNumberLength(extra_fields_[i].number));
+      ptr += FormatNumber(reinterpret_cast<char*>(ptr), extra_fields_[i].number);
+    }
+  }
+
+  return ptr - out;
+}
+
+
+fun::string FunapiHeaderWriter::ToString() const {
+  fun::vector<uint8_t> buffer(GetSize());
+  Write(buffer.data());
+
+  if (binary_) {
+    FunapiHeaderView view;
+    size_t header_size = 0;
+    view.ParseBinary(buffer.data(), buffer.size(), header_size);
+    return view.ToString();
+  }
+
+  fun::string ret("{");
+  const char *line = reinterpret_cast<const char*>(buffer.data());
+  const char *end = line + buffer.size();
+  while (line < end) {
+    const char *eol = static_cast<const char*>(memchr(line, '\n', end - line));
+    if (eol == nullptr || eol == line) {
+      break;
+    }
+
+    const char *delim = static_cast<const char*>(memchr(line, ':', eol - line));
+    if (delim == nullptr) {
+      delim = eol;
+    }
+
+    ret.append("(");
+    ret.append(line, delim - line);
+    ret.append("=");
+    if (delim < eol) {
+      ret.append(delim + 1, eol - delim - 1);
+    }
+    ret.append(")");
+
+    line = eol + 1;
+  }
+  ret.append("}");
+
+  return ret;
+}
+
+
+size_t FunapiHeaderWriter::GetNumberLength(size_t number) {
+  size_t length = 1;
+  while (number >= 10) {
+    number /= 10;
+    ++length;
+  }
+
+  return length;
+}
+
+
+size_t FunapiHeaderWriter::GetVarintLength(size_t number) {
+  size_t length = 1;
+  while (number >= 0x80) {
+    number >>= 7;
+    ++length;
+  }
+
+  return length;
+}
+
+
+size_t FunapiHeaderWriter::WriteVarint(uint8_t *out, size_t number) {
+  uint8_t *ptr = out;
+  while (number >= 0x80) {
+    *ptr++ = static_cast<uint8_t>(number | 0x80);
+    number >>= 7;
+  }
+  *ptr++ = static_cast<uint8_t>(number);
+
+  return ptr - out;
+}
+
+
+size_t FunapiHeaderWriter::FormatNumber(char *out, size_t number) {
+  const size_t length = GetNumberLength(number);
+
+  char *ptr = out + length;
+  do {
+    *--ptr = static_cast<char>('0' + (number % 10));
+    number /= 10;
+  } while (number > 0);
+
+  return length;
+}
+
+}  // namespace fun
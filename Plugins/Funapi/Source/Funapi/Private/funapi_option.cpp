@@ -12,6 +12,7 @@
 
 #include "funapi_utils.h"
 #include "funapi_encryption.h"
+#include "funapi_compression.h"
 #include "funapi_tasks.h"
 #include "funapi_http.h"
 #include "funapi/network/fun_message.pb.h"
@@ -175,12 +176,26 @@ class FunapiTransportOptionImpl : public std::enable_shared_from_this<FunapiTran
   void SetCompressionType(const CompressionType type);
   fun::vector<CompressionType> GetCompressionTypes();
 
+  void SetCompressionPolicy(const fun::string &msg_type,
+                            const CompressionPolicy policy,
+                            const int threshold);
+  fun::vector<CompressionRule> GetCompressionRules();
+
   void SetZstdDictBase64String(const fun::string &zstd_dict_base64string);
   fun::string GetZstdDictBase64String();
 
+  void AddZstdDictBase64String(const fun::string &zstd_dict_base64string);
+  fun::vector<fun::string> GetZstdDictBase64Strings();
+
+  void SetLz4DictBase64String(const fun::string &lz4_dict_base64string);
+  fun::string GetLz4DictBase64String();
+
  private:
   fun::vector<CompressionType> compression_types_;
+  fun::vector<CompressionRule> compression_rules_;
   fun::string zstd_dict_base64string_;
+  fun::vector<fun::string> zstd_dict_base64strings_;
+  fun::string lz4_dict_base64string_;
 };
 
 
@@ -194,6 +209,30 @@ fun::vector<CompressionType> FunapiTransportOptionImpl::GetCompressionTypes() {
 }
 
 
+void FunapiTransportOptionImpl::SetCompressionPolicy(const fun::string &msg_type,
+                                                     const CompressionPolicy policy,
+                                                     const int threshold) {
+  for (auto &rule : compression_rules_) {
+    if (rule.msg_type == msg_type) {
+      rule.policy = policy;
+      rule.threshold = threshold;
+      return;
+    }
+  }
+
+  CompressionRule rule;
+  rule.msg_type = msg_type;
+  rule.policy = policy;
+  rule.threshold = threshold;
+  compression_rules_.push_back(rule);
+}
+
+
+fun::vector<CompressionRule> FunapiTransportOptionImpl::GetCompressionRules() {
+  return compression_rules_;
+}
+
+
 void FunapiTransportOptionImpl::SetZstdDictBase64String(const fun::string &zstd_dict_base64string) {
   zstd_dict_base64string_ = zstd_dict_base64string;
 }
@@ -204,6 +243,26 @@ fun::string FunapiTransportOptionImpl::GetZstdDictBase64String() {
 }
 
 
+void FunapiTransportOptionImpl::AddZstdDictBase64String(const fun::string &zstd_dict_base64string) {
+  zstd_dict_base64strings_.push_back(zstd_dict_base64string);
+}
+
+
+fun::vector<fun::string> FunapiTransportOptionImpl::GetZstdDictBase64Strings() {
+  return zstd_dict_base64strings_;
+}
+
+
+void FunapiTransportOptionImpl::SetLz4DictBase64String(const fun::string &lz4_dict_base64string) {
+  lz4_dict_base64string_ = lz4_dict_base64string;
+}
+
+
+fun::string FunapiTransportOptionImpl::GetLz4DictBase64String() {
+  return lz4_dict_base64string_;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // FunapiTcpTransportOptionImpl implementation.
 
@@ -224,6 +283,12 @@ class FunapiTcpTransportOptionImpl : public FunapiTransportOptionImpl {
   void SetSequenceNumberValidation(const bool validation);
   bool GetSequenceNumberValidation();
 
+  void SetUseBinaryHeader(const bool use_binary_header);
+  bool GetUseBinaryHeader();
+
+  void SetUseStreamCompression(const bool use_stream_compression);
+  bool GetUseStreamCompression();
+
   void SetConnectTimeout(const int seconds);
   int GetConnectTimeout();
 
@@ -236,6 +301,9 @@ class FunapiTcpTransportOptionImpl : public FunapiTransportOptionImpl {
   void SetUseTLS(const bool use_tls);
   bool GetUseTLS();
 
+  void SetUseKernelTLS(const bool use_kernel_tls);
+  bool GetUseKernelTLS();
+
   void SetCACertFilePath(const fun::string &path);
   const fun::string& GetCACertFilePath();
 
@@ -244,10 +312,13 @@ class FunapiTcpTransportOptionImpl : public FunapiTransportOptionImpl {
   bool auto_reconnect_ = false;
   bool enable_ping_ = false;
   bool sequence_number_validation_ = false;
+  bool use_binary_header_ = false;
+  bool use_stream_compression_ = false;
   int timeout_seconds_ = 10;
   fun::vector<EncryptionType> encryption_types_;
   fun::unordered_map<int32_t, fun::string> pubilc_keys_;
   bool use_tls_ = false;
+  bool use_kernel_tls_ = false;
   fun::string cert_file_path_;
 };
 
@@ -292,6 +363,26 @@ bool FunapiTcpTransportOptionImpl::GetSequenceNumberValidation() {
 }
 
 
+void FunapiTcpTransportOptionImpl::SetUseBinaryHeader(const bool use_binary_header) {
+  use_binary_header_ = use_binary_header;
+}
+
+
+bool FunapiTcpTransportOptionImpl::GetUseBinaryHeader() {
+  return use_binary_header_;
+}
+
+
+void FunapiTcpTransportOptionImpl::SetUseStreamCompression(const bool use_stream_compression) {
+  use_stream_compression_ = use_stream_compression;
+}
+
+
+bool FunapiTcpTransportOptionImpl::GetUseStreamCompression() {
+  return use_stream_compression_;
+}
+
+
 void FunapiTcpTransportOptionImpl::SetConnectTimeout(const int seconds) {
   timeout_seconds_ = seconds;
 }
@@ -338,6 +429,16 @@ bool FunapiTcpTransportOptionImpl::GetUseTLS() {
 }
 
 
+void FunapiTcpTransportOptionImpl::SetUseKernelTLS(const bool use_kernel_tls) {
+  use_kernel_tls_ = use_kernel_tls;
+}
+
+
+bool FunapiTcpTransportOptionImpl::GetUseKernelTLS() {
+  return use_kernel_tls_;
+}
+
+
 void FunapiTcpTransportOptionImpl::SetCACertFilePath(const fun::string &path) {
   cert_file_path_ = path;
 }
@@ -535,6 +636,26 @@ bool FunapiTcpTransportOption::GetSequenceNumberValidation() {
 }
 
 
+void FunapiTcpTransportOption::SetUseBinaryHeader(const bool use_binary_header) {
+  impl_->SetUseBinaryHeader(use_binary_header);
+}
+
+
+bool FunapiTcpTransportOption::GetUseBinaryHeader() {
+  return impl_->GetUseBinaryHeader();
+}
+
+
+void FunapiTcpTransportOption::SetUseStreamCompression(const bool use_stream_compression) {
+  impl_->SetUseStreamCompression(use_stream_compression);
+}
+
+
+bool FunapiTcpTransportOption::GetUseStreamCompression() {
+  return impl_->GetUseStreamCompression();
+}
+
+
 void FunapiTcpTransportOption::SetConnectTimeout(const int seconds) {
   impl_->SetConnectTimeout(seconds);
 }
@@ -570,6 +691,11 @@ fun::string FunapiTcpTransportOption::GetPublicKey(const EncryptionType type) {
 void FunapiTcpTransportOption::SetUseTLS(const bool use_tls) {
   impl_->SetUseTLS(use_tls);
 }
+
+
+void FunapiTcpTransportOption::SetUseKernelTLS(const bool use_kernel_tls) {
+  impl_->SetUseKernelTLS(use_kernel_tls);
+}
 #endif
 
 
@@ -578,6 +704,11 @@ bool FunapiTcpTransportOption::GetUseTLS() {
 }
 
 
+bool FunapiTcpTransportOption::GetUseKernelTLS() {
+  return impl_->GetUseKernelTLS();
+}
+
+
 #ifdef FUNAPI_UE4_PLATFORM_PS4
 void FunapiTcpTransportOption::SetCACert(const fun::string &cert) {
   impl_->SetCACertFilePath(cert);
@@ -604,6 +735,18 @@ fun::vector<CompressionType> FunapiTcpTransportOption::GetCompressionTypes() {
 }
 
 
+void FunapiTcpTransportOption::SetCompressionPolicy(const fun::string &msg_type,
+                                                      const CompressionPolicy policy,
+                                                      const int threshold) {
+  impl_->SetCompressionPolicy(msg_type, policy, threshold);
+}
+
+
+fun::vector<CompressionRule> FunapiTcpTransportOption::GetCompressionRules() {
+  return impl_->GetCompressionRules();
+}
+
+
 #if FUNAPI_HAVE_ZSTD
 //void FunapiTcpTransportOption::SetZstdDictBase64String(const fun::string &zstd_dict_base64string) {
 //  impl_->SetZstdDictBase64String(zstd_dict_base64string);
@@ -613,6 +756,28 @@ fun::vector<CompressionType> FunapiTcpTransportOption::GetCompressionTypes() {
 fun::string FunapiTcpTransportOption::GetZstdDictBase64String() {
   return impl_->GetZstdDictBase64String();
 }
+
+
+void FunapiTcpTransportOption::AddZstdDictBase64String(const fun::string &zstd_dict_base64string) {
+  impl_->AddZstdDictBase64String(zstd_dict_base64string);
+}
+
+
+fun::vector<fun::string> FunapiTcpTransportOption::GetZstdDictBase64Strings() {
+  return impl_->GetZstdDictBase64Strings();
+}
+#endif
+
+
+#if FUNAPI_HAVE_LZ4
+void FunapiTcpTransportOption::SetLz4DictBase64String(const fun::string &lz4_dict_base64string) {
+  impl_->SetLz4DictBase64String(lz4_dict_base64string);
+}
+
+
+fun::string FunapiTcpTransportOption::GetLz4DictBase64String() {
+  return impl_->GetLz4DictBase64String();
+}
 #endif
 
 
@@ -649,6 +814,18 @@ fun::vector<CompressionType> FunapiUdpTransportOption::GetCompressionTypes() {
 }
 
 
+void FunapiUdpTransportOption::SetCompressionPolicy(const fun::string &msg_type,
+                                                      const CompressionPolicy policy,
+                                                      const int threshold) {
+  impl_->SetCompressionPolicy(msg_type, policy, threshold);
+}
+
+
+fun::vector<CompressionRule> FunapiUdpTransportOption::GetCompressionRules() {
+  return impl_->GetCompressionRules();
+}
+
+
 #if FUNAPI_HAVE_ZSTD
 //void FunapiUdpTransportOption::SetZstdDictBase64String(const fun::string &zstd_dict_base64string) {
 //  impl_->SetZstdDictBase64String(zstd_dict_base64string);
@@ -661,6 +838,18 @@ fun::string FunapiUdpTransportOption::GetZstdDictBase64String() {
 #endif
 
 
+#if FUNAPI_HAVE_LZ4
+void FunapiUdpTransportOption::SetLz4DictBase64String(const fun::string &lz4_dict_base64string) {
+  impl_->SetLz4DictBase64String(lz4_dict_base64string);
+}
+
+
+fun::string FunapiUdpTransportOption::GetLz4DictBase64String() {
+  return impl_->GetLz4DictBase64String();
+}
+#endif
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // FunapiHttpTransportOption implementation.
 
@@ -787,6 +976,18 @@ fun::vector<CompressionType> FunapiWebsocketTransportOption::GetCompressionTypes
 }
 
 
+void FunapiWebsocketTransportOption::SetCompressionPolicy(const fun::string &msg_type,
+                                                            const CompressionPolicy policy,
+                                                            const int threshold) {
+  impl_->SetCompressionPolicy(msg_type, policy, threshold);
+}
+
+
+fun::vector<CompressionRule> FunapiWebsocketTransportOption::GetCompressionRules() {
+  return impl_->GetCompressionRules();
+}
+
+
 #if FUNAPI_HAVE_ZSTD
 //void FunapiWebsocketTransportOption::SetZstdDictBase64String(const fun::string &zstd_dict_base64string) {
 //  impl_->SetZstdDictBase64String(zstd_dict_base64string);
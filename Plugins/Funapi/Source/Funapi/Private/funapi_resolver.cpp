@@ -0,0 +1,312 @@
+// Copyright (C) 2020 iFunFactory Inc. All Rights Reserved.
+//
+// This work is confidential and proprietary to iFunFactory Inc. and
+// must not be used, disclosed, copied, or distributed without the prior
+// consent of iFunFactory Inc.
+
+#ifndef FUNAPI_UE4_PLATFORM_PS4
+
+#include "funapi_resolver.h"
+
+#ifdef FUNAPI_UE4
+#include "FunapiPrivatePCH.h"
+#endif // FUNAPI_UE4
+
+#include "funapi_utils.h"
+#include "funapi_tasks.h"
+#include "funapi_socket.h"
+
+namespace fun {
+
+////////////////////////////////////////////////////////////////////////////////
+// FunapiResolverImpl implementation.
+
+class FunapiResolverImpl {
+ public:
+  typedef FunapiResolver::ResolveHandler ResolveHandler;
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
+  FunapiResolverImpl();
+  virtual ~FunapiResolverImpl() = default;
+
+  static FunapiResolverImpl& Get();
+
+  void Resolve(const fun::string &hostname_or_ip,
+               const int port,
+               const int socktype,
+               const int network_thread_index,
+               const ResolveHandler &handler);
+
+  void SetCacheTTL(const time_t positive_seconds, const time_t negative_seconds);
+  void ClearCache();
+
+  void SetHostEntry(const fun::string &hostname, const fun::string &ip);
+  void RemoveHostEntry(const fun::string &hostname);
+
+  uint64_t GetLookupCount();
+
+ private:
+  struct Result {
+    std::shared_ptr<FunapiAddrInfo> addrinfo;
+    int error_code = 0;
+    fun::string error_string;
+    TimePoint expired_time;
+  };
+
+  struct Waiter {
+    int network_thread_index;
+    ResolveHandler handler;
+  };
+
+  static fun::string MakeKey(const fun::string &hostname_or_ip,
+                             const int port,
+                             const int socktype);
+
+  void Lookup(const fun::string &key,
+              const fun::string &hostname_or_ip,
+              const int port,
+              const int socktype);
+
+  static void Complete(const Waiter &waiter, const Result &result);
+
+  std::mutex mutex_;
+  fun::unordered_map<fun::string, Result> cache_;
+  fun::unordered_map<fun::string, fun::vector<Waiter>> pending_;
+  fun::unordered_map<fun::string, fun::string> hosts_;
+
+  time_t positive_ttl_seconds_ = 60;
+  time_t negative_ttl_seconds_ = 5;
+
+  uint64_t lookup_count_ = 0;
+};
+
+
+FunapiResolverImpl::FunapiResolverImpl() {
+}
+
+
+FunapiResolverImpl& FunapiResolverImpl::Get() {
+  static FunapiResolverImpl resolver;
+  return resolver;
+}
+
+
+fun::string FunapiResolverImpl::MakeKey(const fun::string &hostname_or_ip,
+                                        const int port,
+                                        const int socktype) {
+  fun::stringstream ss;
+  ss << hostname_or_ip << ":" << port << "/" << socktype;
+  return ss.str();
+}
+
+
+void FunapiResolverImpl::Resolve(const fun::string &hostname_or_ip,
+                                 const int port,
+                                 const int socktype,
+                                 const int network_thread_index,
+                                 const ResolveHandler &handler) {
+  const fun::string key = MakeKey(hostname_or_ip, port, socktype);
+
+  Waiter waiter;
+  waiter.network_thread_index = network_thread_index;
+  waiter.handler = handler;
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    auto iter = cache_.find(key);
+    if (iter != cache_.end()) {
+      if (std::chrono::steady_clock::now() < iter->second.expired_time) {
+        Result result = iter->second;
+        lock.unlock();
+
+        // 캐시에 있어도 조회한 경우와 같이 네트워크 스레드에서 결과를 넘긴다.
+        Complete(waiter, result);
+        return;
+      }
+
+      cache_.erase(iter);
+    }
+
+    // 같은 주소를 조회하는 중이면 결과를 같이 받는다.
+    auto pending_iter = pending_.find(key);
+    if (pending_iter != pending_.end()) {
+      pending_iter->second.push_back(waiter);
+      return;
+    }
+
+    pending_[key].push_back(waiter);
+  }
+
+  if (auto t = FunapiThread::Get("_resolver")) {
+    t->Push([this, key, hostname_or_ip, port, socktype]()->bool {
+      Lookup(key, hostname_or_ip, port, socktype);
+      return true;
+    });
+  }
+}
+
+
+void FunapiResolverImpl::Lookup(const fun::string &key,
+                                const fun::string &hostname_or_ip,
+                                const int port,
+                                const int socktype) {
+#ifdef FUNAPI_COCOS2D_PLATFORM_WINDOWS
+  static auto wsa_init = FunapiInit::Create([](){
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+  }, [](){
+    WSACleanup();
+  });
+#endif
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = socktype;
+
+  fun::string node = hostname_or_ip;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto iter = hosts_.find(hostname_or_ip);
+    if (iter != hosts_.end()) {
+      node = iter->second;
+      hints.ai_flags |= AI_NUMERICHOST;
+    }
+
+    ++lookup_count_;
+  }
+
+  fun::stringstream ss_port;
+  ss_port << port;
+
+  Result result;
+  struct addrinfo *addrinfo_res = nullptr;
+  result.error_code = getaddrinfo(node.c_str(), ss_port.str().c_str(), &hints, &addrinfo_res);
+  if (result.error_code) {
+    result.error_string = (char*)gai_strerror(result.error_code);
+  }
+  else {
+    result.addrinfo = FunapiAddrInfo::Create(addrinfo_res);
+  }
+
+  fun::vector<Waiter> waiters;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    const time_t ttl_seconds = result.addrinfo ? positive_ttl_seconds_ : negative_ttl_seconds_;
+    result.expired_time = std::chrono::steady_clock::now() + std::chrono::seconds(ttl_seconds);
+    if (ttl_seconds > 0) {
+      cache_[key] = result;
+    }
+
+    auto iter = pending_.find(key);
+    if (iter != pending_.end()) {
+      waiters.swap(iter->second);
+      pending_.erase(iter);
+    }
+  }
+
+  for (auto &waiter : waiters) {
+    Complete(waiter, result);
+  }
+}
+
+
+void FunapiResolverImpl::Complete(const Waiter &waiter, const Result &result) {
+  if (!waiter.handler) {
+    return;
+  }
+
+  // 소켓은 자신의 네트워크 스레드에서만 다뤄야 하므로 결과를 그 스레드로 넘긴다.
+  auto handler = waiter.handler;
+  auto t = FunapiThread::Get(FunapiThread::GetNetworkThreadId(waiter.network_thread_index));
+  if (t) {
+    t->Push([handler, result]()->bool {
+      handler(result.addrinfo == nullptr, result.error_code, result.error_string, result.addrinfo);
+      return true;
+    });
+  }
+}
+
+
+void FunapiResolverImpl::SetCacheTTL(const time_t positive_seconds, const time_t negative_seconds) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  positive_ttl_seconds_ = positive_seconds;
+  negative_ttl_seconds_ = negative_seconds;
+}
+
+
+void FunapiResolverImpl::ClearCache() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cache_.clear();
+}
+
+
+void FunapiResolverImpl::SetHostEntry(const fun::string &hostname, const fun::string &ip) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  hosts_[hostname] = ip;
+  cache_.clear();
+}
+
+
+void FunapiResolverImpl::RemoveHostEntry(const fun::string &hostname) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  hosts_.erase(hostname);
+  cache_.clear();
+}
+
+
+uint64_t FunapiResolverImpl::GetLookupCount() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return lookup_count_;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// FunapiResolver implementation.
+
+void FunapiResolver::Resolve(const fun::string &hostname_or_ip,
+                             const int port,
+                             const int socktype,
+                             const int network_thread_index,
+                             const ResolveHandler &handler) {
+  FunapiResolverImpl::Get().Resolve(hostname_or_ip, port, socktype, network_thread_index, handler);
+}
+
+
+void FunapiResolver::Prefetch(const fun::string &hostname_or_ip,
+                              const int port,
+                              const int socktype) {
+  FunapiResolverImpl::Get().Resolve(hostname_or_ip, port, socktype, 0, nullptr);
+}
+
+
+void FunapiResolver::SetCacheTTL(const time_t positive_seconds,
+                                 const time_t negative_seconds) {
+  FunapiResolverImpl::Get().SetCacheTTL(positive_seconds, negative_seconds);
+}
+
+
+void FunapiResolver::ClearCache() {
+  FunapiResolverImpl::Get().ClearCache();
+}
+
+
+void FunapiResolver::SetHostEntry(const fun::string &hostname, const fun::string &ip) {
+  FunapiResolverImpl::Get().SetHostEntry(hostname, ip);
+}
+
+
+void FunapiResolver::RemoveHostEntry(const fun::string &hostname) {
+  FunapiResolverImpl::Get().RemoveHostEntry(hostname);
+}
+
+
+uint64_t FunapiResolver::GetLookupCount() {
+  return FunapiResolverImpl::Get().GetLookupCount();
+}
+
+}  // namespace fun
+
+#endif // FUNAPI_UE4_PLATFORM_PS4
@@ -15,6 +15,7 @@
 #include "funapi_utils.h"
 #include "funapi_tasks.h"
 #include "funapi_socket.h"
+#include "funapi_send_flag_manager.h"
 
 #define kRpcAddMessageType "_sys_ds_add_server"
 #define kRpcDelMessageType "_sys_ds_del_server"
@@ -102,6 +103,9 @@ class FunapiRpcImpl : public std::enable_shared_from_this<FunapiRpcImpl> {
   void SetPeerEventHanderReconnect(const fun::string &peer_id, std::shared_ptr<FunapiRpcPeer> peer);
   void CallMasterMessage();
 
+  // 연결에 실패했으면 연결 시간 제한만큼 기다린 뒤 네트워크 스레드에서 reconnect 를 호출한다.
+  void Reconnect(const EventType type, const std::function<void()> &reconnect);
+
  private:
   std::shared_ptr<FunapiTasks> tasks_;
 
@@ -178,8 +182,9 @@ class FunapiRpcPeer : public std::enable_shared_from_this<FunapiRpcPeer> {
   bool EmptySendQueue();
   void PushSendQueue(const FunDedicatedServerRpcMessage &message);
   void PushSendQueue(std::shared_ptr<FunapiRpcMessage> message);
+  void RequestSend();
   void ClearSendQueue();
-  void PushConnectThread();
+  void ConnectTcp();
 
  private:
   State state_ = State::kDisconnected;
@@ -190,6 +195,7 @@ class FunapiRpcPeer : public std::enable_shared_from_this<FunapiRpcPeer> {
 
   std::shared_ptr<FunapiThread> network_thread_ = nullptr;
   std::shared_ptr<FunapiTasks> tasks_ =  nullptr;
+  // PushSendQueue() 가 사용자 스레드에서 RequestSend() 를 부르므로 std::atomic_load/store 로만 다룬다.
   std::shared_ptr<FunapiTcp> tcp_ = nullptr;
 
   fun::vector<uint8_t> recv_buffer_;
@@ -243,9 +249,10 @@ void FunapiRpcPeer::OnSend() {
 #endif
   }
 
-  if (!buffer.empty()) {
+  auto tcp = std::atomic_load(&tcp_);
+  if (tcp && !buffer.empty()) {
     std::weak_ptr<FunapiRpcPeer> weak = shared_from_this();
-    tcp_->Send
+    tcp->Send
     (buffer,
      [weak, this]
      (const bool is_failed,
@@ -354,23 +361,28 @@ void FunapiRpcPeer::OnConnectCompletion(const bool isFailed,
   else {
     SetState(State::kConnected);
     OnEvent(EventType::kConnected);
+
+    // 연결되기 전에 쌓인 메시지를 보낸다.
+    RequestSend();
   }
 }
 
 
-void FunapiRpcPeer::PushConnectThread() {
+void FunapiRpcPeer::ConnectTcp() {
   SetState(State::kConnecting);
 
   // Tries to connect.
   DebugUtils::Log("Try to tcp connect to server: %s %d", hostname_or_ip_.c_str(), port_);
 
-  tcp_ = FunapiTcp::Create();
+  auto tcp = FunapiTcp::Create();
+  std::atomic_store(&tcp_, tcp);
   std::weak_ptr<FunapiRpcPeer> weak = shared_from_this();
 
-  if (auto ct = FunapiThread::Get("_connect")) {
-    ct->Push([this, weak](){
+  // NOTE: 연결은 네트워크 스레드의 Poll() 에서 진행되므로 연결마다 스레드를 막지 않는다.
+  if (network_thread_) {
+    network_thread_->Push([this, weak, tcp](){
       if (auto peer = weak.lock()) {
-        tcp_->Connect
+        tcp->Connect
         (hostname_or_ip_.c_str(),
          port_,
          10,
@@ -420,7 +432,7 @@ void FunapiRpcPeer::OnConnect(fun::string hostname_or_ip, int port) {
     hostname_or_ip_ = hostname_or_ip;
     port_ = port;
 
-    PushConnectThread();
+    ConnectTcp();
   }
 }
 
@@ -443,7 +455,7 @@ void FunapiRpcPeer::OnDisconnecting() {
   SetState(State::kDisconnecting);
   if (EmptySendQueue()) {
     PushNetworkThread([this]()->bool {
-      tcp_ = nullptr;
+      std::atomic_store(&tcp_, std::shared_ptr<FunapiTcp>());
       SetState(State::kDisconnected);
       OnEvent(EventType::kDisconnected);
       return true;
@@ -552,14 +564,33 @@ bool FunapiRpcPeer::EmptySendQueue() {
 
 
 void FunapiRpcPeer::PushSendQueue(const FunDedicatedServerRpcMessage &message) {
-  std::unique_lock<std::mutex> lock(send_queue_mutex_);
-  send_queue_.push_back(std::make_shared<FunapiRpcMessage>(message));
+  {
+    std::unique_lock<std::mutex> lock(send_queue_mutex_);
+    send_queue_.push_back(std::make_shared<FunapiRpcMessage>(message));
+  }
+
+  RequestSend();
 }
 
 
 void FunapiRpcPeer::PushSendQueue(std::shared_ptr<FunapiRpcMessage> message) {
-  std::unique_lock<std::mutex> lock(send_queue_mutex_);
-  send_queue_.push_back(message);
+  {
+    std::unique_lock<std::mutex> lock(send_queue_mutex_);
+    send_queue_.push_back(message);
+  }
+
+  RequestSend();
+}
+
+
+void FunapiRpcPeer::RequestSend() {
+  // 연결 중이면 연결이 끝난 뒤에 보내므로 스레드만 깨운다.
+  if (auto tcp = std::atomic_load(&tcp_)) {
+    tcp->RequestSend();
+  }
+  else {
+    FunapiSendFlagManager::Get().Signal();
+  }
 }
 
 
@@ -812,25 +843,17 @@ void FunapiRpcImpl::Connect(const int index) {
           peer_set_.erase(this_peer);
         }
 
-        if (type == EventType::kConnectionFailed) {
-          if (auto ct = FunapiThread::Get("_connect")) {
-            auto option = rpc_option_;
-            ct->Push([option]()->bool{
-              std::this_thread::sleep_for(std::chrono::seconds(option->GetConnectTimeout()));
-              return true;
-            });
-          }
-        }
-
         int new_index = 0;
         auto &v = rpc_option_->GetInitializers();
         if ((index+1) < static_cast<int>(v.size())) {
           new_index = index + 1;
         }
 
-        tasks_->Push([this, new_index]()->bool{
-          Connect(new_index);
-          return true;
+        Reconnect(type, [this, new_index]() {
+          tasks_->Push([this, new_index]()->bool{
+            Connect(new_index);
+            return true;
+          });
         });
       }
     }
@@ -905,17 +928,9 @@ void FunapiRpcImpl::SetPeerEventHanderReconnect(const fun::string &peer_id, std:
         }
 
         if (reconnect) {
-          if (type == EventType::kConnectionFailed) {
-            if (auto ct = FunapiThread::Get("_connect")) {
-              auto option = rpc_option_;
-              ct->Push([option]()->bool {
-                std::this_thread::sleep_for(std::chrono::seconds(option->GetConnectTimeout()));
-                return true;
-              });
-            }
-          }
-
-          Connect(peer_id, peer_hostname_or_ip, peer_port);
+          Reconnect(type, [this, peer_id, peer_hostname_or_ip, peer_port]() {
+            Connect(peer_id, peer_hostname_or_ip, peer_port);
+          });
         }
       }
     }
@@ -925,6 +940,24 @@ void FunapiRpcImpl::SetPeerEventHanderReconnect(const fun::string &peer_id, std:
 }
 
 
+void FunapiRpcImpl::Reconnect(const EventType type, const std::function<void()> &reconnect) {
+  if (type != EventType::kConnectionFailed) {
+    reconnect();
+    return;
+  }
+
+  // NOTE: 기다리는 동안 다른 연결이 막히지 않도록 스레드를 재우지 않고 타이머를 사용한다.
+  std::weak_ptr<FunapiRpcImpl> weak = shared_from_this();
+  auto expired_time = std::chrono::steady_clock::now() +
+                      std::chrono::seconds(rpc_option_->GetConnectTimeout());
+  FunapiSocket::AddTimer(0, expired_time, [weak, reconnect]() {
+    if (auto impl = weak.lock()) {
+      reconnect();
+    }
+  });
+}
+
+
 void FunapiRpcImpl::Connect(const fun::string &peer_id, const fun::string &hostname_or_ip, const int port) {
   std::shared_ptr<FunapiRpcPeer> peer = nullptr;
   {
@@ -973,15 +1006,6 @@ void FunapiRpcImpl::Update() {
   if (tasks_) {
     tasks_->Update();
   }
-
-  if (auto nt = FunapiThread::Get("_network")) {
-    if (nt->Size() == 0) {
-      nt->Push([]()->bool {
-        FunapiSocket::Poll();
-        return true;
-      });
-    }
-  }
 }
 
 
@@ -12,6 +12,10 @@
 
 #include "funapi_utils.h"
 
+#if FUNAPI_HAVE_EVENTFD
+#include <sys/eventfd.h>
+#endif // FUNAPI_HAVE_EVENTFD
+
 
 namespace fun
 {
@@ -24,40 +28,71 @@ FunapiSendFlagManager::FunapiSendFlagManager()
 {
   FunapiUtil::Assert(the_manager == nullptr);
 
-  if (pipe(pipe_fds_) < 0)
-  {
-    fun::stringstream ss;
-    ss << "Failed to initilize FunapiSendFlagManager,";
-    ss << " error code : " << errno << " error : " << strerror(errno);
-
-    FunapiUtil::Assert(false, ss.str());
-  }
+  // 첫 번째 네트워크 스레드의 채널은 미리 만들어 둔다.
+  GetChannel(0);
 }
 
 
 FunapiSendFlagManager::~FunapiSendFlagManager()
 {
-  if (pipe_fds_[0] >= 0)
+  for (auto &channel : channels_)
   {
-    close(pipe_fds_[0]);
+#if FUNAPI_HAVE_EVENTFD
+    if (channel.event_fd_ >= 0)
+    {
+      close(channel.event_fd_);
+    }
+#else // FUNAPI_HAVE_EVENTFD
+    if (channel.pipe_fds_[0] >= 0)
+    {
+      close(channel.pipe_fds_[0]);
+    }
+    if (channel.pipe_fds_[1] >= 0)
+    {
+      close(channel.pipe_fds_[1]);
+    }
+#endif // FUNAPI_HAVE_EVENTFD
   }
-  if (pipe_fds_[1] >= 0)
+}
+
+
+void FunapiSendFlagManager::InitChannel(Channel &channel)
+{
+#if FUNAPI_HAVE_EVENTFD
+  channel.event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (channel.event_fd_ < 0)
+#else // FUNAPI_HAVE_EVENTFD
+  if (pipe(channel.pipe_fds_) < 0)
+#endif // FUNAPI_HAVE_EVENTFD
   {
-    close(pipe_fds_[1]);
+    fun::stringstream ss;
+    ss << "Failed to initilize FunapiSendFlagManager,";
+    ss << " error code : " << errno << " error : " << strerror(errno);
+
+    FunapiUtil::Assert(false, ss.str());
   }
 }
 
 
-int* FunapiSendFlagManager::GetPipeFds()
+int FunapiSendFlagManager::GetWakeUpFd(const int index)
 {
-  return pipe_fds_;
+#if FUNAPI_HAVE_EVENTFD
+  return GetChannel(index).event_fd_;
+#else // FUNAPI_HAVE_EVENTFD
+  return GetChannel(index).pipe_fds_[0];
+#endif // FUNAPI_HAVE_EVENTFD
 }
 
 
-void FunapiSendFlagManager::WakeUp()
+void FunapiSendFlagManager::SignalChannel(Channel &channel)
 {
+#if FUNAPI_HAVE_EVENTFD
+  const uint64_t kDummyValue = 1;
+  if (write(channel.event_fd_, &kDummyValue, sizeof(uint64_t)) < 0)
+#else // FUNAPI_HAVE_EVENTFD
   const int64_t kDummyValue = 1;
-  if (not write(pipe_fds_[1], &kDummyValue, sizeof(int64_t)))
+  if (not write(channel.pipe_fds_[1], &kDummyValue, sizeof(int64_t)))
+#endif // FUNAPI_HAVE_EVENTFD
   {
     DebugUtils::Log("Failed to wakeup funapi send flag, error code: %d error : %s",
                     errno,
@@ -66,10 +101,15 @@ void FunapiSendFlagManager::WakeUp()
 }
 
 
-void FunapiSendFlagManager::ResetWakeUp()
+void FunapiSendFlagManager::ResetChannel(Channel &channel)
 {
+#if FUNAPI_HAVE_EVENTFD
+  uint64_t value = 0;
+  if (read(channel.event_fd_, &value, sizeof(uint64_t)) < 0 && errno != EAGAIN)
+#else // FUNAPI_HAVE_EVENTFD
   int64_t value = 0;
-  if (not read(pipe_fds_[0], &value, sizeof(int64_t)))
+  if (not read(channel.pipe_fds_[0], &value, sizeof(int64_t)))
+#endif // FUNAPI_HAVE_EVENTFD
   {
     DebugUtils::Log("Failed to reset funapi send flag, error code: %d error : %s",
                     errno,
@@ -83,8 +123,28 @@ void FunapiSendFlagManager::ResetWakeUp()
 
 FunapiSendFlagManager::FunapiSendFlagManager()
 {
-  event_ = WSACreateEvent();
-  if (event_ == WSA_INVALID_EVENT)
+  // 첫 번째 네트워크 스레드의 채널은 미리 만들어 둔다.
+  GetChannel(0);
+}
+
+
+FunapiSendFlagManager::~FunapiSendFlagManager()
+{
+  for (auto &channel : channels_)
+  {
+    if (channel.event_ != nullptr && channel.event_ != WSA_INVALID_EVENT)
+    {
+      WSACloseEvent(channel.event_);
+    }
+    channel.event_ = WSA_INVALID_EVENT;
+  }
+}
+
+
+void FunapiSendFlagManager::InitChannel(Channel &channel)
+{
+  channel.event_ = WSACreateEvent();
+  if (channel.event_ == WSA_INVALID_EVENT)
   {
     int error_cd = FunapiUtil::GetSocketErrorCode();
     fun::string error_str = FunapiUtil::GetSocketErrorString(error_cd);
@@ -97,25 +157,15 @@ FunapiSendFlagManager::FunapiSendFlagManager()
 }
 
 
-FunapiSendFlagManager::~FunapiSendFlagManager()
-{
-  if (event_ != WSA_INVALID_EVENT)
-  {
-    WSACloseEvent(event_);
-  }
-  event_ = WSA_INVALID_EVENT;
-}
-
-
-HANDLE FunapiSendFlagManager::GetEvent()
+HANDLE FunapiSendFlagManager::GetEvent(const int index)
 {
-  return event_;
+  return GetChannel(index).event_;
 }
 
 
-void FunapiSendFlagManager::WakeUp()
+void FunapiSendFlagManager::SignalChannel(Channel &channel)
 {
-  if (SetEvent(event_) == 0)
+  if (SetEvent(channel.event_) == 0)
   {
     int error_cd = FunapiUtil::GetSocketErrorCode();
     DebugUtils::Log("Failed to wakeup funapi send flag, error code: %d error : %s",
@@ -125,9 +175,9 @@ void FunapiSendFlagManager::WakeUp()
 }
 
 
-void FunapiSendFlagManager::ResetWakeUp()
+void FunapiSendFlagManager::ResetChannel(Channel &channel)
 {
-  if (ResetEvent(event_) == 0)
+  if (ResetEvent(channel.event_) == 0)
   {
     int error_cd = FunapiUtil::GetSocketErrorCode();
     DebugUtils::Log("Failed to reset funapi send flag, error code: %d error : %s",
@@ -156,4 +206,50 @@ FunapiSendFlagManager& FunapiSendFlagManager::Get()
   return *the_manager;
 }
 
+
+void FunapiSendFlagManager::WakeUp(const int index)
+{
+  Channel &channel = GetChannel(index);
+  channel.wakeup_all_.store(true);
+  Signal(index);
+}
+
+
+void FunapiSendFlagManager::Signal(const int index)
+{
+  // NOTE: 깨어난 스레드가 ResetWakeUp() 을 호출하기 전까지의 요청은 한 번의 신호로 합친다.
+  Channel &channel = GetChannel(index);
+  if (!channel.signalled_.exchange(true))
+  {
+    SignalChannel(channel);
+  }
+}
+
+
+bool FunapiSendFlagManager::ResetWakeUp(const int index)
+{
+  // NOTE: 신호를 비운 다음에 플래그를 내린다. 순서가 바뀌면 그 사이에 보낸 신호가
+  // 지워진 채로 플래그만 남아 다시는 깨어나지 못한다.
+  // 플래그를 내리기 전에 들어온 요청은 호출한 쪽에서 이어서 처리한다.
+  Channel &channel = GetChannel(index);
+  ResetChannel(channel);
+  channel.signalled_.store(false);
+
+  return channel.wakeup_all_.exchange(false);
+}
+
+
+FunapiSendFlagManager::Channel& FunapiSendFlagManager::GetChannel(const int index)
+{
+  FunapiUtil::Assert(index >= 0 && index < FunapiThread::kMaxNetworkThreadCount);
+
+  // 네트워크 스레드는 필요할 때 생성되므로 채널도 처음 사용될 때 만든다.
+  Channel &channel = channels_[index];
+  std::call_once(channel.init_flag, [this, &channel]() {
+    InitChannel(channel);
+  });
+
+  return channel;
+}
+
 } // namespace fun
@@ -8,6 +8,7 @@
 #define SRC_FUNAPI_SEND_FLAG_MANAGER_H_
 
 #include "funapi_plugin.h"
+#include "funapi_tasks.h"
 
 namespace fun {
 
@@ -18,33 +19,65 @@ class FUNAPI_API FunapiSendFlagManager :
   static void Init();
   static FunapiSendFlagManager& Get();
 
-  void WakeUp();
-  void ResetWakeUp();
+  // index 는 깨울 네트워크 스레드의 번호이다.
+  // WakeUp() 은 해당 스레드의 모든 소켓이 보낼 메시지를 확인하게 한다.
+  void WakeUp(const int index = 0);
+
+  // 스레드만 깨운다. 어떤 소켓을 처리할 지는 호출한 쪽에서 따로 알려 준다.
+  // 이미 깨우는 중이면 시스템 콜 없이 돌아온다.
+  void Signal(const int index = 0);
+
+  // 깨어난 스레드가 호출한다. WakeUp() 이 불렸었다면 true 를 돌려준다.
+  bool ResetWakeUp(const int index = 0);
 
   virtual ~FunapiSendFlagManager();
 
  private:
   FunapiSendFlagManager();
 
+  struct Channel;
+  Channel& GetChannel(const int index);
+  void InitChannel(Channel &channel);
+  void SignalChannel(Channel &channel);
+  void ResetChannel(Channel &channel);
+
 
 #ifdef FUNAPI_PLATFORM_WINDOWS
 
  public:
-  HANDLE GetEvent();
+  HANDLE GetEvent(const int index = 0);
 
  private:
-  HANDLE event_ = nullptr;
+  struct Channel
+  {
+    std::once_flag init_flag;
+    std::atomic<bool> signalled_{ false };
+    std::atomic<bool> wakeup_all_{ false };
+    HANDLE event_ = nullptr;
+  };
 
 #else
 
  public:
-  int* GetPipeFds();
+  // Poll() 에서 읽기 이벤트를 기다릴 fd.
+  int GetWakeUpFd(const int index = 0);
 
  private:
-  int pipe_fds_[2];
+  struct Channel
+  {
+    std::once_flag init_flag;
+    std::atomic<bool> signalled_{ false };
+    std::atomic<bool> wakeup_all_{ false };
+#if FUNAPI_HAVE_EVENTFD
+    int event_fd_ = -1;
+#else // FUNAPI_HAVE_EVENTFD
+    int pipe_fds_[2] = { -1, -1 };
+#endif // FUNAPI_HAVE_EVENTFD
+  };
 
 #endif
 
+  Channel channels_[FunapiThread::kMaxNetworkThreadCount];
 };
 
 } // namespace fun
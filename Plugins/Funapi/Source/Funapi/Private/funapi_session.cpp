@@ -15,17 +15,17 @@
 #include "funapi_tasks.h"
 #include "funapi_http.h"
 #include "funapi_socket.h"
+#include "funapi_resolver.h"
 #include "funapi_websocket.h"
 #include "funapi_encryption.h"
 #include "funapi_compression.h"
 #include "funapi_version.h"
+#include "funapi_header_view.h"
 #include "funapi/network/ping_message.pb.h"
 #include "funapi/service/redirect_message.pb.h"
 
 #define kHeaderDelimeter "\n"
 #define kHeaderFieldDelimeter ":"
-#define kVersionHeaderField "VER"
-#define kPluginVersionHeaderField "PVER"
 
 #define kMessageTypeAttributeName "_msgtype"
 #define kSessionIdAttributeName "_sid"
@@ -194,6 +194,7 @@ class FunapiQueue : public std::enable_shared_from_this<FunapiQueue> {
   bool Empty();
   std::shared_ptr<FunapiMessage> Front();
   void PushBack(std::shared_ptr<FunapiMessage> msg);
+  void PushFront(std::shared_ptr<FunapiMessage> msg);
   void PopFront();
 
  private:
@@ -234,6 +235,12 @@ void FunapiQueue::PushBack(std::shared_ptr<FunapiMessage> msg) {
 }
 
 
+void FunapiQueue::PushFront(std::shared_ptr<FunapiMessage> msg) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_.push_front(msg);
+}
+
+
 void FunapiQueue::PopFront() {
   std::unique_lock<std::mutex> lock(mutex_);
   queue_.pop_front();
@@ -390,6 +397,347 @@ void FunapiSessionId::Set(const fun::string &session_id, const FunEncoding encod
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+// FunapiSharedPayloadImpl implementation.
+
+// body 의 offset 부터 들어 있는 json 객체에 members 객체의 필드를 이어 쓴다.
+// 둘 다 '{' 로 시작해서 '}' 로 끝나므로 body 의 '}' 자리에 ',' 를 쓰고 members 의 '{' 뒤를 붙인다.
+static void AppendJsonMembers(fun::vector<uint8_t> &body, const size_t offset,
+                              const char *members, const size_t members_size)
+{
+    if (members_size <= 2)
+    {
+        return;
+    }
+
+    if (body.size() - offset <= 2)
+    {
+        body.resize(offset);
+        body.insert(body.end(), members, members + members_size);
+        return;
+    }
+
+    body.back() = ',';
+    body.insert(body.end(), members + 1, members + members_size);
+}
+
+
+// 세션마다 채우는 필드 이름인지 확인한다.
+static bool IsReservedJsonMember(const char *name, const size_t length)
+{
+    static const char *reserved[] = { kMessageTypeAttributeName, kSessionIdAttributeName,
+                                      kSeqNumAttributeName, kAckNumAttributeName };
+
+    for (auto r : reserved)
+    {
+        if (strlen(r) == length && memcmp(r, name, length) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+// DOM 을 만들지 않고 최상위 객체의 키만 검사한다.
+class FunapiJsonMemberChecker
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, FunapiJsonMemberChecker>
+{
+public:
+    bool Default() { return true; }
+    bool StartObject() { ++depth_; return true; }
+    bool EndObject(rapidjson::SizeType) { --depth_; return true; }
+    bool Key(const char *str, rapidjson::SizeType length, bool)
+    {
+        if (depth_ == 1 && IsReservedJsonMember(str, length))
+        {
+            has_reserved_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool HasReserved() const { return has_reserved_; }
+
+private:
+    int depth_ = 0;
+    bool has_reserved_ = false;
+};
+
+
+class FunapiSharedPayloadImpl : public std::enable_shared_from_this<FunapiSharedPayloadImpl>
+{
+public:
+    FunapiSharedPayloadImpl() = delete;
+    FunapiSharedPayloadImpl(const fun::string &msg_type, const fun::string &json_string);
+    FunapiSharedPayloadImpl(const FunMessage &message);
+    FunapiSharedPayloadImpl(const FunEncoding encoding, const fun::string &msg_type, fun::vector<uint8_t> &&body);
+    virtual ~FunapiSharedPayloadImpl() = default;
+
+    FunEncoding GetEncoding() const;
+    const fun::string& GetMsgType() const;
+    int32_t GetMsgType2() const;
+    const fun::vector<uint8_t>& GetBody() const;
+    bool IsValid() const;
+
+private:
+    bool CheckJsonBody();
+
+    FunEncoding encoding_ = FunEncoding::kNone;
+    fun::string msg_type_;
+    int32_t msg_type2_ = 0;
+    fun::vector<uint8_t> body_;
+    bool valid_ = true;
+};
+
+
+FunapiSharedPayloadImpl::FunapiSharedPayloadImpl(const fun::string &msg_type, const fun::string &json_string)
+    : encoding_(FunEncoding::kJson), msg_type_(msg_type)
+{
+    rapidjson::Document document;
+    document.Parse<0>(json_string.c_str());
+    if (document.HasParseError() || !document.IsObject())
+    {
+        DebugUtils::Log("'%s' shared payload has an invalid json body.", msg_type.c_str());
+        valid_ = false;
+        return;
+    }
+
+    for (auto itr = document.MemberBegin(); itr != document.MemberEnd(); ++itr)
+    {
+        if (IsReservedJsonMember(itr->name.GetString(), itr->name.GetStringLength()))
+        {
+            DebugUtils::Log("'%s' shared payload has a reserved field: %s",
+                            msg_type.c_str(), itr->name.GetString());
+            valid_ = false;
+            return;
+        }
+    }
+
+    if (msg_type.length() > 0)
+    {
+        rapidjson::Value msg_type_node;
+        msg_type_node.SetString(rapidjson::StringRef(msg_type.c_str()), document.GetAllocator());
+        document.AddMember(rapidjson::StringRef(kMessageTypeAttributeName), msg_type_node, document.GetAllocator());
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    document.Accept(writer);
+
+    body_.assign(buffer.GetString(), buffer.GetString() + buffer.GetSize());
+}
+
+
+FunapiSharedPayloadImpl::FunapiSharedPayloadImpl(const FunMessage &message)
+    : encoding_(FunEncoding::kProtobuf)
+{
+    if (message.has_msgtype())
+    {
+        msg_type_ = message.msgtype();
+    }
+
+    if (message.has_msgtype2())
+    {
+        msg_type2_ = message.msgtype2();
+    }
+
+    const int byte_size = message.ByteSize();
+    body_.resize(byte_size);
+    message.SerializeToArray(body_.data(), byte_size);
+}
+
+
+FunapiSharedPayloadImpl::FunapiSharedPayloadImpl(const FunEncoding encoding, const fun::string &msg_type,
+                                                 fun::vector<uint8_t> &&body)
+    : encoding_(encoding), msg_type_(msg_type), body_(std::move(body))
+{
+    // 이미 직렬화한 본문을 그대로 쓰고 메시지 타입만 덧붙인다.
+    if (encoding_ == FunEncoding::kJson)
+    {
+        if (false == CheckJsonBody())
+        {
+            valid_ = false;
+            return;
+        }
+
+        if (msg_type.length() > 0)
+        {
+            rapidjson::Document document;
+            document.SetObject();
+
+            rapidjson::Value msg_type_node;
+            msg_type_node.SetString(rapidjson::StringRef(msg_type.c_str()), document.GetAllocator());
+            document.AddMember(rapidjson::StringRef(kMessageTypeAttributeName), msg_type_node, document.GetAllocator());
+
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            document.Accept(writer);
+
+            AppendJsonMembers(body_, 0, buffer.GetString(), buffer.GetSize());
+        }
+    }
+    else if (encoding_ == FunEncoding::kProtobuf)
+    {
+        // 이어 붙인 protobuf 메시지는 파싱할 때 하나로 합쳐진다.
+        if (msg_type.length() > 0)
+        {
+            FunMessage message;
+            message.set_msgtype(msg_type);
+
+            const size_t body_size = body_.size();
+            const int byte_size = message.ByteSize();
+            body_.resize(body_size + byte_size);
+            message.SerializeToArray(body_.data() + body_size, byte_size);
+        }
+    }
+}
+
+
+FunEncoding FunapiSharedPayloadImpl::GetEncoding() const
+{
+    return encoding_;
+}
+
+
+const fun::string& FunapiSharedPayloadImpl::GetMsgType() const
+{
+    return msg_type_;
+}
+
+
+int32_t FunapiSharedPayloadImpl::GetMsgType2() const
+{
+    return msg_type2_;
+}
+
+
+const fun::vector<uint8_t>& FunapiSharedPayloadImpl::GetBody() const
+{
+    return body_;
+}
+
+
+bool FunapiSharedPayloadImpl::IsValid() const
+{
+    return valid_;
+}
+
+
+// 앞뒤 공백과 끝의 '\0' 을 지우고 본문이 예약 필드가 없는 json 객체인지 확인한다.
+bool FunapiSharedPayloadImpl::CheckJsonBody()
+{
+    auto is_space = [](const uint8_t c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\0';
+    };
+
+    while (false == body_.empty() && is_space(body_.back()))
+    {
+        body_.pop_back();
+    }
+
+    auto first = body_.begin();
+    while (first != body_.end() && is_space(*first))
+    {
+        ++first;
+    }
+    body_.erase(body_.begin(), first);
+
+    if (body_.size() < 2 || body_.front() != '{' || body_.back() != '}')
+    {
+        DebugUtils::Log("'%s' message has an invalid json body.", msg_type_.c_str());
+        return false;
+    }
+
+    // StringStream 은 '\0' 에서 멈추므로 검사하는 동안만 붙여 둔다.
+    body_.push_back('\0');
+    rapidjson::StringStream stream(reinterpret_cast<const char*>(body_.data()));
+    FunapiJsonMemberChecker checker;
+    rapidjson::Reader reader;
+    const bool parsed = !reader.Parse<0>(stream, checker).IsError();
+    body_.pop_back();
+
+    if (checker.HasReserved())
+    {
+        DebugUtils::Log("'%s' message has a reserved field in the json body.", msg_type_.c_str());
+        return false;
+    }
+
+    if (false == parsed || stream.Tell() != body_.size())
+    {
+        DebugUtils::Log("'%s' message has an invalid json body.", msg_type_.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// FunapiSharedPayload implementation.
+
+FunapiSharedPayload::FunapiSharedPayload(const fun::string &msg_type, const fun::string &json_string)
+    : impl_(std::make_shared<FunapiSharedPayloadImpl>(msg_type, json_string))
+{
+}
+
+
+FunapiSharedPayload::FunapiSharedPayload(const FunMessage &message)
+    : impl_(std::make_shared<FunapiSharedPayloadImpl>(message))
+{
+}
+
+
+std::shared_ptr<FunapiSharedPayload> FunapiSharedPayload::Create(const fun::string &msg_type,
+                                                                 const fun::string &json_string)
+{
+    return std::make_shared<FunapiSharedPayload>(msg_type, json_string);
+}
+
+
+std::shared_ptr<FunapiSharedPayload> FunapiSharedPayload::Create(const FunMessage &message)
+{
+    return std::make_shared<FunapiSharedPayload>(message);
+}
+
+
+FunEncoding FunapiSharedPayload::GetEncoding() const
+{
+    return impl_->GetEncoding();
+}
+
+
+const fun::string& FunapiSharedPayload::GetMsgType() const
+{
+    return impl_->GetMsgType();
+}
+
+
+int32_t FunapiSharedPayload::GetMsgType2() const
+{
+    return impl_->GetMsgType2();
+}
+
+
+size_t FunapiSharedPayload::GetSize() const
+{
+    return impl_->GetBody().size();
+}
+
+
+bool FunapiSharedPayload::IsValid() const
+{
+    return impl_->IsValid();
+}
+
+
+std::shared_ptr<FunapiSharedPayloadImpl> FunapiSharedPayload::GetImpl() const
+{
+    return impl_;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // FunapiMessage implementation.
 
@@ -397,23 +745,60 @@ class FunapiMessage : public std::enable_shared_from_this<FunapiMessage> {
 public:
     FunapiMessage() = delete;
     FunapiMessage(const rapidjson::Document &json, const EncryptionType type);
+    FunapiMessage(rapidjson::Document &&json, const EncryptionType type);
     FunapiMessage(const FunMessage &pbuf, const EncryptionType type);
+    FunapiMessage(std::shared_ptr<FunMessage> pbuf, const EncryptionType type);
     FunapiMessage(const fun::vector<uint8_t> &body, const EncryptionType type);
     FunapiMessage(const FunEncoding encoding, const fun::vector<uint8_t> &body, const EncryptionType type);
+    FunapiMessage(std::shared_ptr<FunapiSharedPayloadImpl> payload, const EncryptionType type);
 
     virtual ~FunapiMessage() = default;
 
     static std::shared_ptr<FunapiMessage> Create(const FunEncoding encoding, const fun::vector<uint8_t> &body);
     static std::shared_ptr<FunapiMessage> Create(const rapidjson::Document &json, const EncryptionType type);
     static std::shared_ptr<FunapiMessage> Create(const FunMessage &pbuf, const EncryptionType type);
+
+    // 복사하지 않고 넘겨받은 메시지를 그대로 쓴다.
+    static std::shared_ptr<FunapiMessage> Create(rapidjson::Document &&json, const EncryptionType type);
+    static std::shared_ptr<FunapiMessage> Create(std::shared_ptr<FunMessage> pbuf, const EncryptionType type);
     static std::shared_ptr<FunapiMessage> Create(const fun::vector<uint8_t> &body, const EncryptionType type);
     static std::shared_ptr<FunapiMessage> Create(const FunEncoding encoding, const fun::vector<uint8_t> &body,
                                                  const EncryptionType type);
+    static std::shared_ptr<FunapiMessage> Create(std::shared_ptr<FunapiSharedPayloadImpl> payload,
+                                                 const EncryptionType type);
 
+    // 공유 본문으로 만든 메시지면 GetJsonDocumenet(), GetProtobufMessage() 는
+    // 세션마다 다른 필드(sid, seq, ack)만 담고 있다.
     std::shared_ptr<rapidjson::Document> GetJsonDocumenet();
     std::shared_ptr<FunMessage> GetProtobufMessage();
     fun::vector<uint8_t>& GetBody();
 
+    // 본문 앞에 headroom 바이트를 비워 두고 직렬화한다.
+    // 실제로 비워 둔 크기는 GetBodyOffset() 으로 알 수 있다.
+    fun::vector<uint8_t>& GetBody(const size_t headroom);
+    size_t GetBodyOffset();
+
+    // 소켓에 넘긴 프레임이 소유하는 버퍼. 프레임이 남아 있는 동안 다시 직렬화하면
+    // 이 버퍼를 고치지 않고 새 버퍼를 만든다.
+    std::shared_ptr<const fun::vector<uint8_t>> GetBodyBuffer();
+
+    // 신뢰성 세션에서 재전송할 때 다시 직렬화하지 않도록 처음 보낼 때의 본문을 보관한다.
+    // 암호화는 연결마다 상태가 달라지므로 암호화하기 전의 본문이다.
+    struct EncodedBody {
+      fun::vector<uint8_t> data;
+      // 압축 단계를 거친 본문이면 true 이다. 압축하지 않기로 한 본문도 포함한다.
+      bool compression_applied = false;
+      // 0 이 아니면 압축한 본문이고 헤더의 C 필드 값이다.
+      size_t uncompressed_length = 0;
+      // 0 이 아니면 헤더의 CD 필드 값이다.
+      uint32_t dict_id = 0;
+    };
+    std::shared_ptr<EncodedBody> GetEncodedBody();
+    void SetEncodedBody(std::shared_ptr<EncodedBody> encoded_body);
+
+    // GetBody(headroom) 대신 보관한 본문으로 버퍼를 채운다.
+    fun::vector<uint8_t>& GetBodyFromEncoded(const size_t headroom);
+
     const fun::string& GetMsgType();
     int32_t GetMsgType2();
 
@@ -433,6 +818,9 @@ public:
     void SetInitialized(bool initialized);
 
 private:
+    fun::vector<uint8_t>& GetSharedBody(const size_t headroom);
+    fun::vector<uint8_t>& GetWritableBody(const bool keep_contents);
+
     bool initialized_ = false;
     bool use_sent_queue_ = false;
     bool use_seq_ = false;
@@ -440,9 +828,12 @@ private:
     fun::string msg_type_;
     int32_t msg_type2_ = 0;
     FunEncoding encoding_ = FunEncoding::kNone;
-    fun::vector<uint8_t> body_;
+    std::shared_ptr<fun::vector<uint8_t>> body_ = std::make_shared<fun::vector<uint8_t>>();
+    size_t body_offset_ = 0;
+    std::shared_ptr<EncodedBody> encoded_body_ = nullptr;
     std::shared_ptr<rapidjson::Document> json_document_ = nullptr;
     std::shared_ptr<FunMessage> protobuf_message_ = nullptr;
+    std::shared_ptr<FunapiSharedPayloadImpl> shared_payload_ = nullptr;
     EncryptionType encryption_type_ = EncryptionType::kNoneEncryption;
 };
 
@@ -454,14 +845,27 @@ FunapiMessage::FunapiMessage(const rapidjson::Document &json, const EncryptionTy
 }
 
 
+FunapiMessage::FunapiMessage(rapidjson::Document &&json, const EncryptionType type)
+    : encoding_(FunEncoding::kJson), json_document_(std::make_shared<rapidjson::Document>(std::move(json))),
+      encryption_type_(type)
+{
+}
+
+
 FunapiMessage::FunapiMessage(const FunMessage &message, const EncryptionType type)
     : encoding_(FunEncoding::kProtobuf), protobuf_message_(std::make_shared<FunMessage>(message)), encryption_type_(type)
 {
 }
 
 
+FunapiMessage::FunapiMessage(std::shared_ptr<FunMessage> message, const EncryptionType type)
+    : encoding_(FunEncoding::kProtobuf), protobuf_message_(message), encryption_type_(type)
+{
+}
+
+
 FunapiMessage::FunapiMessage(const fun::vector<uint8_t> &body, const EncryptionType type)
-    : encoding_(FunEncoding::kNone), body_(body), encryption_type_(type)
+    : encoding_(FunEncoding::kNone), body_(std::make_shared<fun::vector<uint8_t>>(body)), encryption_type_(type)
 {
 }
 
@@ -497,7 +901,24 @@ FunapiMessage::FunapiMessage(const FunEncoding encoding, const fun::vector<uint8
     }
     else
     {
-        body_ = body;
+        *body_ = body;
+    }
+}
+
+
+FunapiMessage::FunapiMessage(std::shared_ptr<FunapiSharedPayloadImpl> payload, const EncryptionType type)
+    : msg_type_(payload->GetMsgType()), msg_type2_(payload->GetMsgType2()), encoding_(payload->GetEncoding()),
+      shared_payload_(payload), encryption_type_(type)
+{
+    // 세션마다 다른 필드는 빈 메시지에 채워서 보낼 때 공유 본문에 덧붙인다.
+    if (encoding_ == FunEncoding::kJson)
+    {
+        json_document_ = std::make_shared<rapidjson::Document>();
+        json_document_->SetObject();
+    }
+    else if (encoding_ == FunEncoding::kProtobuf)
+    {
+        protobuf_message_ = std::make_shared<FunMessage>();
     }
 }
 
@@ -514,6 +935,18 @@ std::shared_ptr<FunapiMessage> FunapiMessage::Create(const FunMessage &message,
 }
 
 
+std::shared_ptr<FunapiMessage> FunapiMessage::Create(rapidjson::Document &&json, const EncryptionType type)
+{
+    return std::make_shared<FunapiMessage>(std::move(json), type);
+}
+
+
+std::shared_ptr<FunapiMessage> FunapiMessage::Create(std::shared_ptr<FunMessage> message, const EncryptionType type)
+{
+    return std::make_shared<FunapiMessage>(message, type);
+}
+
+
 std::shared_ptr<FunapiMessage> FunapiMessage::Create(const fun::vector<uint8_t>  &body, const EncryptionType type)
 {
     return std::make_shared<FunapiMessage>(body, type);
@@ -533,6 +966,13 @@ std::shared_ptr<FunapiMessage> FunapiMessage::Create(const FunEncoding encoding,
 }
 
 
+std::shared_ptr<FunapiMessage> FunapiMessage::Create(std::shared_ptr<FunapiSharedPayloadImpl> payload,
+                                                     const EncryptionType type)
+{
+    return std::make_shared<FunapiMessage>(payload, type);
+}
+
+
 bool FunapiMessage::UseSentQueue()
 {
     return use_sent_queue_;
@@ -575,54 +1015,162 @@ std::shared_ptr<rapidjson::Document> FunapiMessage::GetJsonDocumenet()
 }
 
 
-std::shared_ptr<FunMessage> FunapiMessage::GetProtobufMessage()
-{
-    return protobuf_message_;
+std::shared_ptr<FunMessage> FunapiMessage::GetProtobufMessage()
+{
+    return protobuf_message_;
+}
+
+
+FunEncoding FunapiMessage::GetEncoding()
+{
+    return encoding_;
+}
+
+
+EncryptionType FunapiMessage::GetEncryptionType()
+{
+    return encryption_type_;
+}
+
+
+bool FunapiMessage::IsInitialized()
+{
+  return initialized_;
+}
+
+
+void FunapiMessage::SetInitialized(bool initialized)
+{
+  initialized_ = initialized;
+}
+
+
+fun::vector<uint8_t>& FunapiMessage::GetBody()
+{
+    return GetBody(0);
+}
+
+
+fun::vector<uint8_t>& FunapiMessage::GetBody(const size_t headroom)
+{
+    if (shared_payload_)
+    {
+        return GetSharedBody(headroom);
+    }
+
+    if (encoding_ == FunEncoding::kProtobuf)
+    {
+        fun::vector<uint8_t> &body = GetWritableBody(false);
+        const int byte_size = protobuf_message_->ByteSize();
+        body.resize(headroom + byte_size);
+        protobuf_message_->SerializeToArray(body.data() + headroom, byte_size);
+        body_offset_ = headroom;
+    }
+    else if (encoding_ == FunEncoding::kJson)
+    {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        json_document_->Accept(writer);
+
+        fun::vector<uint8_t> &body = GetWritableBody(false);
+        body.resize(headroom + buffer.GetSize());
+        memcpy(body.data() + headroom, buffer.GetString(), buffer.GetSize());
+        body_offset_ = headroom;
+    }
+    else
+    {
+        // NOTE: 직렬화하지 않는 메시지는 본문을 그대로 사용한다.
+        GetWritableBody(true);
+        body_offset_ = 0;
+    }
+
+    return *body_;
+}
+
+
+fun::vector<uint8_t>& FunapiMessage::GetSharedBody(const size_t headroom)
+{
+    const fun::vector<uint8_t> &payload = shared_payload_->GetBody();
+
+    if (encoding_ == FunEncoding::kProtobuf)
+    {
+        // protobuf 는 이어 붙인 메시지를 파싱하면 하나로 합쳐지므로 공유 본문 뒤에 붙인다.
+        fun::vector<uint8_t> &body = GetWritableBody(false);
+        const int envelope_size = protobuf_message_->ByteSize();
+        body.resize(headroom + payload.size() + envelope_size);
+        memcpy(body.data() + headroom, payload.data(), payload.size());
+        protobuf_message_->SerializeToArray(body.data() + headroom + payload.size(), envelope_size);
+    }
+    else
+    {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        json_document_->Accept(writer);
+
+        fun::vector<uint8_t> &body = GetWritableBody(false);
+        body.reserve(headroom + payload.size() + buffer.GetSize());
+        body.resize(headroom + payload.size());
+        memcpy(body.data() + headroom, payload.data(), payload.size());
+        AppendJsonMembers(body, headroom, buffer.GetString(), buffer.GetSize());
+    }
+
+    body_offset_ = headroom;
+    return *body_;
+}
+
+
+// 소켓에 넘긴 프레임이 아직 버퍼를 가지고 있으면 그 버퍼는 두고 새 버퍼에 쓴다.
+// 재전송 큐로 돌아온 메시지를 다시 직렬화해도 보내는 중인 프레임은 바뀌지 않는다.
+fun::vector<uint8_t>& FunapiMessage::GetWritableBody(const bool keep_contents)
+{
+    if (body_.use_count() > 1)
+    {
+        if (keep_contents)
+        {
+            body_ = std::make_shared<fun::vector<uint8_t>>(*body_);
+        }
+        else
+        {
+            body_ = std::make_shared<fun::vector<uint8_t>>();
+        }
+    }
+
+    return *body_;
 }
 
 
-FunEncoding FunapiMessage::GetEncoding()
+std::shared_ptr<const fun::vector<uint8_t>> FunapiMessage::GetBodyBuffer()
 {
-    return encoding_;
+    return body_;
 }
 
 
-EncryptionType FunapiMessage::GetEncryptionType()
+size_t FunapiMessage::GetBodyOffset()
 {
-    return encryption_type_;
+    return body_offset_;
 }
 
 
-bool FunapiMessage::IsInitialized()
+std::shared_ptr<FunapiMessage::EncodedBody> FunapiMessage::GetEncodedBody()
 {
-  return initialized_;
+    return encoded_body_;
 }
 
 
-void FunapiMessage::SetInitialized(bool initialized)
+void FunapiMessage::SetEncodedBody(std::shared_ptr<EncodedBody> encoded_body)
 {
-  initialized_ = initialized;
+    encoded_body_ = encoded_body;
 }
 
 
-fun::vector<uint8_t>& FunapiMessage::GetBody()
+fun::vector<uint8_t>& FunapiMessage::GetBodyFromEncoded(const size_t headroom)
 {
-    if (encoding_ == FunEncoding::kProtobuf)
-    {
-        body_.resize(protobuf_message_->ByteSize());
-        protobuf_message_->SerializeToArray(body_.data(), protobuf_message_->ByteSize());
-    }
-    else if (encoding_ == FunEncoding::kJson)
-    {
-        rapidjson::StringBuffer buffer;
-        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-        json_document_->Accept(writer);
-
-        fun::string temp_string = buffer.GetString();
-        body_ = fun::vector<uint8_t>(temp_string.cbegin(), temp_string.cend());
-    }
+    fun::vector<uint8_t> &body = GetWritableBody(false);
+    body.resize(headroom + encoded_body_->data.size());
+    memcpy(body.data() + headroom, encoded_body_->data.data(), encoded_body_->data.size());
+    body_offset_ = headroom;
 
-    return body_;
+    return body;
 }
 
 
@@ -753,7 +1301,7 @@ class FunapiSessionImpl : public std::enable_shared_from_this<FunapiSessionImpl>
 
   typedef std::function<void(const TransportProtocol,
     const FunEncoding,
-    const HeaderFields &,
+    const FunapiHeaderView &,
     const fun::vector<uint8_t> &,
     const std::shared_ptr<FunapiMessage>)> TransportReceivedHandler;
 
@@ -790,6 +1338,29 @@ class FunapiSessionImpl : public std::enable_shared_from_this<FunapiSessionImpl>
                    const TransportProtocol protocol,
                    const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
 
+  void SendMessage(std::shared_ptr<FunapiSharedPayload> payload,
+                   const TransportProtocol protocol,
+                   const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
+
+  void SendMessage(const fun::string &msg_type,
+                   rapidjson::Document &&json,
+                   const TransportProtocol protocol,
+                   const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
+
+  void SendMessage(FunMessage &&message,
+                   const TransportProtocol protocol,
+                   const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
+
+  void SendMessage(std::unique_ptr<FunMessage> message,
+                   const TransportProtocol protocol,
+                   const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
+
+  void SendMessage(const FunEncoding encoding,
+                   const fun::string &msg_type,
+                   fun::vector<uint8_t> &&body,
+                   const TransportProtocol protocol,
+                   const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
+
   void AddSessionEventCallback(const SessionEventHandler &handler);
   void AddTransportEventCallback(const TransportEventHandler &handler);
   void AddProtobufRecvCallback(const ProtobufRecvHandler &handler);
@@ -825,6 +1396,10 @@ class FunapiSessionImpl : public std::enable_shared_from_this<FunapiSessionImpl>
 
   FunEncoding GetEncoding(const TransportProtocol protocol) const;
   int64_t GetPingTime();
+  fun::vector<CompressionStatistics> GetCompressionStatistics(const TransportProtocol protocol) const;
+  void StartCompressionCapture(const TransportProtocol protocol, const size_t sample_interval, const size_t max_bytes);
+  void StopCompressionCapture(const TransportProtocol protocol);
+  fun::vector<fun::vector<uint8_t>> GetCompressionCapture(const TransportProtocol protocol) const;
 
   void SetRecvTimeout(const fun::string &msg_type, const int seconds);
   void SetRecvTimeout(const int32_t msg_type, const int seconds);
@@ -834,9 +1409,11 @@ class FunapiSessionImpl : public std::enable_shared_from_this<FunapiSessionImpl>
   static void Add(std::shared_ptr<FunapiSessionImpl> s);
   static fun::vector<std::shared_ptr<FunapiSessionImpl>> GetSessionImpls();
 
+  int GetNetworkThreadIndex() const;
+
   void OnTransportReceived(const TransportProtocol protocol,
                            const FunEncoding encoding,
-                           const HeaderFields &header,
+                           const FunapiHeaderView &header,
                            const fun::vector<uint8_t> &body,
                            const std::shared_ptr<FunapiMessage> message);
 
@@ -987,6 +1564,7 @@ class FunapiSessionImpl : public std::enable_shared_from_this<FunapiSessionImpl>
   static std::mutex vec_sessions_mutex_;
 
   std::shared_ptr<FunapiThread> network_thread_ = nullptr;
+  int network_thread_index_ = 0;
 
   std::shared_ptr<FunapiSessionOption> session_option_ = nullptr;
 
@@ -1000,6 +1578,7 @@ class FunapiSessionImpl : public std::enable_shared_from_this<FunapiSessionImpl>
   fun::vector<fun::string> redirect_target_tags_;
 
   void OnRedirect();
+  void PrefetchRedirectHost(const std::shared_ptr<FunapiMessage> &message);
 
   void AddMessageToRedirectQueue(const TransportProtocol protocol,
                                  const std::shared_ptr<FunapiMessage> message);
@@ -1015,7 +1594,7 @@ class FunapiTransport : public std::enable_shared_from_this<FunapiTransport> {
   typedef fun::map<fun::string, fun::string> HeaderFields;
   typedef std::function<void(const TransportProtocol,
                              const FunEncoding,
-                             const HeaderFields &,
+                             const FunapiHeaderView &,
                              const fun::vector<uint8_t> &,
                              const std::shared_ptr<FunapiMessage>)> TransportReceivedHandler;
 
@@ -1048,12 +1627,22 @@ class FunapiTransport : public std::enable_shared_from_this<FunapiTransport> {
   void SetEncryptionType(EncryptionType type, const fun::string &public_key);
 
   void SetCompressionType(CompressionType type);
+  void SetCompressionRule(const CompressionRule &rule);
+  fun::vector<CompressionStatistics> GetCompressionStatistics();
   void SetZstdDictBase64String(const fun::string &zstd_dict_base64string);
+  void AddZstdDictBase64String(const fun::string &zstd_dict_base64string);
+  void StartCompressionCapture(const size_t sample_interval, const size_t max_bytes);
+  void StopCompressionCapture();
+  fun::vector<fun::vector<uint8_t>> GetCompressionCapture();
+  void SetLz4DictBase64String(const fun::string &lz4_dict_base64string);
 
   void SetState(TransportState state);
   TransportState GetState();
 
   virtual void Send(bool send_all = false);
+
+  // 보낼 메시지가 생겼음을 네트워크 스레드에 알린다. 어느 스레드에서나 호출할 수 있다.
+  virtual void RequestSend();
   virtual void Update();
 
   void SetSendSessionIdOnlyOnce(const bool once);
@@ -1067,7 +1656,7 @@ class FunapiTransport : public std::enable_shared_from_this<FunapiTransport> {
 
   void OnReceived(const TransportProtocol protocol,
                   const FunEncoding encoding,
-                  const HeaderFields &header,
+                  const FunapiHeaderView &header,
                   const fun::vector<uint8_t> &body);
 
   bool OnAckReceived(const uint32_t ack);
@@ -1078,21 +1667,28 @@ class FunapiTransport : public std::enable_shared_from_this<FunapiTransport> {
                                      const EncryptionType encryption_type) = 0;
   virtual bool EncodeThenSendMessage(std::shared_ptr<FunapiMessage> message);
 
+  // 본문 앞에 헤더를 쓰기 위해 비워 둘 공간의 크기.
+  virtual size_t GetFrameHeadroom() const;
+
+  // 보관한 압축 결과를 이 연결에서 그대로 보낼 수 있는지 확인한다.
+  bool CanReuseCompressedBody(const FunapiMessage::EncodedBody &encoded_body);
+
   void PushSendQueue(std::shared_ptr<FunapiMessage> message,
                      bool priority,
                      bool handshake);
 
-  bool DecodeMessage(int nRead, fun::vector<uint8_t> &receiving, int &next_decoding_offset, bool &header_decoded, HeaderFields &header_fields);
-  bool TryToDecodeHeader(fun::vector<uint8_t> &receiving, int &next_decoding_offset, bool &header_decoded, HeaderFields &header_fields);
-  bool TryToDecodeBody(fun::vector<uint8_t> &receiving, int &next_decoding_offset, bool &header_decoded, HeaderFields &header_fields);
+  bool DecodeMessage(int nRead, fun::vector<uint8_t> &receiving, int &next_decoding_offset, bool &header_decoded, FunapiHeaderView &header_fields);
+  bool TryToDecodeHeader(fun::vector<uint8_t> &receiving, int &next_decoding_offset, bool &header_decoded, FunapiHeaderView &header_fields);
+  bool TryToDecodeBody(fun::vector<uint8_t> &receiving, int &next_decoding_offset, bool &header_decoded, FunapiHeaderView &header_fields);
+  // 프레임은 body 의 frame_offset 부터 끝까지이다.
   bool EncodeMessage(std::shared_ptr<FunapiMessage> message,
                      fun::vector<uint8_t> &body,
+                     size_t &frame_offset,
                      const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
   bool DecodeMessage(int nRead, fun::vector<uint8_t> &receiving);
 
   fun::string MakeHeaderString(const fun::vector<uint8_t> &body);
   void MakeHeaderFields(HeaderFields &header_fields, const fun::vector<uint8_t> &body);
-  void MakeHeaderString(fun::string &header_string, const HeaderFields &header_fields);
 
   void PushUnsent(const uint32_t ack);
 
@@ -1131,19 +1727,30 @@ class FunapiTransport : public std::enable_shared_from_this<FunapiTransport> {
   bool IsDelayedAckInterval() const;
   int GetDelayedAckInterval() const;
   bool IsDelayedAckSendTime();
+  void ScheduleDelayedAck();
   double delayed_ack_interval_ = 0;
   int64_t ack_sent_time_ = 0;
+  bool delayed_ack_scheduled_ = false;
 
   std::shared_ptr<FunapiEncryption> encrytion_;
   bool sequence_number_validation_ = false;
 
+  // 바이너리 헤더와 스트림 압축은 연결마다 첫 메시지에서 제안하고 서버가 수락한 뒤부터 쓴다.
+  bool use_binary_header_ = false;
+  bool binary_header_offered_ = false;
+  bool binary_header_enabled_ = false;
+  bool use_stream_compression_ = false;
+  bool stream_compression_offered_ = false;
+  bool zstd_dict_offered_ = false;
+  void ResetNegotiation();
+
   std::shared_ptr<FunapiCompression> compression_;
 
   std::weak_ptr<FunapiSessionImpl> session_impl_;
 
   void OnTransportReceived(const TransportProtocol protocol,
                            const FunEncoding encoding,
-                           const HeaderFields &header,
+                           const FunapiHeaderView &header,
                            const fun::vector<uint8_t> &body,
                            const std::shared_ptr<FunapiMessage> message);
   void OnSendAck(const TransportProtocol protocol, const uint32_t seq);
@@ -1153,6 +1760,9 @@ class FunapiTransport : public std::enable_shared_from_this<FunapiTransport> {
   fun::string hostname_or_ip_;
   uint16_t port_;
 
+  // 세션이 고정된 네트워크 스레드의 번호.
+  int network_thread_index_ = 0;
+
   void SetSeq(std::shared_ptr<FunapiMessage> message);
   void SetSessionId(std::shared_ptr<FunapiMessage> message);
 
@@ -1165,7 +1775,10 @@ class FunapiTransport : public std::enable_shared_from_this<FunapiTransport> {
 
   int next_decoding_offset_ = 0;
   bool header_decoded_ = false;
-  HeaderFields header_fields_;
+  FunapiHeaderView header_fields_;
+
+  // 받은 메시지의 본문. 메시지마다 할당하지 않도록 재사용한다.
+  fun::vector<uint8_t> recv_body_;
 
   bool received_redirection_event_ = false;
 
@@ -1203,6 +1816,7 @@ FunapiTransport::FunapiTransport(std::weak_ptr<FunapiSessionImpl> session,
   if (auto s = session_impl_.lock()) {
     session_id_ = s->GetSessionIdSharedPtr();
     send_queue_ = s->GetQueueSharedPtr(protocol);
+    network_thread_index_ = s->GetNetworkThreadIndex();
   }
 
   send_priority_queue_ = FunapiQueue::Create();
@@ -1218,9 +1832,13 @@ FunapiTransport::~FunapiTransport() {
 
 bool FunapiTransport::EncodeMessage(std::shared_ptr<FunapiMessage> message,
                                     fun::vector<uint8_t> &body,
+                                    size_t &frame_offset,
                                     const EncryptionType encryption_type) {
+  // NOTE: body 는 message->GetBody(GetFrameHeadroom()) 로 얻은 버퍼이다.
+  // 본문 앞에 비워 둔 공간에 헤더를 써서 본문을 옮기지 않고 프레임을 만든다.
+  const size_t offset = std::min(message->GetBodyOffset(), body.size());
 
-  if (body.size() > kMaxPayloadSize)
+  if (body.size() - offset > kMaxPayloadSize)
   {
     fun::stringstream msg;
     msg << "The message size is too large to cause an unexpected problem.";
@@ -1229,16 +1847,101 @@ bool FunapiTransport::EncodeMessage(std::shared_ptr<FunapiMessage> message,
     DebugUtils::Log(msg.str().c_str());
   }
 
-  HeaderFields header_fields;
-  MakeHeaderFields(header_fields, body);
+  FunapiHeaderWriter header;
+  header.SetVersion(static_cast<int>(FunapiVersion::kProtocolVersion));
+  if (use_binary_header_) {
+    if (binary_header_enabled_) {
+      header.SetBinary(true);
+    }
+    else if (false == binary_header_offered_) {
+      binary_header_offered_ = true;
+      header.AddField(kBinaryHeaderField, FunapiHeaderView::kBinaryHeaderVersion);
+    }
+  }
+  if (use_stream_compression_ && false == stream_compression_offered_ &&
+      compression_->HasCompression(CompressionType::kDefault)) {
+    stream_compression_offered_ = true;
+    header.AddField(kStreamCompressionVersionField, FunapiCompression::kStreamCompressionVersion);
+  }
+#if FUNAPI_HAVE_ZSTD
+  // 등록한 사전 중 가장 최근 것을 제안한다. 사전을 모르는 서버는 응답하지 않으므로 기존 방식대로 압축한다.
+  if (false == zstd_dict_offered_ && compression_->GetLatestZstdDictId() != 0 &&
+      compression_->HasCompression(CompressionType::kDefault)) {
+    zstd_dict_offered_ = true;
+    header.AddField(kCompressionDictionaryOfferField, compression_->GetLatestZstdDictId());
+  }
+#endif
+  if (first_sending_) {
+    first_sending_ = false;
+    header.SetPluginVersion(static_cast<int>(FunapiVersion::kPluginVersion));
+  }
+  header.SetLength(body.size() - offset);
+
+  // 재전송할 메시지는 처음 보낼 때 본문을 보관한다. 스트림 압축 중이면 압축 전 본문을,
+  // 아니면 압축한 본문을 보관해서 재전송할 때는 암호화만 다시 한다.
+  auto encoded_body = message->GetEncodedBody();
+  const bool cache_body = (encoded_body == nullptr && message->UseSentQueue() && IsReliableSession());
+
+  if (encoded_body && encoded_body->compression_applied) {
+    // body 는 GetBodyFromEncoded() 로 채운 압축 결과이다.
+    if (encoded_body->uncompressed_length > 0) {
+      header.SetUncompressedLength(encoded_body->uncompressed_length);
+    }
+#if FUNAPI_HAVE_ZSTD
+    if (encoded_body->dict_id != 0) {
+      header.AddField(kCompressionDictionaryField, encoded_body->dict_id);
+    }
+#endif
+  }
+  else {
+    const bool compression_applied = (false == compression_->IsStreaming());
+    if (cache_body && false == compression_applied) {
+      encoded_body = std::make_shared<FunapiMessage::EncodedBody>();
+      encoded_body->data.assign(body.cbegin() + offset, body.cend());
+      message->SetEncodedBody(encoded_body);
+    }
+
+    // 압축 정책과 통계는 메시지 타입마다 관리한다. msgtype2 만 있는 메시지는 그 번호를 이름으로 쓴다.
+    // 사전 학습용 표본을 모으는 중이면 압축하지 않더라도 본문을 넘긴다.
+    if (compression_->HasCompression(CompressionType::kDefault) || compression_->IsCapturing()) {
+      const fun::string &msg_type = message->GetMsgType();
+      if (msg_type.empty() && message->GetMsgType2() != 0) {
+        fun::stringstream ss;
+        ss << message->GetMsgType2();
+        compression_->Compress(header, body, offset, ss.str());
+      }
+      else {
+        compression_->Compress(header, body, offset, msg_type);
+      }
+    }
 
-  compression_->Compress(header_fields, body);
+    if (cache_body && compression_applied) {
+      encoded_body = std::make_shared<FunapiMessage::EncodedBody>();
+      encoded_body->data.assign(body.cbegin() + offset, body.cend());
+      encoded_body->compression_applied = true;
+      encoded_body->uncompressed_length = header.GetUncompressedLength();
+      size_t dict_id = 0;
+      if (header.FindField(kCompressionDictionaryField, dict_id)) {
+        encoded_body->dict_id = static_cast<uint32_t>(dict_id);
+      }
+      message->SetEncodedBody(encoded_body);
+    }
+  }
 
-  if (false == encrytion_->Encrypt(header_fields, body, encryption_type))
+  if (false == encrytion_->Encrypt(header, body, offset, encryption_type))
     return false;
 
-  fun::string header_string;
-  MakeHeaderString(header_string, header_fields);
+  const size_t header_size = header.GetSize();
+  if (header_size <= offset) {
+    frame_offset = offset - header_size;
+  }
+  else {
+    // 헤더가 비워 둔 공간보다 큰 경우(핸드셰이크 등)에만 본문을 옮긴다.
+    body.insert(body.begin(), header_size - offset, 0);
+    frame_offset = 0;
+  }
+
+  header.Write(body.data() + frame_offset);
 
 #ifdef DEBUG_LOG
   {
@@ -1246,11 +1949,7 @@ bool FunapiTransport::EncodeMessage(std::shared_ptr<FunapiMessage> message,
     ss << "[C->S] " << TransportProtocolToString(GetProtocol()) << "/" << EncodingToString(GetEncoding()) << ": ";
 
     // header
-    ss << "{";
-    for (auto i : header_fields) {
-      ss << "(" << i.first << "=" << i.second << ")";
-    }
-    ss << "} ";
+    ss << header.ToString() << " ";
 
     // body
     if (message->GetEncoding() == FunEncoding::kProtobuf) {
@@ -1268,14 +1967,6 @@ bool FunapiTransport::EncodeMessage(std::shared_ptr<FunapiMessage> message,
   }
 #endif
 
-  // log
-  // fun::string body_string(body.cbegin(), body.cend());
-  // DebugUtils::Log("Header to send: %s", header_string.c_str());
-  // DebugUtils::Log("send message: %s", body_string.c_str());
-  // //
-
-  body.insert(body.begin(), header_string.cbegin(), header_string.cend());
-
   return true;
 }
 
@@ -1283,7 +1974,11 @@ bool FunapiTransport::EncodeMessage(std::shared_ptr<FunapiMessage> message,
 bool FunapiTransport::DecodeMessage(int read_length,
                                     fun::vector<uint8_t> &receiving,
                                     int &next_decoding_offset,
-                                    bool &header_decoded, HeaderFields &header_fields) {
+                                    bool &header_decoded, FunapiHeaderView &header_fields) {
+  // NOTE: 메시지마다 버퍼 앞부분을 지우면 남은 데이터를 매번 옮겨야 하므로
+  // 디코딩이 끝난 위치만 기록해 두었다가 한 번에 정리한다.
+  int consumed_offset = next_decoding_offset;
+
   // Tries to decode as many messags as possible.
   while (true) {
     if (header_decoded == false) {
@@ -1296,19 +1991,27 @@ bool FunapiTransport::DecodeMessage(int read_length,
         break;
       }
       else {
-        int new_length = static_cast<int>(receiving.size() - next_decoding_offset);
-        if (new_length > 0) {
-          receiving.erase(receiving.begin(), receiving.begin() + next_decoding_offset);
-        }
-        else {
-          new_length = 0;
-        }
-        next_decoding_offset = 0;
-        receiving.resize(new_length);
+        consumed_offset = next_decoding_offset;
       }
     }
   }
 
+  // 헤더는 수신 버퍼를 가리키므로 본문을 기다리는 중이었다면
+  // 버퍼가 바뀐 뒤 헤더부터 다시 파싱한다.
+  next_decoding_offset = consumed_offset;
+  header_decoded = false;
+  header_fields.Clear();
+
+  if (consumed_offset > 0) {
+    if (consumed_offset >= static_cast<int>(receiving.size())) {
+      receiving.clear();
+    }
+    else {
+      receiving.erase(receiving.begin(), receiving.begin() + consumed_offset);
+    }
+    next_decoding_offset = 0;
+  }
+
   return true;
 }
 
@@ -1316,7 +2019,7 @@ bool FunapiTransport::DecodeMessage(int read_length,
 bool FunapiTransport::DecodeMessage(int read_length, fun::vector<uint8_t> &receiving) {
   int next_decoding_offset = 0;
   bool header_decoded = false;
-  HeaderFields header_fields;
+  FunapiHeaderView header_fields;
 
   // DebugUtils::Log("Received %d bytes.", read_length);
 
@@ -1470,53 +2173,107 @@ void FunapiTransport::SetSessionId(std::shared_ptr<FunapiMessage> message) {
 bool FunapiTransport::TryToDecodeHeader(fun::vector<uint8_t> &receiving,
                                         int &next_decoding_offset,
                                         bool &header_decoded,
-                                        HeaderFields &header_fields) {
+                                        FunapiHeaderView &header_fields) {
   // DebugUtils::Log("Trying to decode header fields.");
-  static const char* ptrHeaderDelimeter = kHeaderDelimeter;
-  static const char* ptrHeaderFieldDelimeter = kHeaderFieldDelimeter;
+  // NOTE: 헤더 필드는 수신 버퍼를 가리키므로 헤더가 모두 도착했을 때 한 번에 파싱하고
+  // 그 전에는 next_decoding_offset 을 옮기지 않는다.
+  const char *base = reinterpret_cast<const char *>(receiving.data());
+  const char *end = base + receiving.size();
+  const char *line = base + next_decoding_offset;
+
+  header_fields.Clear();
+
+  if (binary_header_offered_ && line < end &&
+      FunapiHeaderView::IsBinaryHeader(static_cast<uint8_t>(*line))) {
+    size_t header_size = 0;
+    auto result = header_fields.ParseBinary(receiving.data() + next_decoding_offset,
+                                            receiving.size() - next_decoding_offset,
+                                            header_size);
+    if (result == FunapiHeaderView::BinaryParseResult::kComplete) {
+      next_decoding_offset += static_cast<int>(header_size);
+      header_decoded = true;
+      return true;
+    }
 
-  int received_size = static_cast<int>(receiving.size());
-  for (; next_decoding_offset < received_size;) {
-    char *base = reinterpret_cast<char *>(receiving.data());
-    char *ptr =
-    std::search(base + next_decoding_offset,
-                base + received_size,
-                ptrHeaderDelimeter,
-                ptrHeaderDelimeter + strlen(ptrHeaderDelimeter));
-
-    int eol_offset = static_cast<int>(ptr - base);
-    if (eol_offset >= received_size) {
+    header_fields.Clear();
+    if (result == FunapiHeaderView::BinaryParseResult::kInvalid) {
+      Stop(true, FunapiError::Create(FunapiError::ErrorType::kDeserialize, 0, "Message binary header was invalid. Stopping the transport."));
+    }
+    return false;
+  }
+
+  while (line < end) {
+    const char *eol =
+    static_cast<const char *>(memchr(line, kHeaderDelimeter[0], end - line));
+    if (eol == nullptr) {
       // Not enough bytes. Wait for more bytes to come.
       // DebugUtils::Log("We need more bytes for a header field. Waiting.");
-      return false;
+      break;
     }
 
-    // Generates a null-termianted fun::string by replacing the delimeter with \0.
-    *ptr = '\0';
-    char *line = base + next_decoding_offset;
-    // DebugUtils::Log("Header line: %s", line);
-
-    size_t line_length = eol_offset - next_decoding_offset;
-    next_decoding_offset = static_cast<int>(eol_offset + 1);
-
-    if (line_length == 0) {
+    if (eol == line) {
       // End of header.
+      next_decoding_offset = static_cast<int>(eol + 1 - base);
       header_decoded = true;
+
+      if (binary_header_offered_ && false == binary_header_enabled_) {
+        // 서버가 같은 버전으로 응답하면 다음 메시지부터 바이너리 헤더를 쓴다.
+        const FunapiHeaderView::Field *field = header_fields.Find(kBinaryHeaderField);
+        size_t binary_header_version = 0;
+        if (field != nullptr &&
+            FunapiHeaderView::ParseNumber(field->value, field->value_length, binary_header_version) &&
+            binary_header_version == static_cast<size_t>(FunapiHeaderView::kBinaryHeaderVersion)) {
+          binary_header_enabled_ = true;
+          DebugUtils::Log("Binary message header enabled.");
+        }
+      }
+
+      if (stream_compression_offered_ && false == compression_->IsStreaming()) {
+        const FunapiHeaderView::Field *field = header_fields.Find(kStreamCompressionVersionField);
+        size_t stream_compression_version = 0;
+        if (field != nullptr &&
+            FunapiHeaderView::ParseNumber(field->value, field->value_length, stream_compression_version) &&
+            stream_compression_version == static_cast<size_t>(FunapiCompression::kStreamCompressionVersion)) {
+          compression_->SetStreaming(true);
+          DebugUtils::Log("Stream compression enabled.");
+        }
+      }
+
+#if FUNAPI_HAVE_ZSTD
+      if (zstd_dict_offered_ && compression_->GetZstdDictId() == 0) {
+        const FunapiHeaderView::Field *field = header_fields.Find(kCompressionDictionaryOfferField);
+        size_t dict_id = 0;
+        if (field != nullptr &&
+            FunapiHeaderView::ParseNumber(field->value, field->value_length, dict_id) &&
+            compression_->SetZstdDictId(static_cast<uint32_t>(dict_id))) {
+          DebugUtils::Log("Zstd dictionary %u enabled.", static_cast<uint32_t>(dict_id));
+        }
+      }
+#endif
+
       // DebugUtils::Log("End of header reached. Will decode body from now.");
       return true;
     }
 
-    ptr = std::search(line, line + line_length, ptrHeaderFieldDelimeter,
-                      ptrHeaderFieldDelimeter + strlen(ptrHeaderFieldDelimeter));
-    assert((ptr - base) < eol_offset);
+    const char *delim =
+    static_cast<const char *>(memchr(line, kHeaderFieldDelimeter[0], eol - line));
+    if (delim == nullptr) {
+      delim = eol;
+    }
+
+    const char *value = (delim < eol) ? delim + 1 : eol;
+    while (value < eol && (*value == ' ' || *value == '\t')) ++value;
 
-    // Generates null-terminated fun::string by replacing the delimeter with \0.
-    *ptr = '\0';
-    char *e1 = line, *e2 = ptr + 1;
-    while (*e2 == ' ' || *e2 == '\t') ++e2;
-    // DebugUtils::Log("Decoded header field '%s' => '%s'", e1, e2);
-    header_fields[e1] = e2;
+    if (false == header_fields.Add(line, delim - line, value, eol - value)) {
+      header_fields.Clear();
+      Stop(true, FunapiError::Create(FunapiError::ErrorType::kDeserialize, 0, "Too many message header fields. Stopping the transport."));
+      return false;
+    }
+
+    line = eol + 1;
   }
+
+  header_fields.Clear();
   return false;
 }
 
@@ -1524,53 +2281,49 @@ bool FunapiTransport::TryToDecodeHeader(fun::vector<uint8_t> &receiving,
 bool FunapiTransport::TryToDecodeBody(fun::vector<uint8_t> &receiving,
                                       int &next_decoding_offset,
                                       bool &header_decoded,
-                                      HeaderFields &header_fields)
+                                      FunapiHeaderView &header_fields)
 {
   int received_size = static_cast<int>(receiving.size());
-  HeaderFields::const_iterator version_field_itr = header_fields.find(kVersionHeaderField);
-  if (version_field_itr == header_fields.end())
+  if (false == header_fields.HasVersion())
   {
-    header_decoded_ = false;
-    header_fields.clear();
+    header_decoded = false;
+    header_fields.Clear();
     Stop(true, FunapiError::Create(FunapiError::ErrorType::kDeserialize, 0, "Message version header field not found. Stopping the transport."));
-    return true;
+    return false;
   }
 
-  long int version = strtol(version_field_itr->second.c_str(), NULL, 10);
+  long int version = header_fields.GetVersion();
   if (version != static_cast<int>(FunapiVersion::kProtocolVersion))
   {
-    header_decoded_ = false;
-    header_fields.clear();
+    header_decoded = false;
+    header_fields.Clear();
     fun::stringstream ss;
     ss << "Protocol version was worng" << "(server protocol version: " << version << "). Stopping the transport.";
     Stop(true, FunapiError::Create(FunapiError::ErrorType::kDeserialize, 0, ss.str()));
-    return true;
+    return false;
   }
 
-  HeaderFields::const_iterator length_field_itr = header_fields.find(kLengthHeaderField);
-  if (length_field_itr == header_fields.end())
+  if (false == header_fields.HasLength())
   {
-    header_decoded_ = false;
-    header_fields.clear();
+    header_decoded = false;
+    header_fields.Clear();
     Stop(true, FunapiError::Create(FunapiError::ErrorType::kDeserialize, 0, "Message length header field not found. Stopping the transport."));
-    return true;
+    return false;
   }
 
-  long int body_length = strtol(length_field_itr->second.c_str(), NULL, 10);
-  if (body_length == 0)
+  /*
+    문자열이 변환이 유효 했는지 확인.
+  */
+  if (false == header_fields.IsLengthValid())
   {
-    /*
-      문자열이 변환이 유효 했는지 확인.
-    */
-    if (length_field_itr->second.size() != 1 || length_field_itr->second.at(0) != '0')
-    {
-      header_decoded_ = false;
-      header_fields.clear();
-      Stop(true, FunapiError::Create(FunapiError::ErrorType::kDeserialize, 0, "Message header field was invalid. Stopping the transport."));
-      return true;
-    }
+    header_decoded = false;
+    header_fields.Clear();
+    Stop(true, FunapiError::Create(FunapiError::ErrorType::kDeserialize, 0, "Message header field was invalid. Stopping the transport."));
+    return false;
   }
 
+  int body_length = static_cast<int>(header_fields.GetLength());
+
   // DebugUtils::Log("We need %d bytes for a message body.", body_length);
   if (received_size - next_decoding_offset < body_length)
   {
@@ -1588,11 +2341,7 @@ bool FunapiTransport::TryToDecodeBody(fun::vector<uint8_t> &receiving,
     ss << "[S->C] " << TransportProtocolToString(GetProtocol()) << "/" << EncodingToString(GetEncoding()) << ": ";
 
     // header
-    ss << "{";
-    for (auto i : header_fields) {
-      ss << "(" << i.first << "=" << i.second << ")";
-    }
-    ss << "} ";
+    ss << header_fields.ToString() << " ";
 
     DebugUtils::Log("%s", ss.str().c_str());
   }
@@ -1600,12 +2349,23 @@ bool FunapiTransport::TryToDecodeBody(fun::vector<uint8_t> &receiving,
 
   if (body_length > 0)
   {
-    fun::vector<uint8_t> v(receiving.begin() + next_decoding_offset, receiving.begin() + next_decoding_offset + body_length);
+    // 본문은 수신 버퍼 안에서 바로 복호화하고 재사용하는 버퍼에 압축을 풀거나 복사한다.
+    // 핸들러 안에서 다시 디코딩하더라도 버퍼를 같이 쓰지 않도록 빌려 쓰고 돌려 놓는다.
+    uint8_t *data = receiving.data() + next_decoding_offset;
+    fun::vector<uint8_t> v;
+    v.swap(recv_body_);
 
     // TODO(sungjin): 복호화에 실패 했을때 압축해제 하지 않고 에러로 처리.
-    encrytion_->Decrypt(header_fields, v, encryption_types);
+    encrytion_->Decrypt(header_fields, data, body_length, encryption_types);
 
-    compression_->Decompress(header_fields, v);
+    if (false == compression_->Decompress(header_fields, data, body_length, v) && header_fields.IsStreamCompressed()) {
+      // 스트림이 어긋나면 이후 메시지도 복원할 수 없다.
+      header_decoded = false;
+      header_fields.Clear();
+      Stop(true, FunapiError::Create(FunapiError::ErrorType::kDeserialize, 0, "Failed to decompress stream. Stopping the transport."));
+      return false;
+    }
+    // Decompress() 가 1 바이트를 더 확보해 두므로 재할당되지 않는다.
     v.push_back('\0');
 
     // Moves the read offset.
@@ -1618,6 +2378,9 @@ bool FunapiTransport::TryToDecodeBody(fun::vector<uint8_t> &receiving,
 
     // The network module eats the fields and invokes registered handler
     OnReceived(GetProtocol(), GetEncoding(), header_fields, v);
+
+    v.clear();
+    recv_body_.swap(v);
   }
   else
   {
@@ -1660,7 +2423,7 @@ bool FunapiTransport::TryToDecodeBody(fun::vector<uint8_t> &receiving,
 
   // Prepares for a next message.
   header_decoded = false;
-  header_fields.clear();
+  header_fields.Clear();
 
   return true;
 }
@@ -1702,20 +2465,6 @@ void FunapiTransport::MakeHeaderFields(HeaderFields &header_fields,
 }
 
 
-void FunapiTransport::MakeHeaderString(fun::string &header_string,
-                                       const HeaderFields &header_fields) {
-  fun::stringstream ss;
-
-  for (auto it : header_fields) {
-    ss << it.first << kHeaderFieldDelimeter << it.second << kHeaderDelimeter;
-  }
-
-  ss << kHeaderDelimeter;
-
-  header_string = ss.str();
-}
-
-
 bool FunapiTransport::IsStarted() {
   return (GetState() == TransportState::kConnected);
 }
@@ -1747,7 +2496,55 @@ bool FunapiTransport::EncodeThenSendMessage(std::shared_ptr<FunapiMessage> messa
     message->SetInitialized(true);
   }
 
-  return EncodeThenSendMessage(message, message->GetBody(), message->GetEncryptionType());
+  // 재전송하는 메시지는 처음 보낼 때 만든 본문을 다시 쓴다.
+  auto encoded_body = message->GetEncodedBody();
+  if (encoded_body &&
+      (false == encoded_body->compression_applied || CanReuseCompressedBody(*encoded_body))) {
+    return EncodeThenSendMessage(message, message->GetBodyFromEncoded(GetFrameHeadroom()), message->GetEncryptionType());
+  }
+
+  // 이 연결에서 쓸 수 없는 압축 본문은 버린다. 남겨 두면 EncodeMessage() 가
+  // 새로 만든 압축 전 본문에 이전 연결의 C, CD 필드를 붙인다.
+  if (encoded_body) {
+    message->SetEncodedBody(nullptr);
+  }
+
+  return EncodeThenSendMessage(message, message->GetBody(GetFrameHeadroom()), message->GetEncryptionType());
+}
+
+
+bool FunapiTransport::CanReuseCompressedBody(const FunapiMessage::EncodedBody &encoded_body) {
+  // 스트림 압축은 이전 메시지를 참조하므로 연결마다 다시 압축해야 한다.
+  if (compression_->IsStreaming()) {
+    return false;
+  }
+
+#if FUNAPI_HAVE_ZSTD
+  // 사전 ID 로 압축한 본문은 이 연결에서도 같은 사전으로 협상했을 때만 보낸다.
+  if (encoded_body.dict_id != 0 && encoded_body.dict_id != compression_->GetZstdDictId()) {
+    return false;
+  }
+#endif
+
+  return true;
+}
+
+
+void FunapiTransport::ResetNegotiation() {
+  // 서버는 연결마다 헤더 형식과 압축 스트림을 새로 만들므로 다시 협상한다.
+  binary_header_offered_ = false;
+  binary_header_enabled_ = false;
+  stream_compression_offered_ = false;
+  compression_->ResetStream();
+#if FUNAPI_HAVE_ZSTD
+  zstd_dict_offered_ = false;
+  compression_->SetZstdDictId(0);
+#endif
+}
+
+
+size_t FunapiTransport::GetFrameHeadroom() const {
+  return FunapiHeaderWriter::kHeadroom;
 }
 
 
@@ -1755,6 +2552,11 @@ void FunapiTransport::Send(bool send_all) {
 }
 
 
+void FunapiTransport::RequestSend() {
+  FunapiSendFlagManager::Get().Signal(network_thread_index_);
+}
+
+
 void FunapiTransport::SetConnectTimeout(const time_t timeout) {
   connect_timeout_seconds_ = timeout;
 }
@@ -1831,6 +2633,16 @@ void FunapiTransport::SetCompressionType(CompressionType type) {
 }
 
 
+void FunapiTransport::SetCompressionRule(const CompressionRule &rule) {
+  compression_->SetPolicy(rule);
+}
+
+
+fun::vector<CompressionStatistics> FunapiTransport::GetCompressionStatistics() {
+  return compression_->GetStatistics();
+}
+
+
 void FunapiTransport::SetZstdDictBase64String(const fun::string &zstd_dict_base64string) {
 #if FUNAPI_HAVE_ZSTD
   compression_->SetZstdDictBase64String(zstd_dict_base64string);
@@ -1838,6 +2650,35 @@ void FunapiTransport::SetZstdDictBase64String(const fun::string &zstd_dict_base6
 }
 
 
+void FunapiTransport::AddZstdDictBase64String(const fun::string &zstd_dict_base64string) {
+#if FUNAPI_HAVE_ZSTD
+  compression_->AddZstdDictBase64String(zstd_dict_base64string);
+#endif
+}
+
+
+void FunapiTransport::StartCompressionCapture(const size_t sample_interval, const size_t max_bytes) {
+  compression_->StartCapture(sample_interval, max_bytes);
+}
+
+
+void FunapiTransport::StopCompressionCapture() {
+  compression_->StopCapture();
+}
+
+
+fun::vector<fun::vector<uint8_t>> FunapiTransport::GetCompressionCapture() {
+  return compression_->GetCapturedSamples();
+}
+
+
+void FunapiTransport::SetLz4DictBase64String(const fun::string &lz4_dict_base64string) {
+#if FUNAPI_HAVE_LZ4
+  compression_->SetLz4DictBase64String(lz4_dict_base64string);
+#endif
+}
+
+
 bool FunapiTransport::OnAckReceived(const uint32_t ack) {
   ack_receiving_ = true;
 
@@ -1862,7 +2703,8 @@ bool FunapiTransport::OnAckReceived(const uint32_t ack) {
 
 bool FunapiTransport::IsDelayedAckSendTime() {
   if (IsDelayedAckInterval()) {
-    auto time_now = std::chrono::system_clock::now().time_since_epoch().count() / 1000;
+    auto time_now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
     auto diff = time_now - ack_sent_time_;
 
     if (diff >= delayed_ack_interval_) {
@@ -1884,10 +2726,36 @@ bool FunapiTransport::IsDelayedAckInterval() const {
 }
 
 
+void FunapiTransport::ScheduleDelayedAck() {
+  if (delayed_ack_scheduled_) {
+    return;
+  }
+
+  delayed_ack_scheduled_ = true;
+
+  // 보낼 메시지가 없더라도 delayed ack 를 보낼 시각에 Send() 가 불리도록 한다.
+  auto expired_time =
+      std::chrono::steady_clock::time_point(std::chrono::milliseconds(ack_sent_time_)) +
+      std::chrono::milliseconds(static_cast<int64_t>(delayed_ack_interval_));
+
+  std::weak_ptr<FunapiTransport> weak = shared_from_this();
+  FunapiSocket::AddTimer(network_thread_index_, expired_time, [weak, this]()
+  {
+    if (auto t = weak.lock()) {
+      delayed_ack_scheduled_ = false;
+      if (has_ack_send_) {
+        RequestSend();
+      }
+    }
+  });
+}
+
+
 void FunapiTransport::OnSendAck(const TransportProtocol protocol, const uint32_t seq) {
   if (IsDelayedAckInterval()) {
     ack_send_ = seq;
     has_ack_send_ = true;
+    ScheduleDelayedAck();
   }
   else if (auto s = session_impl_.lock()) {
     s->SendAck(protocol, seq);
@@ -1931,7 +2799,7 @@ void FunapiTransport::PushUnsent(const uint32_t ack) {
 
 void FunapiTransport::OnTransportReceived(const TransportProtocol protocol,
                                           const FunEncoding encoding,
-                                          const HeaderFields &header,
+                                          const FunapiHeaderView &header,
                                           const fun::vector<uint8_t> &body,
                                           const std::shared_ptr<FunapiMessage> message) {
   if (auto s = session_impl_.lock()) {
@@ -1942,7 +2810,7 @@ void FunapiTransport::OnTransportReceived(const TransportProtocol protocol,
 
 void FunapiTransport::OnReceived(const TransportProtocol protocol,
                                  const FunEncoding encoding,
-                                 const HeaderFields &header,
+                                 const FunapiHeaderView &header,
                                  const fun::vector<uint8_t> &body) {
   auto message = FunapiMessage::Create(encoding, body, EncryptionType::kDefaultEncryption);
 
@@ -2099,8 +2967,11 @@ class FunapiTcpTransport : public FunapiTransport {
   void SetDisableNagle(const bool disable_nagle);
   void SetAutoReconnect(const bool auto_reconnect);
   void SetSequenceNumberValidation(const bool validation);
+  void SetUseBinaryHeader(const bool use_binary_header);
+  void SetUseStreamCompression(const bool use_stream_compression);
   void SetEnablePing(const bool enable_ping);
   void SetUseTLS(const bool use_tls);
+  void SetUseKernelTLS(const bool use_kernel_tls);
   void SetCACertFilePath(const fun::string &path);
   void ResetClientPingTimeout();
 
@@ -2108,6 +2979,7 @@ class FunapiTcpTransport : public FunapiTransport {
 
   void Update();
   void Send(bool send_all = false);
+  void RequestSend();
 
  protected:
   bool EncodeThenSendMessage(std::shared_ptr<FunapiMessage> message,
@@ -2144,6 +3016,12 @@ class FunapiTcpTransport : public FunapiTransport {
   void WaitForAutoReconnect();
   void StartReconnect();
 
+  // 네트워크 스레드의 타이머에 다음 Update() 시각을 등록한다.
+  void ScheduleUpdate(const FunapiTimer &timer);
+  void ScheduleNextUpdate();
+  bool update_scheduled_ = false;
+  FunapiTimer::TimePoint update_scheduled_time_;
+
   FunapiTimer reconnect_wait_timer_;
   time_t reconnect_wait_seconds_ = 1;
 
@@ -2155,6 +3033,7 @@ class FunapiTcpTransport : public FunapiTransport {
   bool enable_ping_ = false;
 
   bool use_tls_ = false;
+  bool use_kernel_tls_ = false;
   fun::string cert_file_path_;
 
   FunapiTimer client_ping_timeout_timer_;
@@ -2162,8 +3041,9 @@ class FunapiTcpTransport : public FunapiTransport {
 
   std::function<bool(const TransportProtocol protocol)> send_client_ping_message_handler_;
 
+  // NOTE: RequestSend() 는 다른 스레드에서도 불리므로 tcp_ 는 std::atomic_load/store 로 접근한다.
   std::shared_ptr<FunapiTcp> tcp_;
-  fun::vector<uint8_t> send_buffer_;
+  fun::vector<FunapiTcp::Frame> send_frames_;
   std::shared_ptr<FunapiAddrInfo> addrinfo_res_ = nullptr;
 };
 
@@ -2229,7 +3109,7 @@ void FunapiTcpTransport::Start() {
 void FunapiTcpTransport::OnDisconnecting(std::shared_ptr<FunapiError> error,
                                          bool user_did)
 {
-  tcp_ = nullptr;
+  std::atomic_store(&tcp_, std::shared_ptr<FunapiTcp>());
 
   if (ack_receiving_)
   {
@@ -2285,6 +3165,7 @@ void FunapiTcpTransport::StartReconnect() {
     reconnect_wait_timer_.SetTimer(reconnect_wait_seconds_);
 
     SetUpdateState(UpdateState::kWaitForAutoReconnect);
+    ScheduleNextUpdate();
     OnTransportReconnecting(GetProtocol());
 
     DebugUtils::Log("Wait %d seconds for connect to Tcp transport.", static_cast<int>(reconnect_wait_seconds_));
@@ -2318,6 +3199,11 @@ void FunapiTcpTransport::SetUseTLS(const bool use_tls) {
 }
 
 
+void FunapiTcpTransport::SetUseKernelTLS(const bool use_kernel_tls) {
+  use_kernel_tls_ = use_kernel_tls;
+}
+
+
 void FunapiTcpTransport::SetCACertFilePath(const fun::string &path) {
   cert_file_path_ = path;
 }
@@ -2331,11 +3217,18 @@ void FunapiTcpTransport::ResetClientPingTimeout() {
 bool FunapiTcpTransport::EncodeThenSendMessage(std::shared_ptr<FunapiMessage> message,
                                                fun::vector<uint8_t> &body,
                                                const EncryptionType encryption_type) {
-  if (!EncodeMessage(message, body, encryption_type)) {
+  size_t frame_offset = 0;
+  if (!EncodeMessage(message, body, frame_offset, encryption_type)) {
     return false;
   }
 
-  send_buffer_.insert(send_buffer_.end(), body.cbegin(), body.cend());
+  // NOTE: body 는 메시지가 가지고 있는 버퍼이므로 복사하지 않고 버퍼를 소유자로 넘긴다.
+  // 소켓이 다 보내기 전에 메시지를 다시 직렬화하면 메시지는 새 버퍼를 쓴다.
+  auto buffer = message->GetBodyBuffer();
+  assert(buffer.get() == &body);
+  send_frames_.push_back(FunapiTcp::Frame{
+    std::shared_ptr<const uint8_t>(buffer, buffer->data() + frame_offset),
+    buffer->size() - frame_offset });
   return true;
 }
 
@@ -2388,8 +3281,12 @@ void FunapiTcpTransport::OnConnectCompletion(const bool isFailed,
 
     SetUpdateState(UpdateState::kPing);
     SetState(TransportState::kConnected);
+    ScheduleNextUpdate();
 
     OnTransportStarted(TransportProtocol::kTcp);
+
+    // 연결되기 전에 쌓인 메시지를 보낸다.
+    RequestSend();
   }
 }
 
@@ -2408,7 +3305,11 @@ void FunapiTcpTransport::Connect() {
     SetUseFirstSessionId(true);
   }
 
-  tcp_ = FunapiTcp::Create();
+  ResetNegotiation();
+
+  std::atomic_store(&tcp_, FunapiTcp::Create());
+  tcp_->SetUseKernelTLS(use_kernel_tls_);
+
   std::weak_ptr<FunapiTransport> weak = shared_from_this();
   tcp_->Connect(hostname_or_ip_.c_str(),
                 port_,
@@ -2459,6 +3360,7 @@ void FunapiTcpTransport::Connect() {
 
 void FunapiTcpTransport::Connect(std::shared_ptr<FunapiAddrInfo> addrinfo_res) {
   SetState(TransportState::kConnecting);
+  ResetNegotiation();
 
   if (addrinfo_res && tcp_) {
     std::weak_ptr<FunapiTransport> weak = shared_from_this();
@@ -2479,13 +3381,51 @@ void FunapiTcpTransport::Connect(std::shared_ptr<FunapiAddrInfo> addrinfo_res) {
 }
 
 
-void FunapiTcpTransport::Update() {
+void FunapiTcpTransport::Update() {
+  auto state = GetUpdateState();
+  if (state == UpdateState::kPing) {
+    Ping();
+  }
+  else if (state == UpdateState::kWaitForAutoReconnect) {
+    WaitForAutoReconnect();
+  }
+
+  ScheduleNextUpdate();
+}
+
+
+void FunapiTcpTransport::ScheduleUpdate(const FunapiTimer &timer) {
+  auto expired_time = timer.GetExpiredTime();
+
+  // 이미 더 이른 시각에 Update() 가 예약되어 있다면 그 때 다시 계산된다.
+  if (update_scheduled_ && update_scheduled_time_ <= expired_time) {
+    return;
+  }
+
+  update_scheduled_ = true;
+  update_scheduled_time_ = expired_time;
+
+  std::weak_ptr<FunapiTransport> weak = shared_from_this();
+  FunapiSocket::AddTimer(network_thread_index_, expired_time, [weak, this]()
+  {
+    if (auto t = weak.lock()) {
+      update_scheduled_ = false;
+      Update();
+    }
+  });
+}
+
+
+void FunapiTcpTransport::ScheduleNextUpdate() {
   auto state = GetUpdateState();
   if (state == UpdateState::kPing) {
-    Ping();
+    if (enable_ping_ && GetState() == TransportState::kConnected) {
+      ScheduleUpdate(ping_send_timer_);
+      ScheduleUpdate(client_ping_timeout_timer_);
+    }
   }
   else if (state == UpdateState::kWaitForAutoReconnect) {
-    WaitForAutoReconnect();
+    ScheduleUpdate(reconnect_wait_timer_);
   }
 }
 
@@ -2495,20 +3435,44 @@ void FunapiTcpTransport::SetSequenceNumberValidation(const bool validation) {
 }
 
 
+void FunapiTcpTransport::SetUseBinaryHeader(const bool use_binary_header) {
+  use_binary_header_ = use_binary_header;
+}
+
+
+void FunapiTcpTransport::SetUseStreamCompression(const bool use_stream_compression) {
+  use_stream_compression_ = use_stream_compression;
+}
+
+
 bool FunapiTcpTransport::UseSodium() {
   return encrytion_->UseSodium();
 }
 
 
+void FunapiTcpTransport::RequestSend()
+{
+  // 소켓이 없으면 연결이 끝난 뒤에 보내므로 스레드만 깨운다.
+  if (auto tcp = std::atomic_load(&tcp_))
+  {
+    tcp->RequestSend();
+  }
+  else
+  {
+    FunapiTransport::RequestSend();
+  }
+}
+
+
 void FunapiTcpTransport::Send(bool send_all)
 {
-  send_buffer_.resize(0);
+  send_frames_.clear();
   std::shared_ptr<FunapiMessage> msg;
 
   if (!send_handshake_queue_->Empty())
   {
     // 이후 메시지를 처리하기 위해서 다시 Send 플레그를 올려준다.
-    FunapiSendFlagManager::Get().WakeUp();
+    RequestSend();
     while (!send_handshake_queue_->Empty())
     {
       msg = send_handshake_queue_->Front();
@@ -2525,7 +3489,7 @@ void FunapiTcpTransport::Send(bool send_all)
   else if (!send_priority_queue_->Empty())
   {
     // 이후 메시지를 처리하기 위해서 다시 Send 플레그를 올려준다.
-    FunapiSendFlagManager::Get().WakeUp();
+    RequestSend();
     if (false == encrytion_->IsHandShakeCompleted())
     {
       return;
@@ -2613,10 +3577,10 @@ void FunapiTcpTransport::Send(bool send_all)
     }
   }
 
-  if (!send_buffer_.empty())
+  if (!send_frames_.empty())
   {
     std::weak_ptr<FunapiTransport> weak = shared_from_this();
-    tcp_->Send(send_buffer_,
+    tcp_->Send(send_frames_,
                [weak, this](const bool is_failed,
                             const int error_code,
                             const fun::string &error_string,
@@ -2672,6 +3636,7 @@ class FunapiUdpTransport : public FunapiTransport {
 
   void Start();
   void Send(bool send_all = false);
+  void RequestSend();
 
  protected:
   bool EncodeThenSendMessage(std::shared_ptr<FunapiMessage> message,
@@ -2681,7 +3646,18 @@ class FunapiUdpTransport : public FunapiTransport {
                        bool use_did = false);
 
  private:
+  // queue 에서 꺼내 인코딩한 메시지를 보낼 프레임에 더한다.
+  bool EncodeThenPopMessage(std::shared_ptr<FunapiQueue> queue);
+
+  // 한 번의 Send() 에서 인코딩한 프레임을 모아서 보낸다.
+  // 보내지 못한 메시지는 꺼냈던 큐의 앞에 다시 넣는다.
+  void SendFrames();
+
   std::shared_ptr<FunapiUdp> udp_;
+  fun::vector<FunapiUdp::Frame> send_frames_;
+
+  // send_frames_ 의 프레임마다 인코딩한 메시지와 꺼낸 큐.
+  fun::vector<std::pair<std::shared_ptr<FunapiQueue>, std::shared_ptr<FunapiMessage>>> send_messages_;
 };
 
 
@@ -2727,7 +3703,7 @@ void FunapiUdpTransport::Start() {
     if (auto t = weak.lock())
     {
       SetUseFirstSessionId(true);
-      udp_ = FunapiUdp::Create
+      std::atomic_store(&udp_, FunapiUdp::Create
       (hostname_or_ip_.c_str(),
        port_,
        [weak, this]
@@ -2766,7 +3742,7 @@ void FunapiUdpTransport::Start() {
              DecodeMessage(read_length, receiving);
            }
          }
-       });
+       }));
     }
 
     return true;
@@ -2779,7 +3755,7 @@ void FunapiUdpTransport::Start() {
 void FunapiUdpTransport::OnDisconnecting(std::shared_ptr<FunapiError> error,
                                          bool user_did)
 {
-  udp_ = nullptr;
+  std::atomic_store(&udp_, std::shared_ptr<FunapiUdp>());
 
   FunapiTransport::OnDisconnecting(error, user_did);
 }
@@ -2788,53 +3764,99 @@ void FunapiUdpTransport::OnDisconnecting(std::shared_ptr<FunapiError> error,
 bool FunapiUdpTransport::EncodeThenSendMessage(std::shared_ptr<FunapiMessage> message,
                                                fun::vector<uint8_t> &body,
                                                const EncryptionType encryption_type) {
-  if (!EncodeMessage(message, body, encryption_type)) {
+  size_t frame_offset = 0;
+  if (!EncodeMessage(message, body, frame_offset, encryption_type)) {
+    return false;
+  }
+
+  // NOTE: 데이터그램은 Send() 가 끝날 때 SendFrames() 에서 한꺼번에 보낸다.
+  // 전송 결과는 SendFrames() 에서 알 수 있으므로 여기서는 프레임만 만든다.
+  auto buffer = message->GetBodyBuffer();
+  assert(buffer.get() == &body);
+  send_frames_.push_back(FunapiUdp::Frame{
+    std::shared_ptr<const uint8_t>(buffer, buffer->data() + frame_offset),
+    buffer->size() - frame_offset });
+  return true;
+}
+
+
+bool FunapiUdpTransport::EncodeThenPopMessage(std::shared_ptr<FunapiQueue> queue) {
+  auto msg = queue->Front();
+  if (!FunapiTransport::EncodeThenSendMessage(msg)) {
     return false;
   }
 
-  bool bRet = false;
+  queue->PopFront();
+  send_messages_.push_back(std::make_pair(queue, msg));
+  return true;
+}
+
 
+void FunapiUdpTransport::SendFrames() {
+  if (send_frames_.empty()) {
+    return;
+  }
+
+  // Stop() 에서 udp_ 를 해제할 수 있으므로 보내는 동안 참조를 유지한다.
+  auto udp = std::atomic_load(&udp_);
   std::weak_ptr<FunapiTransport> weak = shared_from_this();
-  udp_->Send
-  (body,
-   [weak, this, &bRet]
-   (const bool is_failed,
+  bool is_failed = false;
+
+  udp->Send
+  (send_frames_,
+   [weak, this, &is_failed]
+   (const bool failed,
     const int error_code,
     const fun::string &error_string,
     const int sent_length)
   {
     if (auto t = weak.lock()) {
-      if (is_failed) {
+      if (failed && !is_failed) {
+        is_failed = true;
         Stop(true, FunapiError::Create(FunapiError::ErrorType::kSocket, error_code, error_string));
       }
       else {
-        bRet = true;
         // DebugUtils::Log("Sent %d bytes", sent_length);
       }
     }
   });
 
-  return bRet;
+  // 보내지 못한 프레임은 send_frames_ 뒤쪽에 남아 있다.
+  // 다음 Send() 에서 다시 보내도록 해당 메시지를 순서대로 큐에 되돌린다.
+  const size_t sent_count = send_messages_.size() - send_frames_.size();
+  for (size_t i = send_messages_.size(); i > sent_count; --i) {
+    auto &entry = send_messages_[i - 1];
+    entry.first->PushFront(entry.second);
+  }
+
+  send_frames_.clear();
+  send_messages_.clear();
 }
 
 
-void FunapiUdpTransport::Send(bool send_all) {
-  std::shared_ptr<FunapiMessage> msg;
+void FunapiUdpTransport::RequestSend() {
+  if (auto udp = std::atomic_load(&udp_)) {
+    udp->RequestSend();
+  }
+  else {
+    FunapiTransport::RequestSend();
+  }
+}
+
 
+void FunapiUdpTransport::Send(bool send_all) {
   while (!send_handshake_queue_->Empty())
   {
     // 이후 메시지를 처리하기 위해서 다시 Send 플레그를 올려준다.
-    FunapiSendFlagManager::Get().WakeUp();
-    msg = send_handshake_queue_->Front();
-    if (FunapiTransport::EncodeThenSendMessage(msg)) {
-      send_handshake_queue_->PopFront();
-    }
-    else {
+    RequestSend();
+    if (!EncodeThenPopMessage(send_handshake_queue_)) {
+      SendFrames();
       return;
     }
   }
 
   if (GetSessionId().empty()) {
+    SendFrames();
     return;
   }
 
@@ -2842,12 +3864,7 @@ void FunapiUdpTransport::Send(bool send_all) {
 
   while (!send_queue_->Empty())
   {
-    msg = send_queue_->Front();
-
-    if (FunapiTransport::EncodeThenSendMessage(msg)) {
-      send_queue_->PopFront();
-    }
-    else {
+    if (!EncodeThenPopMessage(send_queue_)) {
       break;
     }
 
@@ -2856,6 +3873,8 @@ void FunapiUdpTransport::Send(bool send_all) {
       break;
   }
 
+  SendFrames();
+
   if (GetState() == TransportState::kDisconnecting) {
     if (send_queue_->Empty()) {
       OnDisconnecting();
@@ -2891,6 +3910,7 @@ class FunapiHttpTransport : public FunapiTransport {
   bool EncodeThenSendMessage(std::shared_ptr<FunapiMessage> message,
                              fun::vector<uint8_t> &body,
                              const EncryptionType encryption_type);
+  size_t GetFrameHeadroom() const;
   void OnDisconnecting(std::shared_ptr<FunapiError> error = nullptr,
                        bool user_did = false);
 
@@ -3099,9 +4119,12 @@ bool FunapiHttpTransport::EncodeThenSendMessage(std::shared_ptr<FunapiMessage> m
       compression_->SetHeaderFieldsForHttpRecv(header_fields);
       encrytion_->SetHeaderFieldsForHttpRecv(header_fields);
 
+      FunapiHeaderView header;
+      header.AddProtocolFields(header_fields);
+
       bool header_decoded = true;
       int next_decoding_offset = 0;
-      TryToDecodeBody(temp_body, next_decoding_offset, header_decoded, header_fields);
+      TryToDecodeBody(temp_body, next_decoding_offset, header_decoded, header);
     }
   });
 
@@ -3109,6 +4132,12 @@ bool FunapiHttpTransport::EncodeThenSendMessage(std::shared_ptr<FunapiMessage> m
 }
 
 
+size_t FunapiHttpTransport::GetFrameHeadroom() const {
+  // HTTP 는 헤더를 HTTP 헤더로 보내므로 본문만 필요하다.
+  return 0;
+}
+
+
 void FunapiHttpTransport::WebResponseHeaderCb(const void *data, int len, HeaderFields &header_fields) {
   fun::vector<uint8_t> receiving(len);
   memcpy(receiving.data(), data, len);
@@ -3370,15 +4399,16 @@ bool FunapiWebsocketTransport::EncodeThenSendMessage(std::shared_ptr<FunapiMessa
                                                      const EncryptionType encryption_type) {
   if (GetState() == TransportState::kDisconnected) return false;
 
-  if (!EncodeMessage(message, body, encryption_type)) {
+  size_t frame_offset = 0;
+  if (!EncodeMessage(message, body, frame_offset, encryption_type)) {
     return false;
   }
 
-  if (!body.empty()) {
+  if (body.size() > frame_offset) {
     bool is_protobuf = GetEncoding() == FunEncoding::kProtobuf ? true : false;
 
     std::weak_ptr<FunapiTransport> weak = shared_from_this();
-    websocket_->Send(body, is_protobuf,
+    websocket_->Send(body.data() + frame_offset, body.size() - frame_offset, is_protobuf,
                      [weak, this]
                      (const bool is_failed,
                       const int error_code,
@@ -3541,7 +4571,17 @@ void FunapiSessionImpl::Initialize()
 
     session_id_ = FunapiSessionId::Create();
 
-    network_thread_ = FunapiThread::Get("_network");
+    // 세션의 모든 transport 는 같은 네트워크 스레드에서 처리되어 순서가 보장된다.
+    static std::atomic<unsigned int> network_thread_counter(0);
+    network_thread_index_ =
+        static_cast<int>(network_thread_counter++ % FunapiThread::GetNetworkThreadCount());
+    network_thread_ = FunapiThread::Get(FunapiThread::GetNetworkThreadId(network_thread_index_));
+}
+
+
+int FunapiSessionImpl::GetNetworkThreadIndex() const
+{
+    return network_thread_index_;
 }
 
 
@@ -3595,7 +4635,10 @@ void FunapiSessionImpl::Connect(const std::weak_ptr<FunapiSession>& session, con
         tcp_transport->SetDisableNagle(tcp_option_->GetDisableNagle());
         tcp_transport->SetConnectTimeout(tcp_option_->GetConnectTimeout());
         tcp_transport->SetSequenceNumberValidation(tcp_option_->GetSequenceNumberValidation());
+        tcp_transport->SetUseBinaryHeader(tcp_option_->GetUseBinaryHeader());
+        tcp_transport->SetUseStreamCompression(tcp_option_->GetUseStreamCompression());
         tcp_transport->SetUseTLS(tcp_option_->GetUseTLS());
+        tcp_transport->SetUseKernelTLS(tcp_option_->GetUseKernelTLS());
         tcp_transport->SetCACertFilePath(tcp_option_->GetCACertFilePath());
         auto encryption_types = tcp_option_->GetEncryptionTypes();
         for (auto type : encryption_types) {
@@ -3605,9 +4648,21 @@ void FunapiSessionImpl::Connect(const std::weak_ptr<FunapiSession>& session, con
         for (auto type : compression_types) {
           tcp_transport->SetCompressionType(type);
         }
+        auto compression_rules = tcp_option_->GetCompressionRules();
+        for (auto &rule : compression_rules) {
+          tcp_transport->SetCompressionRule(rule);
+        }
 
 #if FUNAPI_HAVE_ZSTD
         tcp_transport->SetZstdDictBase64String(tcp_option_->GetZstdDictBase64String());
+        auto zstd_dict_base64strings = tcp_option_->GetZstdDictBase64Strings();
+        for (auto &zstd_dict_base64string : zstd_dict_base64strings) {
+          tcp_transport->AddZstdDictBase64String(zstd_dict_base64string);
+        }
+#endif
+
+#if FUNAPI_HAVE_LZ4
+        tcp_transport->SetLz4DictBase64String(tcp_option_->GetLz4DictBase64String());
 #endif
       }
     }
@@ -3626,10 +4681,18 @@ void FunapiSessionImpl::Connect(const std::weak_ptr<FunapiSession>& session, con
         for (auto type : compression_types) {
           udp_transport->SetCompressionType(type);
         }
+        auto compression_rules = udp_option_->GetCompressionRules();
+        for (auto &rule : compression_rules) {
+          udp_transport->SetCompressionRule(rule);
+        }
 
 #if FUNAPI_HAVE_ZSTD
         udp_transport->SetZstdDictBase64String(udp_option_->GetZstdDictBase64String());
 #endif
+
+#if FUNAPI_HAVE_LZ4
+        udp_transport->SetLz4DictBase64String(udp_option_->GetLz4DictBase64String());
+#endif
       }
     }
     else if (protocol == fun::TransportProtocol::kHttp) {
@@ -3676,6 +4739,10 @@ void FunapiSessionImpl::Connect(const std::weak_ptr<FunapiSession>& session, con
         for (auto type : compression_types) {
           websocket_transport->SetCompressionType(type);
         }
+        auto compression_rules = websocket_option_->GetCompressionRules();
+        for (auto &rule : compression_rules) {
+          websocket_transport->SetCompressionRule(rule);
+        }
 
 #if FUNAPI_HAVE_ZSTD
         websocket_transport->SetZstdDictBase64String(websocket_option_->GetZstdDictBase64String());
@@ -3827,7 +4894,7 @@ void FunapiSessionImpl::SendMessage(std::shared_ptr<FunapiMessage> &message, con
         if (transport)
         {
             transport->SendMessage(message, priority, handshake);
-            FunapiSendFlagManager::Get().WakeUp();
+            transport->RequestSend();
         }
         else
         {
@@ -3852,7 +4919,7 @@ void FunapiSessionImpl::SendMessage(std::shared_ptr<FunapiMessage> &message, con
         if (transport)
         {
           transport->SendMessage(message, priority, handshake);
-          FunapiSendFlagManager::Get().WakeUp();
+          transport->RequestSend();
         }
     }
 }
@@ -3865,14 +4932,22 @@ void FunapiSessionImpl::SendMessage(const fun::string &msg_type,
   rapidjson::Document body;
   body.Parse<0>(json_string.c_str());
 
+  SendMessage(msg_type, std::move(body), protocol, encryption_type);
+}
+
+
+void FunapiSessionImpl::SendMessage(const fun::string &msg_type,
+                                    rapidjson::Document &&json,
+                                    const TransportProtocol protocol,
+                                    const EncryptionType encryption_type) {
   // Encodes a messsage type.
   if (msg_type.length() > 0) {
     rapidjson::Value msg_type_node;
-    msg_type_node.SetString(rapidjson::StringRef(msg_type.c_str()), body.GetAllocator());
-    body.AddMember(rapidjson::StringRef(kMessageTypeAttributeName), msg_type_node, body.GetAllocator());
+    msg_type_node.SetString(rapidjson::StringRef(msg_type.c_str()), json.GetAllocator());
+    json.AddMember(rapidjson::StringRef(kMessageTypeAttributeName), msg_type_node, json.GetAllocator());
   }
 
-  auto message = FunapiMessage::Create(body, encryption_type);
+  auto message = FunapiMessage::Create(std::move(json), encryption_type);
   message->SetUseSeq(true);
   message->SetUseSentQueue(IsReliableSession());
 
@@ -3891,6 +4966,84 @@ void FunapiSessionImpl::SendMessage(const FunMessage& temp_message,
 }
 
 
+void FunapiSessionImpl::SendMessage(std::shared_ptr<FunapiSharedPayload> payload,
+                                    const TransportProtocol protocol,
+                                    const EncryptionType encryption_type) {
+  if (payload == nullptr) {
+    DebugUtils::Log("SendMessage: shared payload is null.");
+    return;
+  }
+
+  if (false == payload->IsValid()) {
+    DebugUtils::Log("'%s' message skipped. The shared payload is invalid.", payload->GetMsgType().c_str());
+    return;
+  }
+
+  // 본문은 공유하고 세션마다 다른 필드만 메시지에 채운다.
+  auto message = FunapiMessage::Create(payload->GetImpl(), encryption_type);
+  message->SetUseSeq(true);
+  message->SetUseSentQueue(IsReliableSession());
+
+  SendMessage(message, protocol);
+}
+
+
+void FunapiSessionImpl::SendMessage(FunMessage &&temp_message,
+                                    const TransportProtocol protocol,
+                                    const EncryptionType encryption_type) {
+  // FunMessage 는 이동 생성자가 없으므로 Swap 으로 내용을 옮긴다.
+  auto pbuf = std::make_shared<FunMessage>();
+  pbuf->Swap(&temp_message);
+
+  auto message = FunapiMessage::Create(pbuf, encryption_type);
+  message->SetUseSeq(true);
+  message->SetUseSentQueue(IsReliableSession());
+
+  SendMessage(message, protocol);
+}
+
+
+void FunapiSessionImpl::SendMessage(std::unique_ptr<FunMessage> temp_message,
+                                    const TransportProtocol protocol,
+                                    const EncryptionType encryption_type) {
+  if (temp_message == nullptr) {
+    DebugUtils::Log("SendMessage: protobuf message is null.");
+    return;
+  }
+
+  auto message = FunapiMessage::Create(std::shared_ptr<FunMessage>(std::move(temp_message)), encryption_type);
+  message->SetUseSeq(true);
+  message->SetUseSentQueue(IsReliableSession());
+
+  SendMessage(message, protocol);
+}
+
+
+void FunapiSessionImpl::SendMessage(const FunEncoding encoding,
+                                    const fun::string &msg_type,
+                                    fun::vector<uint8_t> &&body,
+                                    const TransportProtocol protocol,
+                                    const EncryptionType encryption_type) {
+  if (encoding == FunEncoding::kNone) {
+    DebugUtils::Log("'%s' message skipped. The encoding type is none.", msg_type.c_str());
+    return;
+  }
+
+  // 세션마다 다른 필드는 공유 본문과 같은 방식으로 덧붙인다.
+  auto payload = std::make_shared<FunapiSharedPayloadImpl>(encoding, msg_type, std::move(body));
+  if (false == payload->IsValid()) {
+    DebugUtils::Log("'%s' message skipped. The message body is invalid.", msg_type.c_str());
+    return;
+  }
+
+  auto message = FunapiMessage::Create(payload, encryption_type);
+  message->SetUseSeq(true);
+  message->SetUseSentQueue(IsReliableSession());
+
+  SendMessage(message, protocol);
+}
+
+
 bool FunapiSessionImpl::IsRedirecting() const {
   return (funapi_message_redirect_ != nullptr);
 }
@@ -3927,7 +5080,7 @@ bool FunapiSessionImpl::IsConnected(const TransportProtocol protocol) const {
 
 void FunapiSessionImpl::OnTransportReceived(const TransportProtocol protocol,
                                             const FunEncoding encoding,
-                                            const HeaderFields &header,
+                                            const FunapiHeaderView &header,
                                             const fun::vector<uint8_t> &body,
                                             const std::shared_ptr<FunapiMessage> message) {
   fun::string msg_type;
@@ -3970,11 +5123,7 @@ void FunapiSessionImpl::OnTransportReceived(const TransportProtocol protocol,
     ss << "[S->C] " << TransportProtocolToString(protocol) << "/" << EncodingToString(encoding) << ": ";
 
     // header
-    ss << "{";
-    for (auto i : header) {
-      ss << "(" << i.first << "=" << i.second << ")";
-    }
-    ss << "} ";
+    ss << header.ToString() << " ";
 
     // body
     if (encoding == FunEncoding::kProtobuf) {
@@ -4425,6 +5574,9 @@ void FunapiSessionImpl::OnRedirectMessage(const TransportProtocol protocol,
     funapi_message_redirect_ = message;
     protocol_redirect_ = protocol;
 
+    // 기존 연결을 정리하는 동안 새 서버 주소를 미리 조회한다.
+    PrefetchRedirectHost(message);
+
     for (auto i : v_protocols_)
     {
         if (auto transport = GetTransport(i))
@@ -4436,6 +5588,77 @@ void FunapiSessionImpl::OnRedirectMessage(const TransportProtocol protocol,
 }
 
 
+void FunapiSessionImpl::PrefetchRedirectHost(const std::shared_ptr<FunapiMessage> &message)
+{
+    fun::string host;
+    fun::vector<std::pair<int, int>> ports;
+
+    if (message->GetEncoding() == FunEncoding::kJson)
+    {
+        // 서버가 보낸 값이므로 형식이 맞지 않으면 미리 조회하지 않는다.
+        auto document = message->GetJsonDocumenet();
+        if (!document || !document->IsObject() ||
+            !document->HasMember("host") || !document->HasMember("ports"))
+        {
+            return;
+        }
+
+        rapidjson::Value &v_host = (*document)["host"];
+        rapidjson::Value &v_ports = (*document)["ports"];
+        if (!v_host.IsString() || !v_ports.IsArray())
+        {
+            return;
+        }
+
+        host = v_host.GetString();
+
+        for (rapidjson::SizeType i = 0; i < v_ports.Size(); ++i)
+        {
+            rapidjson::Value &v = v_ports[i];
+            if (v.IsObject() && v.HasMember("port") && v.HasMember("protocol") &&
+                v["port"].IsInt() && v["protocol"].IsInt())
+            {
+                ports.push_back(std::make_pair(v["port"].GetInt(), v["protocol"].GetInt()));
+            }
+        }
+    }
+    else if (message->GetEncoding() == FunEncoding::kProtobuf)
+    {
+        auto msg = message->GetProtobufMessage();
+        if (!msg)
+        {
+            return;
+        }
+
+        FunRedirectMessage* redirect_message = msg->MutableExtension(_sc_redirect);
+        if (!redirect_message->has_host())
+        {
+            return;
+        }
+
+        host = redirect_message->host();
+        for (int i = 0; i < redirect_message->ports_size(); ++i)
+        {
+            const FunRedirectMessage_ServerPort &server_port = redirect_message->ports(i);
+            ports.push_back(std::make_pair(static_cast<int>(server_port.port()),
+                                           static_cast<int>(server_port.protocol())));
+        }
+    }
+
+    for (auto &p : ports)
+    {
+        if (p.second == FunRedirectMessage_Protocol_PROTO_TCP)
+        {
+            FunapiResolver::Prefetch(host, p.first, SOCK_STREAM);
+        }
+        else if (p.second == FunRedirectMessage_Protocol_PROTO_UDP)
+        {
+            FunapiResolver::Prefetch(host, p.first, SOCK_DGRAM);
+        }
+    }
+}
+
+
 void FunapiSessionImpl::OnRedirectConnectMessage(const TransportProtocol protocol,
                                                  const fun::string &msg_type,
                                                  const fun::vector<uint8_t>&v_body,
@@ -4796,7 +6019,22 @@ void FunapiSessionImpl::OnSessionEvent(const TransportProtocol protocol,
         {
           on_session_event_(s, protocol, type, session_id, error);
           // send buffer 에 있는 메세지를 모두 전송 시도 한다.
-          FunapiSendFlagManager::Get().WakeUp();
+          fun::vector<std::shared_ptr<FunapiTransport>> transports;
+          {
+            std::unique_lock<std::mutex> lock(transports_mutex_);
+            for (auto p : v_protocols_)
+            {
+              if (auto transport = transports_[static_cast<int>(p)])
+              {
+                transports.push_back(transport);
+              }
+            }
+          }
+
+          for (auto &transport : transports)
+          {
+            transport->RequestSend();
+          }
         }
         return true;
       });
@@ -4911,6 +6149,41 @@ int64_t FunapiSessionImpl::GetPingTime()
   return ping_time_ms;
 }
 
+
+fun::vector<CompressionStatistics> FunapiSessionImpl::GetCompressionStatistics(const TransportProtocol protocol) const {
+  auto transport = GetTransport(protocol);
+  if (transport)
+    return transport->GetCompressionStatistics();
+
+  return fun::vector<CompressionStatistics>();
+}
+
+
+void FunapiSessionImpl::StartCompressionCapture(const TransportProtocol protocol,
+                                                const size_t sample_interval,
+                                                const size_t max_bytes) {
+  auto transport = GetTransport(protocol);
+  if (transport)
+    transport->StartCompressionCapture(sample_interval, max_bytes);
+}
+
+
+void FunapiSessionImpl::StopCompressionCapture(const TransportProtocol protocol) {
+  auto transport = GetTransport(protocol);
+  if (transport)
+    transport->StopCompressionCapture();
+}
+
+
+fun::vector<fun::vector<uint8_t>> FunapiSessionImpl::GetCompressionCapture(const TransportProtocol protocol) const {
+  auto transport = GetTransport(protocol);
+  if (transport)
+    return transport->GetCompressionCapture();
+
+  return fun::vector<fun::vector<uint8_t>>();
+}
+
+
 void FunapiSessionImpl::SendEmptyMessage(const TransportProtocol protocol,
                                          const EncryptionType encryption_type) {
   std::shared_ptr<FunapiTransport> transport = GetTransport(protocol);
@@ -5263,7 +6536,10 @@ void FunapiSessionImpl::SendUnsentQueueMessages()
                 PushTaskQueue([this, protocol, message]()->bool
                 {
                     send_queues_[static_cast<int>(protocol)]->PushBack(message->GetMessage());
-                    FunapiSendFlagManager::Get().WakeUp();
+                    if (auto transport = GetTransport(protocol))
+                    {
+                        transport->RequestSend();
+                    }
                     return true;
                 });
 
@@ -5287,12 +6563,17 @@ void FunapiSessionImpl::SendUnsentQueueMessages()
 ////////////////////////////////////////////////////////////////////////////////
 // extern function. Used by funapi_socket.cpp, funapi_socket_win.cpp
 
-void OnSessionTicked()
+void OnSessionTicked(const int network_thread_index)
 {
   fun::vector<std::shared_ptr<FunapiSessionImpl>> impls =
       FunapiSessionImpl::GetSessionImpls();
   for (std::shared_ptr<FunapiSessionImpl> impl : impls)
   {
+    if (impl->GetNetworkThreadIndex() != network_thread_index)
+    {
+      continue;
+    }
+
     std::shared_ptr<FunapiTransport> tcp_transport =
         impl->GetTransport(TransportProtocol::kTcp);
     if (tcp_transport != nullptr)
@@ -5372,6 +6653,44 @@ void FunapiSession::SendMessage(const FunMessage& message,
 }
 
 
+void FunapiSession::SendMessage(std::shared_ptr<FunapiSharedPayload> payload,
+                                const TransportProtocol protocol,
+                                const EncryptionType encryption_type) {
+  impl_->SendMessage(payload, protocol, encryption_type);
+}
+
+
+void FunapiSession::SendMessage(const fun::string &msg_type,
+                                rapidjson::Document &&json,
+                                const TransportProtocol protocol,
+                                const EncryptionType encryption_type) {
+  impl_->SendMessage(msg_type, std::move(json), protocol, encryption_type);
+}
+
+
+void FunapiSession::SendMessage(FunMessage &&message,
+                                const TransportProtocol protocol,
+                                const EncryptionType encryption_type) {
+  impl_->SendMessage(std::move(message), protocol, encryption_type);
+}
+
+
+void FunapiSession::SendMessage(std::unique_ptr<FunMessage> message,
+                                const TransportProtocol protocol,
+                                const EncryptionType encryption_type) {
+  impl_->SendMessage(std::move(message), protocol, encryption_type);
+}
+
+
+void FunapiSession::SendMessage(const FunEncoding encoding,
+                                const fun::string &msg_type,
+                                fun::vector<uint8_t> &&body,
+                                const TransportProtocol protocol,
+                                const EncryptionType encryption_type) {
+  impl_->SendMessage(encoding, msg_type, std::move(body), protocol, encryption_type);
+}
+
+
 bool FunapiSession::IsConnected(const TransportProtocol protocol) const {
   return impl_->IsConnected(protocol);
 }
@@ -5513,6 +6832,28 @@ int64_t FunapiSession::GetPingTime() {
 }
 
 
+fun::vector<CompressionStatistics> FunapiSession::GetCompressionStatistics(const TransportProtocol protocol) const {
+  return impl_->GetCompressionStatistics(protocol);
+}
+
+
+void FunapiSession::StartCompressionCapture(const TransportProtocol protocol,
+                                            const size_t sample_interval,
+                                            const size_t max_bytes) {
+  impl_->StartCompressionCapture(protocol, sample_interval, max_bytes);
+}
+
+
+void FunapiSession::StopCompressionCapture(const TransportProtocol protocol) {
+  impl_->StopCompressionCapture(protocol);
+}
+
+
+fun::vector<fun::vector<uint8_t>> FunapiSession::GetCompressionCapture(const TransportProtocol protocol) const {
+  return impl_->GetCompressionCapture(protocol);
+}
+
+
 TransportProtocol FunapiSession::GetDefaultProtocol() const {
   return impl_->GetDefaultProtocol();
 }
@@ -5552,4 +6893,19 @@ void FunapiSession::UpdateAll() {
   FunapiSessionImpl::UpdateAll();
 }
 
+
+uint64_t FunapiSession::GetTlsSessionResumedCount() {
+  return FunapiSocket::GetTlsSessionResumedCount();
+}
+
+
+uint64_t FunapiSession::GetTlsFullHandshakeCount() {
+  return FunapiSocket::GetTlsFullHandshakeCount();
+}
+
+
+void FunapiSession::ClearTlsSessionCache() {
+  FunapiSocket::ClearTlsSessionCache();
+}
+
 }  // namespace fun
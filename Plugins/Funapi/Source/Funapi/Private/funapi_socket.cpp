@@ -13,13 +13,19 @@
 #endif // FUNAPI_UE4
 
 #include "funapi_send_flag_manager.h"
+#include "funapi_resolver.h"
 #include "funapi_utils.h"
+#include "funapi_tasks.h"
 
 #ifdef FUNAPI_UE4
 #ifdef FUNAPI_PLATFORM_WINDOWS
 #include "Windows/WindowsHWrapper.h"
 #else // FUNAPI_PLATFORM_WINDOWS
 #include <poll.h>
+#include <sys/uio.h>
+#if FUNAPI_HAVE_EPOLL
+#include <sys/epoll.h>
+#endif // FUNAPI_HAVE_EPOLL
 #endif // FUNAPI_PLATFORM_WINDOWS
 
 // Work around a conflict between a UI namespace defined by engine code and a typedef in OpenSSL
@@ -33,10 +39,21 @@ THIRD_PARTY_INCLUDES_END
 #undef UI
 #endif
 #else // FUNAPI_UE4
+#ifndef FUNAPI_PLATFORM_WINDOWS
+#include <sys/uio.h>
+#endif // FUNAPI_PLATFORM_WINDOWS
 #include "openssl/ssl.h"
 #include "openssl/err.h"
 #endif // FUNAPI_UE4
 
+// NOTE: kTLS 는 OpenSSL 3.0 이상에서만 사용할 수 있다.
+// OpenSSL 이 kTLS 없이 빌드되었거나 커널이 지원하지 않으면 handshake 이후에도 꺼져 있다.
+#if FUNAPI_HAVE_KTLS && defined(SSL_OP_ENABLE_KTLS)
+#define FUNAPI_USE_KTLS 1
+#else
+#define FUNAPI_USE_KTLS 0
+#endif
+
 namespace fun {
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -50,10 +67,11 @@ class FunapiAddrInfoImpl : public std::enable_shared_from_this<FunapiAddrInfoImp
   fun::string GetString();
 
   struct addrinfo* GetAddrInfo();
-  void SetAddrInfo(struct addrinfo* info);
+  void SetAddrInfo(struct addrinfo* info, const bool owned = false);
 
  private:
   struct addrinfo *addrinfo_res_ = nullptr;
+  bool owned_ = false;
 };
 
 FunapiAddrInfoImpl::FunapiAddrInfoImpl() {
@@ -62,11 +80,15 @@ FunapiAddrInfoImpl::FunapiAddrInfoImpl() {
 
 FunapiAddrInfoImpl::~FunapiAddrInfoImpl() {
   // DebugUtils::Log("%s", __FUNCTION__);
+  if (owned_ && addrinfo_res_) {
+    freeaddrinfo(addrinfo_res_);
+  }
 }
 
 
-void FunapiAddrInfoImpl::SetAddrInfo(struct addrinfo* info) {
+void FunapiAddrInfoImpl::SetAddrInfo(struct addrinfo* info, const bool owned) {
   addrinfo_res_ = info;
+  owned_ = owned;
 }
 
 
@@ -102,15 +124,34 @@ fun::string FunapiAddrInfoImpl::GetString() {
 // FunapiSocketImpl implementation.
 
 class FunapiSocketImpl : public std::enable_shared_from_this<FunapiSocketImpl> {
+  friend class FunapiSocketPollPoller;
+#if FUNAPI_HAVE_EPOLL
+  friend class FunapiSocketEpollPoller;
+#endif // FUNAPI_HAVE_EPOLL
+#ifdef FUNAPI_PLATFORM_WINDOWS
+  friend class FunapiSocketWSAPoller;
+#endif // FUNAPI_PLATFORM_WINDOWS
+
  public:
   FunapiSocketImpl();
   virtual ~FunapiSocketImpl();
 
+  typedef FunapiSocket::TimerHandler TimerHandler;
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
   static void Add(std::shared_ptr<FunapiSocketImpl> s);
-  static bool Poll();
+  static void Add(std::shared_ptr<FunapiSocketImpl> s, const int network_thread_index);
+  static bool Poll(const int network_thread_index);
+  static void AddTimer(const int network_thread_index,
+                       const TimePoint &expired_time,
+                       const TimerHandler &handler);
+  static uint64_t GetRecvBufferAllocationCount();
 
   int GetSocket();
 
+  // 다음 Poll() 에서 이 소켓의 OnSend() 가 호출되도록 한다. 어느 스레드에서나 호출할 수 있다.
+  void RequestSend();
+
  protected:
   static fun::string GetStringFromAddrInfo(struct addrinfo *info);
 
@@ -124,18 +165,25 @@ class FunapiSocketImpl : public std::enable_shared_from_this<FunapiSocketImpl> {
   HANDLE GetEventHandle();
 #endif // FUNAPI_PLATFORM_WINDOWS
 
-  bool InitAddrInfo(int socktype,
-                    const char* hostname_or_ip,
-                    const int port,
-                    int &error_code,
-                    fun::string &error_string);
-  void FreeAddrInfo();
+  // 조회한 주소로 addrinfo_res_ 를 초기화한다. 소켓이 살아 있는 동안 결과를 유지한다.
+  void SetAddrInfo(std::shared_ptr<FunapiAddrInfo> addrinfo);
 
   bool InitSocket(struct addrinfo *info,
                   int &error_code,
                   fun::string &error_string);
 
   bool InitNonblockingSocket(int &error_code, fun::string &error_string);
+  static bool InitNonblockingSocket(const int fd, int &error_code, fun::string &error_string);
+
+  // fd 를 이 소켓의 descriptor 로 사용하고 poller 에 등록한다.
+  void SetSocket(const int fd);
+
+  // poller 에서 descriptor 를 빼고 닫지 않은 채로 돌려준다.
+  int DetachSocket();
+
+  // IsReadyToPoll() 이나 GetPollEvents() 가 바뀌었을 때 호출한다.
+  // epoll 은 준비된 소켓만 등록하고 준비되지 않은 소켓은 등록을 해제한다.
+  void UpdatePollEvents();
 
   void CloseSocket();
 
@@ -148,99 +196,138 @@ class FunapiSocketImpl : public std::enable_shared_from_this<FunapiSocketImpl> {
   virtual void OnSend() = 0;
   virtual void OnRecv() = 0;
 
+  static fun::vector<uint8_t>& GetRecvBuffer();
+
  private:
-  static fun::vector<std::shared_ptr<FunapiSocketImpl>> GetSocketImpls();
+  static fun::vector<std::shared_ptr<FunapiSocketImpl>> GetSocketImpls(const int network_thread_index);
+  static int RunExpiredTimers(const int network_thread_index);
+
+  // 깨우기 신호를 받은 poller 가 호출한다. 보낼 것이 있는 소켓의 OnSend() 만 호출한다.
+  static void OnWakeUp(const int network_thread_index);
 
   virtual bool IsReadyToPoll();
 
+#ifndef FUNAPI_PLATFORM_WINDOWS
+  // poller 가 기다릴 이벤트. 연결 중이거나 보내지 못한 프레임이 남은 소켓은 POLLOUT 을 기다린다.
+  virtual short GetPollEvents();
+#endif // FUNAPI_PLATFORM_WINDOWS
+
  protected:
   static const int kBufferSize = 65536;
 
   int socket_ = -1;
-  struct addrinfo *addrinfo_ = nullptr;
+  std::shared_ptr<FunapiAddrInfo> addrinfo_;
   struct addrinfo *addrinfo_res_ = nullptr;
 #ifdef FUNAPI_PLATFORM_WINDOWS
   HANDLE event_handle_ = nullptr;
 #endif // FUNAPI_PLATFORM_WINDOWS
 
  private:
-   static fun::vector<std::weak_ptr<FunapiSocketImpl>> vec_sockets_;
-   static std::mutex vec_sockets_mutex_;
+   struct TimerEntry {
+     TimePoint expired_time;
+     std::shared_ptr<TimerHandler> handler;
+
+     // std::push_heap 은 max heap 이므로 만료 시각이 빠른 것이 top 이 되도록 한다.
+     bool operator<(const TimerEntry &other) const {
+       return expired_time > other.expired_time;
+     }
+   };
+
+   // 네트워크 스레드 하나가 담당하는 소켓과 타이머.
+   struct Shard {
+     fun::vector<std::weak_ptr<FunapiSocketImpl>> vec_sockets_;
+     std::mutex vec_sockets_mutex_;
+
+     fun::vector<TimerEntry> timer_heap_;
+     std::mutex timer_heap_mutex_;
+
+     // RequestSend() 로 보낼 것이 있다고 알린 소켓들.
+     fun::vector<std::weak_ptr<FunapiSocketImpl>> dirty_sockets_;
+     std::mutex dirty_sockets_mutex_;
+     std::atomic<std::thread::id> poll_thread_id_{ std::thread::id() };
+   };
+
+   static Shard& GetShard(const int network_thread_index);
+
+   // Add() 로 poller 에 등록된 이후에 생성된 소켓은 InitSocket() 에서 등록한다.
+   bool is_added_ = false;
+
+   // dirty_sockets_ 에 이미 들어 있으면 true.
+   std::atomic<bool> send_requested_{ false };
+
+ protected:
+   // 소켓이 생성된 네트워크 스레드의 번호. 다른 스레드에서 생성되면 0 이다.
+   int network_thread_index_ = 0;
 };
 
 
-fun::string FunapiSocketImpl::GetStringFromAddrInfo(struct addrinfo *info) {
-  if (info) {
-    char addrStr[INET6_ADDRSTRLEN];
-    if (info->ai_family == AF_INET)
-    {
-      struct sockaddr_in *sin = (struct sockaddr_in*) info->ai_addr;
-      inet_ntop(info->ai_family, (void*)&sin->sin_addr, addrStr, sizeof(addrStr));
-    }
-    else if (info->ai_family == AF_INET6)
-    {
-      struct sockaddr_in6 *sin = (struct sockaddr_in6*) info->ai_addr;
-      inet_ntop(info->ai_family, (void*)&sin->sin6_addr, addrStr, sizeof(addrStr));
-    }
+////////////////////////////////////////////////////////////////////////////////
+// FunapiSocketPoller implementation.
 
-    return fun::string(addrStr);
-  }
+class FunapiSocketPoller {
+ public:
+  FunapiSocketPoller(const int network_thread_index);
+  virtual ~FunapiSocketPoller() = default;
 
-  return "NULL";
+  static FunapiSocketPoller& Get(const int network_thread_index);
+
+  // Called once a socket has a valid descriptor.
+  virtual void Register(const std::shared_ptr<FunapiSocketImpl> &s) = 0;
+  // Called right before the descriptor is closed.
+  virtual void Unregister(const int fd) = 0;
+
+  virtual bool Poll(const int timeout_ms) = 0;
+
+ protected:
+  int network_thread_index_ = 0;
+
+ private:
+  static FunapiSocketPoller* Create(const int network_thread_index);
+};
+
+
+FunapiSocketPoller::FunapiSocketPoller(const int network_thread_index)
+  : network_thread_index_(network_thread_index) {
 }
 
 
-fun::vector<std::weak_ptr<FunapiSocketImpl>> FunapiSocketImpl::vec_sockets_;
-std::mutex FunapiSocketImpl::vec_sockets_mutex_;
+#ifdef FUNAPI_PLATFORM_WINDOWS
+////////////////////////////////////////////////////////////////////////////////
+// FunapiSocketWSAPoller implementation.
+
+class FunapiSocketWSAPoller : public FunapiSocketPoller {
+ public:
+  FunapiSocketWSAPoller(const int network_thread_index);
 
+  void Register(const std::shared_ptr<FunapiSocketImpl> &s);
+  void Unregister(const int fd);
 
-void FunapiSocketImpl::Add(std::shared_ptr<FunapiSocketImpl> s) {
-  std::unique_lock<std::mutex> lock(vec_sockets_mutex_);
-  vec_sockets_.push_back(s);
+  bool Poll(const int timeout_ms);
+};
+
+
+FunapiSocketWSAPoller::FunapiSocketWSAPoller(const int network_thread_index)
+  : FunapiSocketPoller(network_thread_index) {
 }
 
 
-fun::vector<std::shared_ptr<FunapiSocketImpl>> FunapiSocketImpl::GetSocketImpls() {
-  fun::vector<std::shared_ptr<FunapiSocketImpl>> v_sockets;
-  fun::vector<std::weak_ptr<FunapiSocketImpl>> v_weak_sockets;
-  {
-    std::unique_lock<std::mutex> lock(vec_sockets_mutex_);
-    if (!vec_sockets_.empty()) {
-      for (auto i : vec_sockets_) {
-        if (auto s = i.lock()) {
-          v_sockets.push_back(s);
-          v_weak_sockets.push_back(i);
-        }
-      }
+void FunapiSocketWSAPoller::Register(const std::shared_ptr<FunapiSocketImpl> &s) {
+}
 
-      vec_sockets_.swap(v_weak_sockets);
-    }
-  }
 
-  return v_sockets;
+void FunapiSocketWSAPoller::Unregister(const int fd) {
 }
 
 
-// extern function in funapi_session.cpp
-void OnSessionTicked();
-bool FunapiSocketImpl::Poll()
+bool FunapiSocketWSAPoller::Poll(const int timeout_ms)
 {
-  static FunapiTimer session_tick_timer;
-  if (session_tick_timer.IsExpired())
-  {
-    OnSessionTicked();
-    session_tick_timer.SetTimer(1);
-  }
-
   fun::vector<std::shared_ptr<FunapiSocketImpl>> socket_impls =
-      GetSocketImpls();
-
+      FunapiSocketImpl::GetSocketImpls(network_thread_index_);
 
-#ifdef FUNAPI_PLATFORM_WINDOWS
   int num_handles = 0;
   fun::vector<HANDLE> handles(WSA_MAXIMUM_WAIT_EVENTS);
 
-  handles[0] = FunapiSendFlagManager::Get().GetEvent();
+  handles[0] = FunapiSendFlagManager::Get().GetEvent(network_thread_index_);
   ++num_handles;
 
   for (int i = 0; i < socket_impls.size(); ++i)
@@ -261,7 +348,7 @@ bool FunapiSocketImpl::Poll()
 
   DWORD ret =
     WSAWaitForMultipleEvents(num_handles, &handles[0], /*any event*/false,
-                             /*msec*/1, /*no alertable*/false);
+                             /*msec*/timeout_ms, /*no alertable*/false);
 
   if (ret == WSA_WAIT_FAILED)
   {
@@ -284,11 +371,7 @@ bool FunapiSocketImpl::Poll()
   int index = ret - WSA_WAIT_EVENT_0;
   if (index == 0)
   {
-    FunapiSendFlagManager::Get().ResetWakeUp();
-    for (auto &s : socket_impls)
-    {
-      s->OnSend();
-    }
+    FunapiSocketImpl::OnWakeUp(network_thread_index_);
   }
 
   for (auto &s : socket_impls)
@@ -309,20 +392,50 @@ bool FunapiSocketImpl::Poll()
     }
   }
 
+  return true;
+}
 #else // FUNAPI_PLATFORM_WINDOWS
+////////////////////////////////////////////////////////////////////////////////
+// FunapiSocketPollPoller implementation.
+// NOTE: epoll 을 사용할 수 없는 플랫폼(macOS, iOS 등)을 위한 poll() 기반 구현.
+
+class FunapiSocketPollPoller : public FunapiSocketPoller {
+ public:
+  FunapiSocketPollPoller(const int network_thread_index);
+
+  void Register(const std::shared_ptr<FunapiSocketImpl> &s);
+  void Unregister(const int fd);
+
+  bool Poll(const int timeout_ms);
+};
+
+
+FunapiSocketPollPoller::FunapiSocketPollPoller(const int network_thread_index)
+  : FunapiSocketPoller(network_thread_index) {
+}
+
+
+void FunapiSocketPollPoller::Register(const std::shared_ptr<FunapiSocketImpl> &s) {
+}
+
+
+void FunapiSocketPollPoller::Unregister(const int fd) {
+}
+
+
+bool FunapiSocketPollPoller::Poll(const int timeout_ms)
+{
+  fun::vector<std::shared_ptr<FunapiSocketImpl>> socket_impls =
+      FunapiSocketImpl::GetSocketImpls(network_thread_index_);
+
   static const int MAX_POLLFDS = 1024;
   struct pollfd pollfds[MAX_POLLFDS];
   int num_pollfds = 0;
 
-  int* pipe_fds = FunapiSendFlagManager::Get().GetPipeFds();
-  for (int i = 0; i < 2; ++i)
-  {
-    int fd = pipe_fds[i];
-    pollfds[num_pollfds].fd = fd;
-    pollfds[num_pollfds].events = POLLIN | POLLPRI;
-    pollfds[num_pollfds].revents = 0;
-    ++num_pollfds;
-  }
+  pollfds[num_pollfds].fd = FunapiSendFlagManager::Get().GetWakeUpFd(network_thread_index_);
+  pollfds[num_pollfds].events = POLLIN | POLLPRI;
+  pollfds[num_pollfds].revents = 0;
+  ++num_pollfds;
 
   for (auto &s : socket_impls)
   {
@@ -336,13 +449,13 @@ bool FunapiSocketImpl::Poll()
     {
       assert(num_pollfds + 1 < MAX_POLLFDS);
       pollfds[num_pollfds].fd = fd;
-      pollfds[num_pollfds].events = POLLIN | POLLPRI;
+      pollfds[num_pollfds].events = s->GetPollEvents();
       pollfds[num_pollfds].revents = 0;
       ++num_pollfds;
     }
   }
 
-  int ret = poll(pollfds, num_pollfds, 1);
+  int ret = poll(pollfds, num_pollfds, timeout_ms);
 
   if (ret < 0)
   {
@@ -363,11 +476,7 @@ bool FunapiSocketImpl::Poll()
   // SEND
   if ((pollfds[0].revents & POLLIN))
   {
-    FunapiSendFlagManager::Get().ResetWakeUp();
-    for (auto &s : socket_impls)
-    {
-      s->OnSend();
-    }
+    FunapiSocketImpl::OnWakeUp(network_thread_index_);
     return true;
   }
 
@@ -392,196 +501,1008 @@ bool FunapiSocketImpl::Poll()
       }
     }
   }
-#endif // FUNAPI_PLATFORM_WINDOWS
+
   return true;
 }
 
 
-FunapiSocketImpl::FunapiSocketImpl() {
-}
+#if FUNAPI_HAVE_EPOLL
+////////////////////////////////////////////////////////////////////////////////
+// FunapiSocketEpollPoller implementation.
+// NOTE: 소켓은 fd 가 생성될 때 한 번만 등록되고 epoll_wait 는 준비된 fd 만
+// 돌려주므로, 세션 수가 많아도 Poll() 비용은 실제 이벤트 수에만 비례한다.
 
+class FunapiSocketEpollPoller : public FunapiSocketPoller {
+ public:
+  FunapiSocketEpollPoller(const int network_thread_index);
+  virtual ~FunapiSocketEpollPoller();
 
-FunapiSocketImpl::~FunapiSocketImpl() {
-  CloseSocket();
-  FreeAddrInfo();
-  // DebugUtils::Log("%s", __FUNCTION__);
+  bool IsValid();
+
+  void Register(const std::shared_ptr<FunapiSocketImpl> &s);
+  void Unregister(const int fd);
+
+  bool Poll(const int timeout_ms);
+
+ private:
+  static short ToPollEvents(uint32_t epoll_events);
+
+  static const int kMaxEvents = 256;
+
+  int epoll_fd_ = -1;
+  int wakeup_fd_ = -1;
+
+  fun::unordered_map<int, std::weak_ptr<FunapiSocketImpl>> sockets_;
+  std::mutex sockets_mutex_;
+
+  struct epoll_event events_[kMaxEvents];
+  fun::vector<std::pair<std::shared_ptr<FunapiSocketImpl>, short>> ready_sockets_;
+};
+
+
+FunapiSocketEpollPoller::FunapiSocketEpollPoller(const int network_thread_index)
+  : FunapiSocketPoller(network_thread_index) {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    DebugUtils::Log("epoll_create1 failed, error code : %d, error message : %s",
+                    errno, strerror(errno));
+    return;
+  }
+
+  wakeup_fd_ = FunapiSendFlagManager::Get().GetWakeUpFd(network_thread_index_);
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLPRI;
+  ev.data.fd = wakeup_fd_;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &ev) < 0) {
+    DebugUtils::Log("epoll_ctl failed, error code : %d, error message : %s",
+                    errno, strerror(errno));
+    close(epoll_fd_);
+    epoll_fd_ = -1;
+  }
 }
 
 
-int FunapiSocketImpl::GetSocket() {
-  return socket_;
+FunapiSocketEpollPoller::~FunapiSocketEpollPoller() {
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
 }
 
 
-bool FunapiSocketImpl::IsReadyToPoll() {
-  return true;
+bool FunapiSocketEpollPoller::IsValid() {
+  return epoll_fd_ >= 0;
 }
 
 
-void FunapiSocketImpl::FreeAddrInfo() {
-  if (addrinfo_) {
-    freeaddrinfo(addrinfo_);
-  }
+short FunapiSocketEpollPoller::ToPollEvents(uint32_t epoll_events) {
+  short revents = 0;
+  if (epoll_events & EPOLLIN) revents |= POLLIN;
+  if (epoll_events & EPOLLPRI) revents |= POLLPRI;
+  if (epoll_events & EPOLLOUT) revents |= POLLOUT;
+  if (epoll_events & EPOLLHUP) revents |= POLLHUP;
+  if (epoll_events & EPOLLERR) revents |= POLLERR;
+  return revents;
 }
 
 
-bool FunapiSocketImpl::InitAddrInfo(int socktype,
-                                    const char* hostname_or_ip,
-                                    const int port,
-                                    int &error_code,
-                                    fun::string &error_string) {
-#ifdef FUNAPI_COCOS2D_PLATFORM_WINDOWS
-  static auto wsa_init = FunapiInit::Create([](){
-    WSADATA wsaData;
-    WSAStartup(MAKEWORD(2, 2), &wsaData);
-  }, [](){
-    WSACleanup();
-  });
-#endif
+void FunapiSocketEpollPoller::Register(const std::shared_ptr<FunapiSocketImpl> &s) {
+  int fd = s->GetSocket();
+  if (fd < 0) {
+    return;
+  }
 
-  struct addrinfo hints;
+  std::unique_lock<std::mutex> lock(sockets_mutex_);
 
-  fun::stringstream ss_port;
-  ss_port << static_cast<int>(port);
+  short events = s->GetPollEvents();
 
-  memset(&hints, 0, sizeof(hints));
-  hints.ai_family = AF_UNSPEC;
-  hints.ai_socktype = socktype;
-  error_code = getaddrinfo(hostname_or_ip, ss_port.str().c_str(), &hints, &addrinfo_);
-  if (error_code) {
-    error_string = (char*)gai_strerror(error_code);
-    return false;
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  if (events & POLLIN) ev.events |= EPOLLIN;
+  if (events & POLLPRI) ev.events |= EPOLLPRI;
+  if (events & POLLOUT) ev.events |= EPOLLOUT;
+  ev.data.fd = fd;
+
+  int op = (sockets_.find(fd) == sockets_.end()) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+  if (epoll_ctl(epoll_fd_, op, fd, &ev) < 0) {
+    DebugUtils::Log("epoll_ctl failed, fd : %d, error code : %d, error message : %s",
+                    fd, errno, strerror(errno));
+    return;
   }
 
-  return true;
+  sockets_[fd] = s;
 }
 
 
-void FunapiSocketImpl::CloseSocket() {
-  // DebugUtils::Log("%s", __FUNCTION__);
-
-  if (socket_ >= 0) {
-    // DebugUtils::Log("Socket [%d] closed.", socket_);
+void FunapiSocketEpollPoller::Unregister(const int fd) {
+  std::unique_lock<std::mutex> lock(sockets_mutex_);
 
-#ifdef FUNAPI_PLATFORM_WINDOWS
-    closesocket(socket_);
-#else
-    close(socket_);
-#endif
-    socket_ = -1;
+  auto iter = sockets_.find(fd);
+  if (iter == sockets_.end()) {
+    return;
   }
+
+  sockets_.erase(iter);
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
 }
 
 
-bool FunapiSocketImpl::InitSocket(struct addrinfo *info,
-                                  int &error_code,
-                                  fun::string &error_string) {
-  if (!info) {
+bool FunapiSocketEpollPoller::Poll(const int timeout_ms) {
+  int ret = epoll_wait(epoll_fd_, events_, kMaxEvents, timeout_ms);
+
+  if (ret < 0)
+  {
+    if (errno == EINTR)
+    {
+      return true;
+    }
+
+    int error_cd = FunapiUtil::GetSocketErrorCode();
+    DebugUtils::Log(
+      "Socket epoll_wait failed, error code : %d, error message : %s",
+      error_cd,
+      FunapiUtil::GetSocketErrorString(error_cd).c_str());
     return false;
   }
 
-  int fd = -1;
+  // TIME OUT
+  if (ret == 0)
+  {
+    return true;
+  }
 
-  for (addrinfo_res_ = info;addrinfo_res_;addrinfo_res_ = addrinfo_res_->ai_next) {
-    fd = socket(addrinfo_res_->ai_family,
-                addrinfo_res_->ai_socktype,
-                addrinfo_res_->ai_protocol);
-    if (fd < 0) {
-      switch errno {
-      case EAFNOSUPPORT:
-      case EPROTONOSUPPORT:
-        if (addrinfo_res_->ai_next)
-          continue;
-        else {
-          break;
-        }
+  bool wakeup = false;
+  ready_sockets_.clear();
+  {
+    std::unique_lock<std::mutex> lock(sockets_mutex_);
+    for (int i = 0; i < ret; ++i)
+    {
+      int fd = events_[i].data.fd;
+      if (fd == wakeup_fd_)
+      {
+        wakeup = true;
+        continue;
+      }
 
-      default:
-        /* handle other socket errors */
-        ;
+      auto iter = sockets_.find(fd);
+      if (iter == sockets_.end())
+      {
+        continue;
+      }
+
+      if (auto s = iter->second.lock())
+      {
+        ready_sockets_.push_back(std::make_pair(s, ToPollEvents(events_[i].events)));
       }
     }
-    else {
-      break;
+  }
+
+  // SEND
+  if (wakeup)
+  {
+    FunapiSocketImpl::OnWakeUp(network_thread_index_);
+  }
+
+  // RECV
+  for (auto &p : ready_sockets_)
+  {
+    // OnSend() 중에 소켓이 닫혔을 수 있다.
+    if (p.first->GetSocket() > 0 && p.first->IsReadyToPoll())
+    {
+      p.first->OnPoll(p.second);
     }
   }
+  ready_sockets_.clear();
 
-  if (fd < 0) {
-    error_code = FunapiUtil::GetSocketErrorCode();
-    error_string = FunapiUtil::GetSocketErrorString(error_code);
-    return false;
+  return true;
+}
+#endif // FUNAPI_HAVE_EPOLL
+#endif // FUNAPI_PLATFORM_WINDOWS
+
+
+FunapiSocketPoller* FunapiSocketPoller::Create(const int network_thread_index) {
+#ifdef FUNAPI_PLATFORM_WINDOWS
+  return new FunapiSocketWSAPoller(network_thread_index);
+#else // FUNAPI_PLATFORM_WINDOWS
+#if FUNAPI_HAVE_EPOLL
+  auto epoll_poller = new FunapiSocketEpollPoller(network_thread_index);
+  if (epoll_poller->IsValid()) {
+    return epoll_poller;
+  }
+
+  delete epoll_poller;
+  DebugUtils::Log("epoll is not available. Falling back to poll().");
+#endif // FUNAPI_HAVE_EPOLL
+  return new FunapiSocketPollPoller(network_thread_index);
+#endif // FUNAPI_PLATFORM_WINDOWS
+}
+
+
+FunapiSocketPoller& FunapiSocketPoller::Get(const int network_thread_index) {
+  // NOTE: 소켓의 소멸자에서도 Unregister() 를 호출하므로 해제하지 않는다.
+  static std::once_flag init_flags[FunapiThread::kMaxNetworkThreadCount];
+  static FunapiSocketPoller* pollers[FunapiThread::kMaxNetworkThreadCount] = { nullptr, };
+
+  std::call_once(init_flags[network_thread_index], [network_thread_index]() {
+    pollers[network_thread_index] = FunapiSocketPoller::Create(network_thread_index);
+  });
+
+  return *pollers[network_thread_index];
+}
+
+
+fun::string FunapiSocketImpl::GetStringFromAddrInfo(struct addrinfo *info) {
+  if (info) {
+    char addrStr[INET6_ADDRSTRLEN];
+    if (info->ai_family == AF_INET)
+    {
+      struct sockaddr_in *sin = (struct sockaddr_in*) info->ai_addr;
+      inet_ntop(info->ai_family, (void*)&sin->sin_addr, addrStr, sizeof(addrStr));
+    }
+    else if (info->ai_family == AF_INET6)
+    {
+      struct sockaddr_in6 *sin = (struct sockaddr_in6*) info->ai_addr;
+      inet_ntop(info->ai_family, (void*)&sin->sin6_addr, addrStr, sizeof(addrStr));
+    }
+
+    return fun::string(addrStr);
+  }
+
+  return "NULL";
+}
+
+
+// Poll() 을 수행 중인 네트워크 스레드의 번호.
+static thread_local int current_network_thread_index = 0;
+
+
+FunapiSocketImpl::Shard& FunapiSocketImpl::GetShard(const int network_thread_index) {
+  // NOTE: 소켓의 소멸자보다 먼저 해제되지 않도록 해제하지 않는다.
+  static Shard* shards = new Shard[FunapiThread::kMaxNetworkThreadCount];
+  return shards[network_thread_index];
+}
+
+
+void FunapiSocketImpl::Add(std::shared_ptr<FunapiSocketImpl> s) {
+  // 소켓은 생성한 네트워크 스레드에 고정된다.
+  Add(s, current_network_thread_index);
+}
+
+
+void FunapiSocketImpl::Add(std::shared_ptr<FunapiSocketImpl> s, const int network_thread_index) {
+  s->network_thread_index_ = network_thread_index;
+
+  Shard &shard = GetShard(s->network_thread_index_);
+  {
+    std::unique_lock<std::mutex> lock(shard.vec_sockets_mutex_);
+    shard.vec_sockets_.push_back(s);
+  }
+
+  s->is_added_ = true;
+  if (s->socket_ >= 0 && s->IsReadyToPoll()) {
+    FunapiSocketPoller::Get(s->network_thread_index_).Register(s);
+  }
+}
+
+
+fun::vector<std::shared_ptr<FunapiSocketImpl>> FunapiSocketImpl::GetSocketImpls(const int network_thread_index) {
+  Shard &shard = GetShard(network_thread_index);
+
+  fun::vector<std::shared_ptr<FunapiSocketImpl>> v_sockets;
+  fun::vector<std::weak_ptr<FunapiSocketImpl>> v_weak_sockets;
+  {
+    std::unique_lock<std::mutex> lock(shard.vec_sockets_mutex_);
+    if (!shard.vec_sockets_.empty()) {
+      for (auto i : shard.vec_sockets_) {
+        if (auto s = i.lock()) {
+          v_sockets.push_back(s);
+          v_weak_sockets.push_back(i);
+        }
+      }
+
+      shard.vec_sockets_.swap(v_weak_sockets);
+    }
+  }
+
+  return v_sockets;
+}
+
+
+void FunapiSocketImpl::AddTimer(const int network_thread_index,
+                                const TimePoint &expired_time,
+                                const TimerHandler &handler) {
+  Shard &shard = GetShard(network_thread_index);
+
+  bool is_earliest = false;
+  {
+    std::unique_lock<std::mutex> lock(shard.timer_heap_mutex_);
+    TimerEntry entry;
+    entry.expired_time = expired_time;
+    entry.handler = std::make_shared<TimerHandler>(handler);
+    shard.timer_heap_.push_back(entry);
+    std::push_heap(shard.timer_heap_.begin(), shard.timer_heap_.end());
+
+    is_earliest = (shard.timer_heap_.front().handler == entry.handler);
+  }
+
+  // 다른 스레드에서 더 이른 타이머가 추가되면 대기 중인 Poll() 을 깨워
+  // 대기 시간을 다시 계산하게 한다.
+  if (is_earliest && std::this_thread::get_id() != shard.poll_thread_id_.load()) {
+    FunapiSendFlagManager::Get().Signal(network_thread_index);
+  }
+}
+
+
+void FunapiSocketImpl::RequestSend() {
+  if (!send_requested_.exchange(true)) {
+    Shard &shard = GetShard(network_thread_index_);
+    std::unique_lock<std::mutex> lock(shard.dirty_sockets_mutex_);
+    shard.dirty_sockets_.push_back(shared_from_this());
+  }
+
+  FunapiSendFlagManager::Get().Signal(network_thread_index_);
+}
+
+
+void FunapiSocketImpl::OnWakeUp(const int network_thread_index) {
+  const bool wakeup_all = FunapiSendFlagManager::Get().ResetWakeUp(network_thread_index);
+
+  Shard &shard = GetShard(network_thread_index);
+  fun::vector<std::weak_ptr<FunapiSocketImpl>> dirty_sockets;
+  {
+    std::unique_lock<std::mutex> lock(shard.dirty_sockets_mutex_);
+    dirty_sockets.swap(shard.dirty_sockets_);
+  }
+
+  // NOTE: OnSend() 중에 다시 RequestSend() 를 할 수 있도록 플래그를 먼저 내린다.
+  fun::vector<std::shared_ptr<FunapiSocketImpl>> socket_impls;
+  for (auto &w : dirty_sockets) {
+    if (auto s = w.lock()) {
+      s->send_requested_.store(false);
+      if (!wakeup_all) {
+        socket_impls.push_back(s);
+      }
+    }
+  }
+
+  if (wakeup_all) {
+    socket_impls = GetSocketImpls(network_thread_index);
+  }
+
+  for (auto &s : socket_impls) {
+    s->OnSend();
+  }
+}
+
+
+// NOTE: 수신 버퍼는 네트워크 스레드마다 하나를 두고 재사용한다.
+// recv_handler_ 는 호출 중에만 버퍼를 사용해야 한다.
+static std::atomic<uint64_t> recv_buffer_allocation_count(0);
+
+
+fun::vector<uint8_t>& FunapiSocketImpl::GetRecvBuffer() {
+  static thread_local fun::vector<uint8_t> buffer;
+
+  if (buffer.capacity() < static_cast<size_t>(kBufferSize)) {
+    ++recv_buffer_allocation_count;
+  }
+
+  if (buffer.size() != static_cast<size_t>(kBufferSize)) {
+    buffer.resize(kBufferSize);
+  }
+
+  return buffer;
+}
+
+
+uint64_t FunapiSocketImpl::GetRecvBufferAllocationCount() {
+  return recv_buffer_allocation_count.load();
+}
+
+
+int FunapiSocketImpl::RunExpiredTimers(const int network_thread_index) {
+  Shard &shard = GetShard(network_thread_index);
+
+  // NOTE: 타이머를 놓치더라도 세션 상태가 갱신되도록 대기 시간의 상한을 둔다.
+  static const int kMaxPollTimeoutMs = 1000;
+
+  fun::vector<std::shared_ptr<TimerHandler>> expired_handlers;
+  int timeout_ms = kMaxPollTimeoutMs;
+  {
+    std::unique_lock<std::mutex> lock(shard.timer_heap_mutex_);
+    auto now = std::chrono::steady_clock::now();
+    while (!shard.timer_heap_.empty() && shard.timer_heap_.front().expired_time <= now) {
+      expired_handlers.push_back(shard.timer_heap_.front().handler);
+      std::pop_heap(shard.timer_heap_.begin(), shard.timer_heap_.end());
+      shard.timer_heap_.pop_back();
+    }
+
+    if (expired_handlers.empty() && !shard.timer_heap_.empty()) {
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+          shard.timer_heap_.front().expired_time - now).count() + 1;
+      if (remaining < timeout_ms) {
+        timeout_ms = static_cast<int>(remaining);
+      }
+    }
+  }
+
+  for (auto &h : expired_handlers) {
+    (*h)();
+  }
+
+  // 핸들러가 새 타이머를 추가했을 수 있으므로 바로 다시 확인하도록 한다.
+  if (!expired_handlers.empty()) {
+    return 0;
+  }
+
+  return timeout_ms;
+}
+
+
+// extern function in funapi_session.cpp
+void OnSessionTicked(const int network_thread_index);
+bool FunapiSocketImpl::Poll(const int network_thread_index)
+{
+  current_network_thread_index = network_thread_index;
+  GetShard(network_thread_index).poll_thread_id_ = std::this_thread::get_id();
+
+  static thread_local FunapiTimer session_tick_timer;
+  if (session_tick_timer.IsExpired())
+  {
+    OnSessionTicked(network_thread_index);
+    session_tick_timer.SetTimer(1);
+  }
+
+  return FunapiSocketPoller::Get(network_thread_index).Poll(RunExpiredTimers(network_thread_index));
+}
+
+
+FunapiSocketImpl::FunapiSocketImpl() {
+}
+
+
+FunapiSocketImpl::~FunapiSocketImpl() {
+  CloseSocket();
+  // DebugUtils::Log("%s", __FUNCTION__);
+}
+
+
+int FunapiSocketImpl::GetSocket() {
+  return socket_;
+}
+
+
+bool FunapiSocketImpl::IsReadyToPoll() {
+  return true;
+}
+
+
+#ifndef FUNAPI_PLATFORM_WINDOWS
+short FunapiSocketImpl::GetPollEvents() {
+  return POLLIN | POLLPRI;
+}
+#endif // FUNAPI_PLATFORM_WINDOWS
+
+
+void FunapiSocketImpl::SetAddrInfo(std::shared_ptr<FunapiAddrInfo> addrinfo) {
+  addrinfo_ = addrinfo;
+  addrinfo_res_ = addrinfo_ ? addrinfo_->GetImpl()->GetAddrInfo() : nullptr;
+}
+
+
+void FunapiSocketImpl::CloseSocket() {
+  // DebugUtils::Log("%s", __FUNCTION__);
+
+  if (socket_ >= 0) {
+    // DebugUtils::Log("Socket [%d] closed.", socket_);
+    FunapiSocketPoller::Get(network_thread_index_).Unregister(socket_);
+
+#ifdef FUNAPI_PLATFORM_WINDOWS
+    closesocket(socket_);
+#else
+    close(socket_);
+#endif
+    socket_ = -1;
+  }
+}
+
+
+bool FunapiSocketImpl::InitSocket(struct addrinfo *info,
+                                  int &error_code,
+                                  fun::string &error_string) {
+  if (!info) {
+    return false;
+  }
+
+  int fd = -1;
+
+  for (addrinfo_res_ = info;addrinfo_res_;addrinfo_res_ = addrinfo_res_->ai_next) {
+    fd = socket(addrinfo_res_->ai_family,
+                addrinfo_res_->ai_socktype,
+                addrinfo_res_->ai_protocol);
+    if (fd < 0) {
+      switch errno {
+      case EAFNOSUPPORT:
+      case EPROTONOSUPPORT:
+        if (addrinfo_res_->ai_next)
+          continue;
+        else {
+          break;
+        }
+
+      default:
+        /* handle other socket errors */
+        ;
+      }
+    }
+    else {
+      break;
+    }
+  }
+
+  if (fd < 0) {
+    error_code = FunapiUtil::GetSocketErrorCode();
+    error_string = FunapiUtil::GetSocketErrorString(error_code);
+    return false;
+  }
+
+  SetSocket(fd);
+
+  return true;
+}
+
+
+void FunapiSocketImpl::SetSocket(const int fd) {
+  socket_ = fd;
+
+  if (is_added_ && socket_ >= 0 && IsReadyToPoll()) {
+    FunapiSocketPoller::Get(network_thread_index_).Register(shared_from_this());
+  }
+}
+
+
+void FunapiSocketImpl::UpdatePollEvents() {
+#ifndef FUNAPI_PLATFORM_WINDOWS
+  // poll() 은 매번 IsReadyToPoll(), GetPollEvents() 를 읽으므로 Register(), Unregister() 가 아무 일도 하지 않는다.
+  // level-triggered epoll 에 준비되지 않은 소켓을 남겨 두면 읽을 데이터가 있는 동안 epoll_wait 가 바로 돌아온다.
+  if (is_added_ && socket_ >= 0) {
+    if (IsReadyToPoll()) {
+      FunapiSocketPoller::Get(network_thread_index_).Register(shared_from_this());
+    }
+    else {
+      FunapiSocketPoller::Get(network_thread_index_).Unregister(socket_);
+    }
+  }
+#endif // FUNAPI_PLATFORM_WINDOWS
+}
+
+
+int FunapiSocketImpl::DetachSocket() {
+  int fd = socket_;
+
+  if (socket_ >= 0) {
+    FunapiSocketPoller::Get(network_thread_index_).Unregister(socket_);
+    socket_ = -1;
+  }
+
+  return fd;
+}
+
+
+bool FunapiSocketImpl::InitNonblockingSocket(int &error_code,
+                                             fun::string &error_string)
+{
+  return InitNonblockingSocket(socket_, error_code, error_string);
+}
+
+
+bool FunapiSocketImpl::InitNonblockingSocket(const int fd,
+                                             int &error_code,
+                                             fun::string &error_string)
+{
+  do {
+#ifdef FUNAPI_PLATFORM_WINDOWS
+    u_long argp = 1;
+    if (ioctlsocket(fd, FIONBIO, &argp) == 0) {
+      return true;
+    }
+#else // FUNAPI_PLATFORM_WINDOWS
+    int flag = fcntl(fd, F_GETFL);
+    if (flag < 0)
+      break;
+
+    if (fcntl(fd, F_SETFL, O_NONBLOCK | flag) == 0) {
+      return true;
+    }
+#endif // FUNAPI_PLATFORM_WINDOWS
+  } while (false);
+
+  error_code = FunapiUtil::GetSocketErrorCode();
+  error_string = FunapiUtil::GetSocketErrorString(error_code);
+  return false;
+}
+
+
+#ifdef FUNAPI_PLATFORM_WINDOWS
+void FunapiSocketImpl::SocketPoll(HANDLE handle)
+{
+  if (socket_ > 0)
+  {
+    WSANETWORKEVENTS networkEvents;
+    networkEvents.lNetworkEvents = 0;
+    if (WSAEnumNetworkEvents(socket_, handle, &networkEvents) == 0)
+    {
+      if (networkEvents.lNetworkEvents & FD_READ ||
+          networkEvents.lNetworkEvents & FD_CLOSE)
+      {
+        OnRecv();
+      }
+
+      if (socket_ > 0 && (networkEvents.lNetworkEvents & FD_WRITE))
+      {
+        OnSend();
+      }
+    }
+  }
+}
+#else // FUNAPI_PLATFORM_WINDOWS
+void FunapiSocketImpl::SocketPoll(short poll_revents)
+{
+  if (socket_ > 0)
+  {
+    if ((poll_revents & POLLIN) ||
+        (poll_revents & POLLHUP) ||
+        (poll_revents & POLLERR))
+    {
+      OnRecv();
+    }
+
+    if (socket_ > 0 && (poll_revents & POLLOUT))
+    {
+      OnSend();
+    }
+  }
+}
+#endif // FUNAPI_PLATFORM_WINDOWS
+
+
+#ifdef FUNAPI_PLATFORM_WINDOWS
+HANDLE FunapiSocketImpl::GetEventHandle() {
+  return event_handle_;
+}
+#endif // FUNAPI_PLATFORM_WINDOWS
+
+
+////////////////////////////////////////////////////////////////////////////////
+// FunapiTcpConnectAttempt implementation.
+// NOTE: 주소 하나로 진행 중인 non-blocking 연결. 다른 소켓과 같이 poller 에 등록되므로
+// 연결을 기다리는 동안 네트워크 스레드를 막지 않는다.
+
+class FunapiTcpConnectAttempt : public FunapiSocketImpl {
+ public:
+  typedef std::function<void(const int error_code)> CompletionHandler;
+
+  FunapiTcpConnectAttempt(struct addrinfo *info);
+  virtual ~FunapiTcpConnectAttempt();
+
+  // Add() 된 다음에 호출한다. 연결이 끝나면 completion_handler 가 한 번 호출된다.
+  bool Start(const bool disable_nagle,
+             const CompletionHandler &completion_handler,
+             int &error_code,
+             fun::string &error_string);
+
+  struct addrinfo* GetAddrInfo();
+
+  // 연결된 descriptor 를 넘겨준다. 이후에는 이 객체가 descriptor 를 닫지 않는다.
+  int Release();
+#ifdef FUNAPI_PLATFORM_WINDOWS
+  HANDLE ReleaseEventHandle();
+#endif // FUNAPI_PLATFORM_WINDOWS
+
+ protected:
+#ifdef FUNAPI_PLATFORM_WINDOWS
+  void OnPoll(HANDLE handle);
+#else // FUNAPI_PLATFORM_WINDOWS
+  void OnPoll(short poll_revents);
+  short GetPollEvents();
+#endif // FUNAPI_PLATFORM_WINDOWS
+
+  void OnSend();
+  void OnRecv();
+
+ private:
+  static bool InitTcpSocketOption(const int fd,
+                                  const bool disable_nagle,
+                                  int &error_code,
+                                  fun::string &error_string);
+
+  void OnCompletion(const int error_code);
+
+  struct addrinfo *info_ = nullptr;
+  CompletionHandler completion_handler_;
+};
+
+
+FunapiTcpConnectAttempt::FunapiTcpConnectAttempt(struct addrinfo *info)
+  : info_(info) {
+}
+
+
+FunapiTcpConnectAttempt::~FunapiTcpConnectAttempt() {
+  CloseSocket();
+
+#ifdef FUNAPI_PLATFORM_WINDOWS
+  if (event_handle_) {
+    WSACloseEvent(event_handle_);
+    event_handle_ = nullptr;
+  }
+#endif // FUNAPI_PLATFORM_WINDOWS
+}
+
+
+bool FunapiTcpConnectAttempt::Start(const bool disable_nagle,
+                                    const CompletionHandler &completion_handler,
+                                    int &error_code,
+                                    fun::string &error_string) {
+  completion_handler_ = completion_handler;
+
+  int fd = socket(info_->ai_family, info_->ai_socktype, info_->ai_protocol);
+  if (fd < 0) {
+    error_code = FunapiUtil::GetSocketErrorCode();
+    error_string = FunapiUtil::GetSocketErrorString(error_code);
+    return false;
+  }
+
+  SetSocket(fd);
+
+  if (!InitNonblockingSocket(error_code, error_string) ||
+      !InitTcpSocketOption(socket_, disable_nagle, error_code, error_string)) {
+    CloseSocket();
+    return false;
+  }
+
+#ifdef FUNAPI_PLATFORM_WINDOWS
+  event_handle_ = WSACreateEvent();
+  // FD_WRITE 는 연결된 뒤 이 이벤트를 넘겨받는 FunapiTcpImpl 이 사용한다.
+  if (WSAEventSelect(socket_, event_handle_,
+                     FD_READ | FD_WRITE | FD_CONNECT | FD_CLOSE) != 0)
+  {
+    error_code = FunapiUtil::GetSocketErrorCode();
+    error_string = FunapiUtil::GetSocketErrorString(error_code);
+    CloseSocket();
+    return false;
+  }
+#endif // FUNAPI_PLATFORM_WINDOWS
+
+  int rc = connect(socket_, info_->ai_addr, info_->ai_addrlen);
+  if (rc != 0) {
+    error_code = FunapiUtil::GetSocketErrorCode();
+#ifdef FUNAPI_PLATFORM_WINDOWS
+    if (error_code != WSAEWOULDBLOCK) {
+#else // FUNAPI_PLATFORM_WINDOWS
+    if (error_code != EINPROGRESS) {
+#endif // FUNAPI_PLATFORM_WINDOWS
+      error_string = FunapiUtil::GetSocketErrorString(error_code);
+      CloseSocket();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool FunapiTcpConnectAttempt::InitTcpSocketOption(const int fd,
+                                                  const bool disable_nagle,
+                                                  int &error_code,
+                                                  fun::string &error_string) {
+  // Disable nagle
+  if (disable_nagle) {
+    int nagle_flag = 1;
+    int result = setsockopt(fd,
+                            IPPROTO_TCP,
+                            TCP_NODELAY,
+                            reinterpret_cast<char*>(&nagle_flag),
+                            sizeof(int));
+    if (result < 0) {
+      // Error - TCP_NODELAY
+      error_code = FunapiUtil::GetSocketErrorCode();
+      error_string = FunapiUtil::GetSocketErrorString(error_code);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+struct addrinfo* FunapiTcpConnectAttempt::GetAddrInfo() {
+  return info_;
+}
+
+
+int FunapiTcpConnectAttempt::Release() {
+  completion_handler_ = nullptr;
+  return DetachSocket();
+}
+
+
+#ifdef FUNAPI_PLATFORM_WINDOWS
+HANDLE FunapiTcpConnectAttempt::ReleaseEventHandle() {
+  HANDLE event_handle = event_handle_;
+  event_handle_ = nullptr;
+  return event_handle;
+}
+
+
+void FunapiTcpConnectAttempt::OnPoll(HANDLE handle) {
+  if (socket_ < 0) {
+    return;
+  }
+
+  WSANETWORKEVENTS networkEvents;
+  networkEvents.lNetworkEvents = 0;
+  if (WSAEnumNetworkEvents(socket_, handle, &networkEvents) != 0) {
+    OnCompletion(FunapiUtil::GetSocketErrorCode());
+    return;
+  }
+
+  if (networkEvents.lNetworkEvents & FD_CONNECT) {
+    OnCompletion(networkEvents.iErrorCode[FD_CONNECT_BIT]);
+  }
+}
+#else // FUNAPI_PLATFORM_WINDOWS
+void FunapiTcpConnectAttempt::OnPoll(short poll_revents) {
+  if (socket_ < 0) {
+    return;
+  }
+
+  if (!(poll_revents & POLLOUT) &&
+      !(poll_revents & POLLHUP) &&
+      !(poll_revents & POLLERR)) {
+    return;
+  }
+
+  int error_code = 0;
+  socklen_t error_code_len = sizeof(error_code);
+  if (getsockopt(socket_, SOL_SOCKET, SO_ERROR, &error_code, &error_code_len) < 0) {
+    error_code = FunapiUtil::GetSocketErrorCode();
+  }
+  else if (error_code == 0 && !(poll_revents & POLLOUT)) {
+    error_code = ECONNREFUSED;
+  }
+
+  OnCompletion(error_code);
+}
+
+
+short FunapiTcpConnectAttempt::GetPollEvents() {
+  return POLLOUT;
+}
+#endif // FUNAPI_PLATFORM_WINDOWS
+
+
+void FunapiTcpConnectAttempt::OnSend() {
+}
+
+
+void FunapiTcpConnectAttempt::OnRecv() {
+}
+
+
+void FunapiTcpConnectAttempt::OnCompletion(const int error_code) {
+  CompletionHandler handler;
+  handler.swap(completion_handler_);
+
+  if (handler) {
+    handler(error_code);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// FunapiTlsSessionCache implementation.
+// NOTE: 재연결이나 리다이렉트 때 전체 handshake 를 다시 하지 않도록
+// 서버(host:port)마다 마지막으로 받은 TLS 세션을 프로세스 전체에서 공유한다.
+
+class FunapiTlsSessionCache {
+ public:
+  static FunapiTlsSessionCache& Get();
+
+  // key 로 저장된 세션이 있으면 ssl 이 그 세션을 재사용하도록 설정한다.
+  void Apply(const fun::string &key, SSL *ssl);
+
+  // session 의 소유권을 가져간다.
+  void Store(const fun::string &key, SSL_SESSION *session);
+  void Remove(const fun::string &key);
+  void Clear();
+
+  void OnHandshakeCompleted(SSL *ssl);
+
+  uint64_t GetResumedCount();
+  uint64_t GetFullHandshakeCount();
+
+ private:
+  std::mutex mutex_;
+  fun::unordered_map<fun::string, SSL_SESSION*> sessions_;
+
+  std::atomic<uint64_t> resumed_count_{ 0 };
+  std::atomic<uint64_t> full_handshake_count_{ 0 };
+};
+
+
+FunapiTlsSessionCache& FunapiTlsSessionCache::Get() {
+  // NOTE: 종료 시점에 OpenSSL 보다 늦게 해제되지 않도록 해제하지 않는다.
+  static FunapiTlsSessionCache* cache = new FunapiTlsSessionCache();
+  return *cache;
+}
+
+
+void FunapiTlsSessionCache::Apply(const fun::string &key, SSL *ssl) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  auto iter = sessions_.find(key);
+  if (iter != sessions_.end()) {
+    // SSL_set_session 은 세션의 참조 카운트를 올리므로 캐시의 것은 그대로 둔다.
+    SSL_set_session(ssl, iter->second);
   }
+}
 
-  socket_ = fd;
 
-  return true;
-}
+void FunapiTlsSessionCache::Store(const fun::string &key, SSL_SESSION *session) {
+  std::unique_lock<std::mutex> lock(mutex_);
 
+  auto iter = sessions_.find(key);
+  if (iter != sessions_.end()) {
+    SSL_SESSION_free(iter->second);
+    iter->second = session;
+  }
+  else {
+    sessions_[key] = session;
+  }
+}
 
-bool FunapiSocketImpl::InitNonblockingSocket(int &error_code,
-                                             fun::string &error_string)
-{
-  do {
-#ifdef FUNAPI_PLATFORM_WINDOWS
-    u_long argp = 1;
-    if (ioctlsocket(socket_, FIONBIO, &argp) == 0) {
-      return true;
-    }
-#else // FUNAPI_PLATFORM_WINDOWS
-    int flag = fcntl(socket_, F_GETFL);
-    if (flag < 0)
-      break;
 
-    if (fcntl(socket_, F_SETFL, O_NONBLOCK | flag) == 0) {
-      return true;
-    }
-#endif // FUNAPI_PLATFORM_WINDOWS
-  } while (false);
+void FunapiTlsSessionCache::Remove(const fun::string &key) {
+  std::unique_lock<std::mutex> lock(mutex_);
 
-  error_code = FunapiUtil::GetSocketErrorCode();
-  error_string = FunapiUtil::GetSocketErrorString(error_code);
-  return false;
+  auto iter = sessions_.find(key);
+  if (iter != sessions_.end()) {
+    SSL_SESSION_free(iter->second);
+    sessions_.erase(iter);
+  }
 }
 
 
-#ifdef FUNAPI_PLATFORM_WINDOWS
-void FunapiSocketImpl::SocketPoll(HANDLE handle)
-{
-  if (socket_ > 0)
-  {
-    WSANETWORKEVENTS networkEvents;
-    networkEvents.lNetworkEvents = 0;
-    if (WSAEnumNetworkEvents(socket_, handle, &networkEvents) == 0)
-    {
-      if (networkEvents.lNetworkEvents & FD_READ ||
-          networkEvents.lNetworkEvents & FD_CLOSE)
-      {
-        OnRecv();
-      }
-    }
+void FunapiTlsSessionCache::Clear() {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  for (auto &p : sessions_) {
+    SSL_SESSION_free(p.second);
   }
+  sessions_.clear();
 }
-#else // FUNAPI_PLATFORM_WINDOWS
-void FunapiSocketImpl::SocketPoll(short poll_revents)
-{
-  if (socket_ > 0)
-  {
-    if ((poll_revents & POLLIN) ||
-        (poll_revents & POLLHUP) ||
-        (poll_revents & POLLERR))
-    {
-      OnRecv();
-    }
+
+
+void FunapiTlsSessionCache::OnHandshakeCompleted(SSL *ssl) {
+  if (SSL_session_reused(ssl)) {
+    ++resumed_count_;
+  }
+  else {
+    ++full_handshake_count_;
   }
 }
-#endif // FUNAPI_PLATFORM_WINDOWS
 
 
-#ifdef FUNAPI_PLATFORM_WINDOWS
-HANDLE FunapiSocketImpl::GetEventHandle() {
-  return event_handle_;
+uint64_t FunapiTlsSessionCache::GetResumedCount() {
+  return resumed_count_.load();
+}
+
+
+uint64_t FunapiTlsSessionCache::GetFullHandshakeCount() {
+  return full_handshake_count_.load();
 }
-#endif // FUNAPI_PLATFORM_WINDOWS
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -593,6 +1514,7 @@ class FunapiTcpImpl : public FunapiSocketImpl {
   typedef FunapiTcp::RecvHandler RecvHandler;
   typedef FunapiTcp::SendHandler SendHandler;
   typedef FunapiTcp::SendCompletionHandler SendCompletionHandler;
+  typedef FunapiTcp::Frame Frame;
 
   FunapiTcpImpl();
   virtual ~FunapiTcpImpl();
@@ -623,15 +1545,29 @@ class FunapiTcpImpl : public FunapiSocketImpl {
                const ConnectCompletionHandler &connect_completion_handler);
 
   void Connect(struct addrinfo *addrinfo_res);
+  void Connect(std::shared_ptr<FunapiAddrInfo> addrinfo, const bool disable_nagle);
 
-  bool Send(const fun::vector<uint8_t> &body, const SendCompletionHandler &send_handler);
+  void SetUseKernelTLS(const bool use_kernel_tls);
 
-  bool IsReadyPoll();
+  bool Send(const fun::vector<uint8_t> &body, const SendCompletionHandler &send_handler);
+  bool Send(fun::vector<Frame> &frames, const SendCompletionHandler &send_handler);
 
  protected:
-  bool InitTcpSocketOption(bool disable_nagle,
-                           int &error_code,
-                           fun::string &error_string);
+  bool IsReadyToPoll() override;
+
+#ifndef FUNAPI_PLATFORM_WINDOWS
+  short GetPollEvents();
+#endif // FUNAPI_PLATFORM_WINDOWS
+
+  static fun::vector<struct addrinfo*> GetConnectCandidates(struct addrinfo *addrinfo_res);
+
+  // 다음 주소로 연결을 시작한다. 남은 주소도 진행 중인 연결도 없으면 실패를 알린다.
+  void StartConnectAttempt();
+  void OnConnectAttemptCompleted(std::shared_ptr<FunapiTcpConnectAttempt> attempt,
+                                 const int error_code);
+  void OnConnectTimedOut();
+  void FinishConnectAttempts();
+  static bool IsTimedOutError(const int error_code);
 
   void SocketPoll(short poll_revents);
 
@@ -643,39 +1579,95 @@ class FunapiTcpImpl : public FunapiSocketImpl {
   void OnConnectCompletion(const bool is_failed,
                            const bool is_timed_out);
 
+  // SSL 을 준비하고 handshake 를 시작한다. 이후 handshake 는 OnPoll() 에서 ContinueTLS() 로 이어 간다.
   bool ConnectTLS();
+  void ContinueTLS();
   void CleanupSSL();
 
+  // TLS 세션 캐시의 key. 같은 서버로 다시 연결하면 세션을 재사용한다.
+  fun::string GetTlsSessionKey();
+  static int OnNewTlsSession(SSL *ssl, SSL_SESSION *session);
+
   void OnSend();
   void OnRecv();
 
+  int SendFrames();
+  int SendFramesWithTLS();
+  void ConsumeFrames(size_t length);
+
+  // 커널 송신 버퍼가 가득 차면 POLLOUT(FD_WRITE) 을 기다렸다가 OnPoll() 에서 이어서 보낸다.
+  void SetWaitWritable(const bool wait_writable);
+
   enum class SocketPollState : int {
     kNone = 0,
+    kHandshake,  // TLS handshake 중. SSL_connect 가 기다리는 이벤트만 poll 한다.
     kPoll,
   };
   SocketPollState socket_poll_state_ = SocketPollState::kNone;
 
+  // 마지막 SSL_connect 가 SSL_ERROR_WANT_WRITE 로 끝났으면 true.
+  bool tls_want_write_ = false;
+
+  // 상태가 바뀌면 poller 등록도 같이 바꾼다.
+  void SetSocketPollState(const SocketPollState state);
+
   ConnectCompletionHandler completion_handler_ = nullptr;
 
   SendHandler send_handler_;
   RecvHandler recv_handler_;
   SendCompletionHandler send_completion_handler_;
 
-  fun::vector<uint8_t> body_;
-  int offset_ = 0;
+  // 한 번의 sendmsg/WSASend 에 넘기는 최대 프레임 수.
+  static const int kMaxSendFrames = 64;
+
+  // TLS 는 writev 가 없어 작은 프레임을 레코드 하나 크기까지 모아서 쓴다.
+  static const size_t kTlsRecordSize = 16 * 1024;
+
+  fun::deque<Frame> frames_;
+  size_t offset_ = 0;  // frames_.front() 에서 이미 보낸 바이트 수.
+  bool wait_writable_ = false;
+
+  // SSL_write 가 WANT_WRITE 로 끝나면 같은 내용으로 다시 써야 하므로 보낼 때까지 유지한다.
+  fun::vector<uint8_t> tls_record_;
+
   time_t connect_timeout_seconds_ = 5;
+  bool disable_nagle_ = false;
+
+  // 앞선 연결이 끝나지 않았을 때 다음 주소로 연결을 시작하기까지 기다리는 시간. (RFC 8305)
+  static const int kConnectAttemptDelayMs = 250;
+
+  // 진행 중인 연결들. 먼저 연결된 것의 descriptor 를 이 소켓이 넘겨받는다.
+  fun::vector<std::shared_ptr<FunapiTcpConnectAttempt>> connect_attempts_;
+  fun::vector<struct addrinfo*> connect_candidates_;
+  size_t next_connect_candidate_ = 0;
+  int connect_error_code_ = 0;
+  fun::string connect_error_string_;
+
+  // 연결을 시작하거나 끝낼 때마다 늘어난다. 지난 연결의 타이머를 무시하는 데 사용한다.
+  uint64_t connect_sequence_ = 0;
+
+  // 연결 시간 제한 타이머용. TLS handshake 까지 끝나서 결과를 알릴 때 늘어난다.
+  uint64_t connect_timeout_sequence_ = 0;
 
   // https://curl.haxx.se/docs/caextract.html
   // https://curl.haxx.se/ca/cacert.pem
   fun::string cert_file_path_;
   bool use_tls_ = false;
   fun::string hostname_or_ip_;
+  int port_ = 0;
+
+  // kernel_tls_send_ 가 true 이면 커널이 암호화하므로 SSL_write 대신 SendFrames() 로 보낸다.
+  bool use_kernel_tls_ = false;
+  bool kernel_tls_send_ = false;
 
   SSL_CTX *ctx_ = nullptr;
   SSL *ssl_ = nullptr;
 };
 
 
+const int FunapiTcpImpl::kConnectAttemptDelayMs;
+
+
 FunapiTcpImpl::FunapiTcpImpl() {
 }
 
@@ -703,20 +1695,30 @@ void FunapiTcpImpl::CleanupSSL() {
 
 #ifdef FUNAPI_PLATFORM_WINDOWS
 void FunapiTcpImpl::OnPoll(HANDLE handle) {
-  if (socket_poll_state_ == SocketPollState::kPoll) {
+  if (socket_poll_state_ == SocketPollState::kHandshake) {
+    // 이벤트를 초기화한 뒤 handshake 를 이어 간다.
+    WSANETWORKEVENTS networkEvents;
+    WSAEnumNetworkEvents(socket_, handle, &networkEvents);
+    ContinueTLS();
+  }
+  else if (socket_poll_state_ == SocketPollState::kPoll) {
     FunapiSocketImpl::SocketPoll(handle);
   }
 }
 #else // FUNAPI_PLATFORM_WINDOWS
 void FunapiTcpImpl::OnPoll(short poll_revents) {
-  if (socket_poll_state_ == SocketPollState::kPoll) {
+  if (socket_poll_state_ == SocketPollState::kHandshake) {
+    ContinueTLS();
+  }
+  else if (socket_poll_state_ == SocketPollState::kPoll) {
     FunapiSocketImpl::SocketPoll(poll_revents);
   }
 }
 #endif // FUNAPI_PLATFORM_WINDOWS
 
-bool FunapiTcpImpl::IsReadyPoll() {
-  if (socket_poll_state_ == SocketPollState::kPoll) {
+bool FunapiTcpImpl::IsReadyToPoll() {
+  if (socket_poll_state_ == SocketPollState::kHandshake ||
+      socket_poll_state_ == SocketPollState::kPoll) {
     return true;
   }
 
@@ -724,149 +1726,225 @@ bool FunapiTcpImpl::IsReadyPoll() {
 }
 
 
-void FunapiTcpImpl::Connect(struct addrinfo *addrinfo_res) {
-  addrinfo_res_ = addrinfo_res;
-  socket_poll_state_ = SocketPollState::kNone;
-
-  int rc = connect(socket_, addrinfo_res_->ai_addr, addrinfo_res_->ai_addrlen);
-#ifdef FUNAPI_PLATFORM_WINDOWS
-  if (rc != 0 && WSAGetLastError() != WSAEWOULDBLOCK) {
-    OnConnectCompletion(/*failed*/true, /*timeout*/true);
+void FunapiTcpImpl::SetSocketPollState(const SocketPollState state) {
+  if (socket_poll_state_ == state) {
     return;
   }
 
-#else // FUNAPI_PLATFORM_WINDOWS
-  if (rc != 0 && errno != EINPROGRESS) {
-    OnConnectCompletion(/*failed*/true, /*timeout*/false);
-    return;
+  socket_poll_state_ = state;
+  UpdatePollEvents();
+}
+
+
+#ifndef FUNAPI_PLATFORM_WINDOWS
+short FunapiTcpImpl::GetPollEvents() {
+  if (socket_poll_state_ == SocketPollState::kHandshake) {
+    return tls_want_write_ ? POLLOUT : (POLLIN | POLLPRI);
   }
-#endif // FUNAPI_PLATFORM_WINDOWS
 
-#ifdef FUNAPI_PLATFORM_WINDOWS
-  event_handle_ = WSACreateEvent();
-  if (WSAEventSelect(socket_, event_handle_,
-                     FD_READ | FD_CONNECT | FD_CLOSE) != 0)
-  {
-    int error_code = FunapiUtil::GetSocketErrorCode();
-    OnConnectCompletion(
-        /*failed*/true, /*timeout*/true,
-        error_code, FunapiUtil::GetSocketErrorString(error_code));
-    return;
+  if (wait_writable_) {
+    return POLLIN | POLLPRI | POLLOUT;
   }
 
-  DWORD ret = WSAWaitForMultipleEvents(
-      /*count*/1, &event_handle_, /*any event*/false,
-      connect_timeout_seconds_ * 1000, /*no alertable*/false);
+  return POLLIN | POLLPRI;
+}
+#endif // FUNAPI_PLATFORM_WINDOWS
 
-  if (ret == WSA_WAIT_FAILED)
-  {
-    OnConnectCompletion(/*failed*/true, /*timeout*/false);
-    return;
-  }
-  else if (ret == WSA_WAIT_TIMEOUT)
-  {
-    OnConnectCompletion(
-        /*failed*/true, /*timeout*/true, /*error code*/0,
-        "Failed to connect due to the connection timeout");
+
+void FunapiTcpImpl::SetWaitWritable(const bool wait_writable) {
+  if (wait_writable_ == wait_writable) {
     return;
   }
 
-  int error_code = 0;
-  socklen_t error_code_len = sizeof(error_code);
+  wait_writable_ = wait_writable;
 
-  int index = ret - WSA_WAIT_EVENT_0;
-  FunapiUtil::Assert(index == 0);
+  // Windows 는 WSAEWOULDBLOCK 뒤에 FD_WRITE 가 한 번 오므로 다시 등록하지 않아도 된다.
+  UpdatePollEvents();
+}
 
-  WSANETWORKEVENTS networkEvents;
-  networkEvents.lNetworkEvents = 0;
-  if (WSAEnumNetworkEvents(socket_, event_handle_, &networkEvents) == 0)
+
+void FunapiTcpImpl::Connect(struct addrinfo *addrinfo_res) {
+  SetSocketPollState(SocketPollState::kNone);
+  wait_writable_ = false;
+  CloseSocket();
+  FinishConnectAttempts();
+
+  connect_candidates_ = GetConnectCandidates(addrinfo_res);
+  next_connect_candidate_ = 0;
+  connect_error_code_ = 0;
+  connect_error_string_ = "Failed to connect to server. Please check if server";
+
+  // NOTE: 연결 시간 제한은 Poll() 의 타이머로 처리한다. TLS handshake 도 이 시간 안에 끝나야 한다.
+  std::weak_ptr<FunapiSocketImpl> weak = shared_from_this();
+  const uint64_t sequence = ++connect_timeout_sequence_;
+  AddTimer(network_thread_index_,
+           std::chrono::steady_clock::now() + std::chrono::seconds(connect_timeout_seconds_),
+           [weak, this, sequence]()
   {
-    if (!(networkEvents.lNetworkEvents & FD_CONNECT ||
-        networkEvents.lNetworkEvents & FD_READ))
-    {
-      OnConnectCompletion(
-          /*failed*/true, /*timeout*/false, /*error code*/0,
-          "Failed to connect to server. Please check if server");
+    if (auto s = weak.lock()) {
+      if (sequence == connect_timeout_sequence_) {
+        OnConnectTimedOut();
+      }
     }
-  }
+  });
 
-  if (getsockopt(socket_, SOL_SOCKET, SO_ERROR,
-                (char*)&error_code, &error_code_len) < 0) {
-    OnConnectCompletion(
-        /*failed*/true, /*timeout*/false,
-        error_code, FunapiUtil::GetSocketErrorString(error_code));
-    return;
+  StartConnectAttempt();
+}
+
+
+fun::vector<struct addrinfo*> FunapiTcpImpl::GetConnectCandidates(struct addrinfo *addrinfo_res) {
+  // NOTE: getaddrinfo 가 정렬한 순서는 유지하면서 IPv6 와 IPv4 를 번갈아 시도한다. (RFC 8305)
+  fun::deque<struct addrinfo*> preferred;
+  fun::deque<struct addrinfo*> others;
+
+  for (auto info = addrinfo_res; info; info = info->ai_next) {
+    if (info->ai_family == addrinfo_res->ai_family) {
+      preferred.push_back(info);
+    }
+    else {
+      others.push_back(info);
+    }
   }
 
-  if (error_code == 0) {
-    OnConnectCompletion(/*failed*/false, /*timeout*/false);
-    return;
+  fun::vector<struct addrinfo*> candidates;
+  candidates.reserve(preferred.size() + others.size());
+
+  while (!preferred.empty() || !others.empty()) {
+    if (!preferred.empty()) {
+      candidates.push_back(preferred.front());
+      preferred.pop_front();
+    }
+
+    if (!others.empty()) {
+      candidates.push_back(others.front());
+      others.pop_front();
+    }
   }
 
-  if (error_code == WSAETIMEDOUT) {
-    OnConnectCompletion(
-        /*failed*/true, /*timeout*/true,
-        error_code, FunapiUtil::GetSocketErrorString(error_code));
+  return candidates;
+}
+
+
+void FunapiTcpImpl::StartConnectAttempt() {
+  std::weak_ptr<FunapiSocketImpl> weak = shared_from_this();
+  const uint64_t sequence = connect_sequence_;
+
+  while (next_connect_candidate_ < connect_candidates_.size()) {
+    auto attempt = std::make_shared<FunapiTcpConnectAttempt>(
+        connect_candidates_[next_connect_candidate_++]);
+    FunapiSocketImpl::Add(attempt, network_thread_index_);
+
+    std::weak_ptr<FunapiTcpConnectAttempt> weak_attempt = attempt;
+    auto completion_handler = [weak, weak_attempt, this](const int error_code) {
+      auto s = weak.lock();
+      auto a = weak_attempt.lock();
+      if (s && a) {
+        OnConnectAttemptCompleted(a, error_code);
+      }
+    };
+
+    if (!attempt->Start(disable_nagle_, completion_handler,
+                        connect_error_code_, connect_error_string_)) {
+      continue;
+    }
+
+    connect_attempts_.push_back(attempt);
+
+    // 지연 시간이 지나도록 다른 연결이 시작되지 않았으면 다음 주소로 연결을 시작한다.
+    if (next_connect_candidate_ < connect_candidates_.size()) {
+      const size_t started = next_connect_candidate_;
+      AddTimer(network_thread_index_,
+               std::chrono::steady_clock::now() + std::chrono::milliseconds(kConnectAttemptDelayMs),
+               [weak, this, sequence, started]()
+      {
+        if (auto s = weak.lock()) {
+          if (sequence == connect_sequence_ && started == next_connect_candidate_) {
+            StartConnectAttempt();
+          }
+        }
+      });
+    }
+
     return;
   }
 
-  OnConnectCompletion(
-      /*failed*/true, /*timeout*/false,
-      error_code, FunapiUtil::GetSocketErrorString(error_code));
-#else // FUNAPI_PLATFORM_WINDOWS
-  struct pollfd pollfds[1];
-  pollfds[0].fd = socket_;
-  pollfds[0].events = POLLIN | POLLPRI | POLLOUT;
-  pollfds[0].revents = 0;
-
-  struct timeval timeout = { static_cast<long>(connect_timeout_seconds_), 0 };
-  rc = poll(pollfds, sizeof(pollfds) / sizeof(pollfds[0]), connect_timeout_seconds_ * 1000);
-  if (rc < 0) {
-    // poll failed
-    OnConnectCompletion(/*failed*/true, /*timeout*/false);
-    return;
+  if (connect_attempts_.empty()) {
+    const int error_code = connect_error_code_;
+    const fun::string error_string = connect_error_string_;
+
+    FinishConnectAttempts();
+    OnConnectCompletion(/*failed*/true, /*timeout*/IsTimedOutError(error_code),
+                        error_code, error_string);
   }
+}
 
-  if (rc == 0) {
-    // connect timed out
-    OnConnectCompletion(
-        /*failed*/true, /*timeout*/true, /*error code*/0,
-        "Failed to connect due to the connection timeout");
+
+void FunapiTcpImpl::OnConnectAttemptCompleted(std::shared_ptr<FunapiTcpConnectAttempt> attempt,
+                                              const int error_code) {
+  auto iter = std::find(connect_attempts_.begin(), connect_attempts_.end(), attempt);
+  if (iter == connect_attempts_.end()) {
     return;
   }
 
-  int error_code = 0;
-  socklen_t error_code_len = sizeof(error_code);
+  connect_attempts_.erase(iter);
 
-  short revents = pollfds[0].revents;
+  if (error_code != 0) {
+    connect_error_code_ = error_code;
+    connect_error_string_ = FunapiUtil::GetSocketErrorString(error_code);
 
-  if (!(revents & POLLIN) && !(revents & POLLOUT)) {
-    OnConnectCompletion(
-        /*failed*/true, /*timeout*/false, /*error code*/0,
-        "Failed to connect to server. Please check if server");
+    // 실패하면 지연 시간을 기다리지 않고 바로 다음 주소를 시도한다.
+    StartConnectAttempt();
     return;
   }
 
-  if (getsockopt(socket_, SOL_SOCKET, SO_ERROR,
-                 &error_code, &error_code_len) < 0) {
-    OnConnectCompletion(/*failed*/true, /*timeout*/false,
-                        error_code, strerror(error_code));
-    return;
-  }
+  addrinfo_res_ = attempt->GetAddrInfo();
+#ifdef FUNAPI_PLATFORM_WINDOWS
+  event_handle_ = attempt->ReleaseEventHandle();
+#endif // FUNAPI_PLATFORM_WINDOWS
+  int fd = attempt->Release();
 
-  if (error_code == 0) {
-    OnConnectCompletion(/*failed*/false, /*timeout*/false);
-    return;
+  FinishConnectAttempts();
+  SetSocket(fd);
+
+  // log
+  {
+    fun::string hostname = FunapiSocketImpl::GetStringFromAddrInfo(addrinfo_res_);
+    DebugUtils::Log("Address Info: %s -> %s", hostname_or_ip_.c_str(), hostname.c_str());
   }
+  // //
 
-  if (error_code == ETIMEDOUT) {
-    OnConnectCompletion(/*failed*/true, /*timeout*/true,
-                        error_code, strerror(error_code));
+  if (use_tls_) {
+    ConnectTLS();
     return;
   }
 
-  OnConnectCompletion(/*failed*/true, /*timeout*/false,
-                      error_code, strerror(error_code));
+  OnConnectCompletion(/*failed*/false, /*timeout*/false, 0, "");
+}
+
+
+void FunapiTcpImpl::OnConnectTimedOut() {
+  FinishConnectAttempts();
+
+  OnConnectCompletion(
+      /*failed*/true, /*timeout*/true, /*error code*/0,
+      "Failed to connect due to the connection timeout");
+}
+
+
+void FunapiTcpImpl::FinishConnectAttempts() {
+  ++connect_sequence_;
+
+  connect_attempts_.clear();
+  connect_candidates_.clear();
+  next_connect_candidate_ = 0;
+}
+
+
+bool FunapiTcpImpl::IsTimedOutError(const int error_code) {
+#ifdef FUNAPI_PLATFORM_WINDOWS
+  return error_code == WSAETIMEDOUT;
+#else // FUNAPI_PLATFORM_WINDOWS
+  return error_code == ETIMEDOUT;
 #endif // FUNAPI_PLATFORM_WINDOWS
 }
 
@@ -916,65 +1994,38 @@ void FunapiTcpImpl::Connect(const char* hostname_or_ip,
   use_tls_ = use_tls;
   cert_file_path_ = cert_file_path;
   hostname_or_ip_ = hostname_or_ip;
+  port_ = port;
 
   send_handler_ = send_handler;
   recv_handler_ = recv_handler;
   connect_timeout_seconds_ = connect_timeout_seconds;
 
-  int error_code = 0;
-  fun::string error_string;
-
-  if (!InitAddrInfo(SOCK_STREAM, hostname_or_ip_.c_str(), port, error_code, error_string)) {
-    OnConnectCompletion(true, false, error_code, error_string);
-    return;
-  }
-
-  addrinfo_res_ = addrinfo_;
-
-  if (!InitSocket(addrinfo_res_, error_code, error_string)) {
-    OnConnectCompletion(true, false, error_code, error_string);
-    return;
-  }
-
-  if (!InitNonblockingSocket(error_code, error_string)) {
-    OnConnectCompletion(true, false, error_code, error_string);
-    return;
-  }
-
-  if (!InitTcpSocketOption(disable_nagle, error_code, error_string)) {
-    OnConnectCompletion(true, false, error_code, error_string);
-    return;
-  }
-
-  // log
+  // NOTE: 주소 조회는 _resolver 스레드에서 하고 이어지는 처리는 이 소켓의 네트워크 스레드에서 한다.
+  std::weak_ptr<FunapiSocketImpl> weak = shared_from_this();
+  FunapiResolver::Resolve(hostname_or_ip_, port, SOCK_STREAM, network_thread_index_,
+                          [weak, this, disable_nagle](const bool is_failed,
+                                                      const int error_code,
+                                                      const fun::string &error_string,
+                                                      std::shared_ptr<FunapiAddrInfo> addrinfo)
   {
-    fun::string hostname = FunapiSocketImpl::GetStringFromAddrInfo(addrinfo_res_);
-    DebugUtils::Log("Address Info: %s -> %s", hostname_or_ip, hostname.c_str());
-  }
-  // //
+    if (auto s = weak.lock()) {
+      if (is_failed) {
+        OnConnectCompletion(true, false, error_code, error_string);
+        return;
+      }
 
-  Connect(addrinfo_res_);
+      Connect(addrinfo, disable_nagle);
+    }
+  });
 }
 
 
-bool FunapiTcpImpl::InitTcpSocketOption(bool disable_nagle, int &error_code, fun::string &error_string) {
-  // Disable nagle
-  if (disable_nagle) {
-    int nagle_flag = 1;
-    int result = setsockopt(socket_,
-                            IPPROTO_TCP,
-                            TCP_NODELAY,
-                            reinterpret_cast<char*>(&nagle_flag),
-                            sizeof(int));
-    if (result < 0) {
-      // Error - TCP_NODELAY
-      error_code = FunapiUtil::GetSocketErrorCode();
-      error_string = FunapiUtil::GetSocketErrorString(error_code);
-      return false;
-    }
-  }
+void FunapiTcpImpl::Connect(std::shared_ptr<FunapiAddrInfo> addrinfo,
+                            const bool disable_nagle) {
+  SetAddrInfo(addrinfo);
+  disable_nagle_ = disable_nagle;
 
-  return true;
+  Connect(addrinfo_res_);
 }
 
 
@@ -1009,6 +2060,16 @@ bool FunapiTcpImpl::ConnectTLS() {
     return false;
   }
 
+  // 서버가 보내준 세션은 OnNewTlsSession() 에서 캐시에 넣는다.
+  SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(ctx_, &FunapiTcpImpl::OnNewTlsSession);
+
+#if FUNAPI_USE_KTLS
+  if (use_kernel_tls_) {
+    SSL_CTX_set_options(ctx_, SSL_OP_ENABLE_KTLS);
+  }
+#endif // FUNAPI_USE_KTLS
+
 #if FUNAPI_TLS_VERIFY_SERVER_CERTIFICATE
   if (cert_file_path_.empty())
   {
@@ -1050,6 +2111,9 @@ bool FunapiTcpImpl::ConnectTLS() {
     return false;
   }
 
+  SSL_set_app_data(ssl_, this);
+  FunapiTlsSessionCache::Get().Apply(GetTlsSessionKey(), ssl_);
+
 #if FUNAPI_TLS_VERIFY_SERVER_CERTIFICATE
   auto param = SSL_get0_param(ssl_);
   X509_VERIFY_PARAM_set_hostflags(param, X509_CHECK_FLAG_NO_PARTIAL_WILDCARDS);
@@ -1059,28 +2123,88 @@ bool FunapiTcpImpl::ConnectTLS() {
     on_ssl_error_completion();
     return false;
   }
-#endif // FUNAPI_TLS_VERIFY_SERVER_CERTIFICATE
+#endif // FUNAPI_TLS_VERIFY_SERVER_CERTIFICATE
+
+  tls_want_write_ = false;
+  SetSocketPollState(SocketPollState::kHandshake);
+  ContinueTLS();
+
+  return true;
+}
+
+
+void FunapiTcpImpl::ContinueTLS() {
+  int ret = SSL_connect(ssl_);
+  if (ret != 1) {
+    int n = SSL_get_error(ssl_, ret);
+
+    // 소켓이 준비될 때까지 기다렸다가 OnPoll() 에서 다시 호출된다.
+    if (n == SSL_ERROR_WANT_READ || n == SSL_ERROR_WANT_WRITE) {
+      const bool want_write = (n == SSL_ERROR_WANT_WRITE);
+      if (tls_want_write_ != want_write) {
+        tls_want_write_ = want_write;
+        UpdatePollEvents();
+      }
+      return;
+    }
+
+    // 재사용하려던 세션 때문에 실패했을 수 있으므로 다음에는 전체 handshake 를 한다.
+    FunapiTlsSessionCache::Get().Remove(GetTlsSessionKey());
+
+    SSL_load_error_strings();
+
+    unsigned long error_code = ERR_get_error();
+    char error_buffer[1024];
+    ERR_error_string(error_code, (char *)error_buffer);
+
+    OnConnectCompletion(true, false, static_cast<int>(error_code), error_buffer);
+    return;
+  }
 
-  while (true)
-  {
-    ret = SSL_connect(ssl_);
-    if (ret != 1) {
-      int n = SSL_get_error(ssl_, ret);
+  FunapiTlsSessionCache::Get().OnHandshakeCompleted(ssl_);
 
-      if (n == SSL_ERROR_WANT_READ || n == SSL_ERROR_WANT_READ) {
-        continue;
-      }
-      else {
-        on_ssl_error_completion();
-        return false;
-      }
-    }
-    else {
-      break;
-    }
+  kernel_tls_send_ = false;
+  if (use_kernel_tls_) {
+#if FUNAPI_USE_KTLS
+    // 수신은 kTLS 여부와 상관없이 SSL_read 를 사용한다. 세션 티켓 같은 제어 레코드를 OpenSSL 이 처리해야 한다.
+    kernel_tls_send_ = (BIO_get_ktls_send(SSL_get_wbio(ssl_)) != 0);
+    const bool kernel_tls_recv = (BIO_get_ktls_recv(SSL_get_rbio(ssl_)) != 0);
+    DebugUtils::Log("Kernel TLS: send=%s recv=%s cipher=%s",
+                    kernel_tls_send_ ? "on" : "off",
+                    kernel_tls_recv ? "on" : "off",
+                    SSL_get_cipher_name(ssl_));
+#else // FUNAPI_USE_KTLS
+    DebugUtils::Log("Kernel TLS is not supported on this platform.");
+#endif // FUNAPI_USE_KTLS
   }
 
-  return true;
+  OnConnectCompletion(false, false, 0, "");
+}
+
+
+void FunapiTcpImpl::SetUseKernelTLS(const bool use_kernel_tls) {
+  use_kernel_tls_ = use_kernel_tls;
+}
+
+
+fun::string FunapiTcpImpl::GetTlsSessionKey() {
+  fun::stringstream ss;
+  ss << hostname_or_ip_ << ":" << port_;
+  return ss.str();
+}
+
+
+int FunapiTcpImpl::OnNewTlsSession(SSL *ssl, SSL_SESSION *session) {
+  // NOTE: TLS 1.3 은 handshake 이후 SSL_read 중에 세션 티켓을 받으므로 그때도 호출된다.
+  auto impl = static_cast<FunapiTcpImpl*>(SSL_get_app_data(ssl));
+  if (!impl) {
+    return 0;
+  }
+
+  FunapiTlsSessionCache::Get().Store(impl->GetTlsSessionKey(), session);
+
+  // 1 을 반환하면 session 의 소유권이 캐시로 넘어간다.
+  return 1;
 }
 
 
@@ -1097,18 +2221,15 @@ void FunapiTcpImpl::OnConnectCompletion(const bool is_failed,
                                         const bool is_timed_out,
                                         const int error_code,
                                         const fun::string &error_string) {
-  if (false == is_failed && use_tls_) {
-    if (false == ConnectTLS()) {
-      return;
-    }
-  }
+  // 연결 시간 제한 타이머를 끈다.
+  ++connect_timeout_sequence_;
 
   if (completion_handler_) {
     if (!is_failed) {
-      socket_poll_state_ = SocketPollState::kPoll;
+      SetSocketPollState(SocketPollState::kPoll);
     }
     else {
-      socket_poll_state_ = SocketPollState::kNone;
+      SetSocketPollState(SocketPollState::kNone);
     }
 
     auto addrinfo = FunapiAddrInfo::Create();
@@ -1120,33 +2241,35 @@ void FunapiTcpImpl::OnConnectCompletion(const bool is_failed,
 
 
 void FunapiTcpImpl::OnSend() {
-  if (body_.empty() && offset_ == 0) {
+  // 연결이나 handshake 가 끝나기 전에는 보낼 수 없다. 끝나면 보낼 메시지를 다시 요청한다.
+  if (socket_poll_state_ != SocketPollState::kPoll) {
+    return;
+  }
+
+  if (frames_.empty()) {
     send_handler_();
   }
 
-  if (!body_.empty()) {
+  if (!frames_.empty()) {
     int nSent = 0;
 
-    if (use_tls_) {
-      nSent = static_cast<int>(SSL_write(ssl_,
-        reinterpret_cast<char*>(body_.data()) + offset_,
-        static_cast<int>(body_.size() - offset_)));
+    if (use_tls_ && !kernel_tls_send_) {
+      nSent = SendFramesWithTLS();
     }
     else {
-      nSent = static_cast<int>(send(socket_,
-        reinterpret_cast<char*>(body_.data()) + offset_,
-        body_.size() - offset_,
-        0));
+      nSent = SendFrames();
     }
 
     if (nSent < 0) {
       int error_code = FunapiUtil::GetSocketErrorCode();
 #ifdef FUNAPI_PLATFORM_WINDOWS
       if (error_code == WSAEWOULDBLOCK) {
+        SetWaitWritable(true);
         return;
       }
 #else // FUNAPI_PLATFORM_WINDOWS
       if (error_code == EWOULDBLOCK) {
+        SetWaitWritable(true);
         return;
       }
 #endif // FUNAPI_PLATFORM_WINDOWS
@@ -1156,19 +2279,105 @@ void FunapiTcpImpl::OnSend() {
       return;
     }
 
-    offset_ += nSent;
-    if (offset_ == body_.size()) {
-      offset_ = 0;
-      body_.resize(0);
-
+    ConsumeFrames(nSent);
+    if (frames_.empty()) {
+      SetWaitWritable(false);
       send_completion_handler_(false, 0, "", nSent);
     }
+    else {
+      // 다 보내지 못한 프레임은 소켓이 쓰기 가능해지면 OnPoll() 에서 이어서 보낸다.
+      SetWaitWritable(true);
+    }
+  }
+}
+
+
+int FunapiTcpImpl::SendFrames() {
+  const size_t count = std::min(frames_.size(), static_cast<size_t>(kMaxSendFrames));
+
+#ifdef FUNAPI_PLATFORM_WINDOWS
+  WSABUF buffers[kMaxSendFrames];
+  for (size_t i = 0; i < count; ++i) {
+    const size_t skip = (i == 0) ? offset_ : 0;
+    buffers[i].buf = reinterpret_cast<CHAR*>(const_cast<uint8_t*>(frames_[i].data.get())) + skip;
+    buffers[i].len = static_cast<ULONG>(frames_[i].size - skip);
+  }
+
+  DWORD nSent = 0;
+  if (WSASend(socket_, buffers, static_cast<DWORD>(count), &nSent, 0, NULL, NULL) == SOCKET_ERROR) {
+    return -1;
+  }
+
+  return static_cast<int>(nSent);
+#else // FUNAPI_PLATFORM_WINDOWS
+  struct iovec buffers[kMaxSendFrames];
+  for (size_t i = 0; i < count; ++i) {
+    const size_t skip = (i == 0) ? offset_ : 0;
+    buffers[i].iov_base = const_cast<uint8_t*>(frames_[i].data.get()) + skip;
+    buffers[i].iov_len = frames_[i].size - skip;
+  }
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = buffers;
+  msg.msg_iovlen = count;
+
+  return static_cast<int>(sendmsg(socket_, &msg, 0));
+#endif // FUNAPI_PLATFORM_WINDOWS
+}
+
+
+int FunapiTcpImpl::SendFramesWithTLS() {
+  if (tls_record_.empty()) {
+    const Frame &front = frames_.front();
+    if (front.size - offset_ >= kTlsRecordSize) {
+      // 충분히 큰 프레임은 모으지 않고 바로 쓴다.
+      // 다시 쓰게 되더라도 frames_ 가 그대로이므로 같은 내용으로 호출된다.
+      return static_cast<int>(SSL_write(ssl_,
+        front.data.get() + offset_,
+        static_cast<int>(front.size - offset_)));
+    }
+
+    size_t skip = offset_;
+    for (auto &frame : frames_) {
+      if (tls_record_.size() >= kTlsRecordSize) {
+        break;
+      }
+
+      tls_record_.insert(tls_record_.end(), frame.data.get() + skip, frame.data.get() + frame.size);
+      skip = 0;
+    }
+  }
+
+  int nSent = static_cast<int>(SSL_write(ssl_,
+    tls_record_.data(),
+    static_cast<int>(tls_record_.size())));
+
+  if (nSent > 0) {
+    tls_record_.resize(0);
+  }
+
+  return nSent;
+}
+
+
+void FunapiTcpImpl::ConsumeFrames(size_t length) {
+  while (length > 0 && !frames_.empty()) {
+    const size_t remain = frames_.front().size - offset_;
+    if (length < remain) {
+      offset_ += length;
+      return;
+    }
+
+    length -= remain;
+    offset_ = 0;
+    frames_.pop_front();
   }
 }
 
 
 void FunapiTcpImpl::OnRecv() {
-  fun::vector<uint8_t> buffer(kBufferSize);
+  fun::vector<uint8_t> &buffer = GetRecvBuffer();
 
   int nRead = 0;
 
@@ -1207,16 +2416,29 @@ void FunapiTcpImpl::OnRecv() {
 
 
 bool FunapiTcpImpl::Send(const fun::vector<uint8_t> &body, const SendCompletionHandler &send_completion_handler) {
-  send_completion_handler_ = send_completion_handler;
+  if (body.empty()) {
+    send_completion_handler_ = send_completion_handler;
+    return true;
+  }
+
+  auto buffer = std::make_shared<fun::vector<uint8_t>>(body);
+
+  fun::vector<Frame> frames;
+  frames.push_back(Frame{ std::shared_ptr<const uint8_t>(buffer, buffer->data()), buffer->size() });
+
+  return Send(frames, send_completion_handler);
+}
+
 
-  body_.insert(body_.end(), body.cbegin(), body.cend());
+bool FunapiTcpImpl::Send(fun::vector<Frame> &frames, const SendCompletionHandler &send_completion_handler) {
+  send_completion_handler_ = send_completion_handler;
 
-//  // log
-//  {
-//    fun::string temp_string(body.cbegin(), body.cend());
-//    printf("\"%s\"\n", temp_string.c_str());
-//  }
-//  //
+  for (auto &frame : frames) {
+    if (frame.size > 0) {
+      frames_.push_back(std::move(frame));
+    }
+  }
+  frames.clear();
 
   return true;
 }
@@ -1231,6 +2453,7 @@ class FunapiUdpImpl : public FunapiSocketImpl {
   typedef FunapiUdp::RecvHandler RecvHandler;
   typedef FunapiUdp::SendHandler SendHandler;
   typedef FunapiUdp::SendCompletionHandler SendCompletionHandler;
+  typedef FunapiUdp::Frame Frame;
 
   FunapiUdpImpl() = delete;
   FunapiUdpImpl(const char* hostname_or_ip,
@@ -1239,20 +2462,48 @@ class FunapiUdpImpl : public FunapiSocketImpl {
                 const SendHandler &send_handler,
                 const RecvHandler &recv_handler);
   virtual ~FunapiUdpImpl();
+
+  // Add() 된 다음에 호출한다. 주소를 조회한 뒤 소켓을 만들고 InitHandler 를 호출한다.
+  void Init();
+
 #ifdef FUNAPI_PLATFORM_WINDOWS
   void OnPoll(HANDLE handle);
 #else // FUNAPI_PLATFORM_WINDOWS
   void OnPoll(short poll_revents);
 #endif //FUNAPI_PLATFORM_WINDOWS
-  bool Send(const fun::vector<uint8_t> &body, const SendCompletionHandler &send_handler);
+  bool Send(const uint8_t *data, const size_t size, const SendCompletionHandler &send_handler);
+  bool Send(fun::vector<Frame> &frames, const SendCompletionHandler &send_handler);
 
  private:
+  void Init(std::shared_ptr<FunapiAddrInfo> addrinfo);
   void Finalize();
   void OnSend();
   void OnRecv();
 
+  // 송신 버퍼가 가득 차서 보내지 못했으면 쓰기 가능해질 때 OnSend() 가 다시 불리도록 한다.
+  void SetWaitWritable(const bool wait_writable);
+#ifndef FUNAPI_PLATFORM_WINDOWS
+  short GetPollEvents();
+#endif // FUNAPI_PLATFORM_WINDOWS
+
+#if FUNAPI_HAVE_MMSG
+  // 한 번의 recvmmsg/sendmmsg 로 처리하는 최대 데이터그램 수.
+  static const int kMaxRecvPackets = 8;
+  static const int kMaxSendPackets = 64;
+
+  static fun::vector<fun::vector<uint8_t>>& GetRecvPackets();
+#endif // FUNAPI_HAVE_MMSG
+
+  fun::string hostname_or_ip_;
+  int port_ = 0;
+  struct addrinfo peer_addrinfo_;
+  struct sockaddr_storage peer_addr_;
+
+  InitHandler init_handler_;
   SendHandler send_handler_;
   RecvHandler recv_handler_;
+
+  bool wait_writable_ = false;
 };
 
 
@@ -1261,22 +2512,54 @@ FunapiUdpImpl::FunapiUdpImpl(const char* hostname_or_ip,
                              const InitHandler &init_handler,
                              const SendHandler &send_handler,
                              const RecvHandler &recv_handler)
-: send_handler_(send_handler), recv_handler_(recv_handler) {
+: hostname_or_ip_(hostname_or_ip), port_(port), init_handler_(init_handler),
+  send_handler_(send_handler), recv_handler_(recv_handler) {
+}
+
+
+void FunapiUdpImpl::Init() {
+  std::weak_ptr<FunapiSocketImpl> weak = shared_from_this();
+  FunapiResolver::Resolve(hostname_or_ip_, port_, SOCK_DGRAM, network_thread_index_,
+                          [weak, this](const bool is_failed,
+                                       const int error_code,
+                                       const fun::string &error_string,
+                                       std::shared_ptr<FunapiAddrInfo> addrinfo)
+  {
+    if (auto s = weak.lock()) {
+      if (is_failed) {
+        init_handler_(true, error_code, error_string);
+        return;
+      }
+
+      Init(addrinfo);
+    }
+  });
+}
+
+
+void FunapiUdpImpl::Init(std::shared_ptr<FunapiAddrInfo> addrinfo) {
+  const InitHandler &init_handler = init_handler_;
   int error_code = 0;
   fun::string error_string;
 
-  if (!InitAddrInfo(SOCK_DGRAM, hostname_or_ip, port, error_code, error_string)) {
-    init_handler(true, error_code, error_string);
-    return;
-  }
-
-  addrinfo_res_ = addrinfo_;
+  SetAddrInfo(addrinfo);
 
   if (!InitSocket(addrinfo_res_, error_code, error_string)) {
     init_handler(true, error_code, error_string);
     return;
   }
 
+  // NOTE: recvfrom 이 보낸 쪽 주소를 addrinfo_res_ 에 쓰므로
+  // 여러 소켓이 공유하는 조회 결과 대신 복사본을 사용한다.
+  memset(&peer_addr_, 0, sizeof(peer_addr_));
+  memcpy(&peer_addr_, addrinfo_res_->ai_addr,
+         std::min(static_cast<size_t>(addrinfo_res_->ai_addrlen), sizeof(peer_addr_)));
+  peer_addrinfo_ = *addrinfo_res_;
+  peer_addrinfo_.ai_addr = reinterpret_cast<struct sockaddr*>(&peer_addr_);
+  peer_addrinfo_.ai_canonname = nullptr;
+  peer_addrinfo_.ai_next = nullptr;
+  addrinfo_res_ = &peer_addrinfo_;
+
   if (!InitNonblockingSocket(error_code, error_string)) {
     init_handler(true, error_code, error_string);
     return;
@@ -1284,7 +2567,7 @@ FunapiUdpImpl::FunapiUdpImpl(const char* hostname_or_ip,
 
 #ifdef FUNAPI_PLATFORM_WINDOWS
   event_handle_ = WSACreateEvent();
-  if (WSAEventSelect(socket_, event_handle_, FD_READ) != 0)
+  if (WSAEventSelect(socket_, event_handle_, FD_READ | FD_WRITE) != 0)
   {
     int error_code = FunapiUtil::GetSocketErrorCode();
     init_handler(true, error_code, FunapiUtil::GetSocketErrorString(error_code));
@@ -1316,8 +2599,109 @@ void FunapiUdpImpl::OnSend() {
 }
 
 
+void FunapiUdpImpl::SetWaitWritable(const bool wait_writable) {
+  if (wait_writable_ == wait_writable) {
+    return;
+  }
+
+  wait_writable_ = wait_writable;
+  UpdatePollEvents();
+}
+
+
+#ifndef FUNAPI_PLATFORM_WINDOWS
+short FunapiUdpImpl::GetPollEvents() {
+  if (wait_writable_) {
+    return POLLIN | POLLPRI | POLLOUT;
+  }
+
+  return POLLIN | POLLPRI;
+}
+#endif // FUNAPI_PLATFORM_WINDOWS
+
+
+#if FUNAPI_HAVE_MMSG
+fun::vector<fun::vector<uint8_t>>& FunapiUdpImpl::GetRecvPackets() {
+  static thread_local fun::vector<fun::vector<uint8_t>> packets;
+
+  if (packets.size() != static_cast<size_t>(kMaxRecvPackets)) {
+    packets.resize(kMaxRecvPackets);
+  }
+
+  // 이전 호출에서 받은 길이로 줄여 두었으므로 다시 늘린다. 용량은 그대로이다.
+  for (auto &packet : packets) {
+    if (packet.capacity() < static_cast<size_t>(kBufferSize)) {
+      ++recv_buffer_allocation_count;
+    }
+
+    if (packet.size() != static_cast<size_t>(kBufferSize)) {
+      packet.resize(kBufferSize);
+    }
+  }
+
+  return packets;
+}
+
+
+void FunapiUdpImpl::OnRecv() {
+  fun::vector<fun::vector<uint8_t>> &packets = GetRecvPackets();
+
+  struct mmsghdr msgs[kMaxRecvPackets];
+  struct iovec buffers[kMaxRecvPackets];
+  memset(msgs, 0, sizeof(msgs));
+
+  for (int i = 0; i < kMaxRecvPackets; ++i) {
+    buffers[i].iov_base = packets[i].data();
+    buffers[i].iov_len = packets[i].size();
+
+    // recvfrom 과 같이 보낸 쪽 주소를 addrinfo_res_ 에 받는다.
+    msgs[i].msg_hdr.msg_name = addrinfo_res_->ai_addr;
+    msgs[i].msg_hdr.msg_namelen = addrinfo_res_->ai_addrlen;
+    msgs[i].msg_hdr.msg_iov = &buffers[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  int nPackets = recvmmsg(socket_, msgs, kMaxRecvPackets, 0, nullptr);
+
+  if (nPackets < 0) {
+    int error_code = FunapiUtil::GetSocketErrorCode();
+    if (error_code == EWOULDBLOCK || error_code == EAGAIN) {
+      // 받을 데이터그램이 없다. 다음 Poll() 에서 다시 받는다.
+      return;
+    }
+
+    fun::string error_string = FunapiUtil::GetSocketErrorString(error_code);
+    recv_handler_(true, error_code, error_string, nPackets, packets[0]);
+    CloseSocket();
+    return;
+  }
+
+  if (nPackets > 0) {
+    addrinfo_res_->ai_addrlen = msgs[nPackets - 1].msg_hdr.msg_namelen;
+  }
+
+  for (int i = 0; i < nPackets; ++i) {
+    const int nRead = static_cast<int>(msgs[i].msg_len);
+    fun::vector<uint8_t> &receiving_vector = packets[i];
+
+    if (nRead == 0) {
+      recv_handler_(true, 0, "Peer closed the TCP transport", nRead, receiving_vector);
+      CloseSocket();
+      return;
+    }
+
+    receiving_vector.resize(nRead);
+    recv_handler_(false, 0, "", nRead, receiving_vector);
+
+    // recv_handler_ 에서 소켓이 닫혔을 수 있다.
+    if (socket_ < 0) {
+      return;
+    }
+  }
+}
+#else // FUNAPI_HAVE_MMSG
 void FunapiUdpImpl::OnRecv() {
-  fun::vector<uint8_t> receiving_vector(kBufferSize);
+  fun::vector<uint8_t> &receiving_vector = GetRecvBuffer();
 
 #ifdef FUNAPI_PLATFORM_WINDOWS
   int nRead = static_cast<int>(recvfrom(socket_,
@@ -1339,40 +2723,166 @@ void FunapiUdpImpl::OnRecv() {
 
   if (nRead < 0) {
     int error_code = FunapiUtil::GetSocketErrorCode();
+#ifdef FUNAPI_PLATFORM_WINDOWS
+    if (error_code == WSAEWOULDBLOCK) {
+      return;
+    }
+#else // FUNAPI_PLATFORM_WINDOWS
+    if (error_code == EWOULDBLOCK || error_code == EAGAIN) {
+      return;
+    }
+#endif // FUNAPI_PLATFORM_WINDOWS
     fun::string error_string = FunapiUtil::GetSocketErrorString(error_code);
     recv_handler_(true, error_code, error_string, nRead, receiving_vector);
     CloseSocket();
     return;
   }
 
+  // 재사용하는 버퍼이므로 이전 데이터그램의 내용이 디코딩되지 않도록 받은 길이로 줄인다.
+  receiving_vector.resize(nRead);
+
   recv_handler_(false, 0, "", nRead, receiving_vector);
 }
+#endif // FUNAPI_HAVE_MMSG
 
 
-bool FunapiUdpImpl::Send(const fun::vector<uint8_t> &body, const SendCompletionHandler &send_completion_handler) {
-  uint8_t *buf = const_cast<uint8_t*>(body.data());
+bool FunapiUdpImpl::Send(const uint8_t *data, const size_t size, const SendCompletionHandler &send_completion_handler) {
+  uint8_t *buf = const_cast<uint8_t*>(data);
 
-  int nSent = static_cast<int>(sendto(socket_, reinterpret_cast<char*>(buf), body.size(), 0, addrinfo_res_->ai_addr, addrinfo_res_->ai_addrlen));
+  int nSent = static_cast<int>(sendto(socket_, reinterpret_cast<char*>(buf), size, 0, addrinfo_res_->ai_addr, addrinfo_res_->ai_addrlen));
 
   if (nSent < 0) {
     int error_code = FunapiUtil::GetSocketErrorCode();
+#ifdef FUNAPI_PLATFORM_WINDOWS
+    if (error_code == WSAEWOULDBLOCK) {
+      SetWaitWritable(true);
+      return false;
+    }
+#else // FUNAPI_PLATFORM_WINDOWS
+    if (error_code == EWOULDBLOCK || error_code == EAGAIN) {
+      SetWaitWritable(true);
+      return false;
+    }
+#endif // FUNAPI_PLATFORM_WINDOWS
     fun::string error_string = FunapiUtil::GetSocketErrorString(error_code);
     send_completion_handler(true, error_code, error_string, nSent);
     CloseSocket();
+    return false;
   }
-  else {
-    send_completion_handler(false, 0, "", nSent);
-  }
+
+  send_completion_handler(false, 0, "", nSent);
 
   return true;
 }
 
 
+bool FunapiUdpImpl::Send(fun::vector<Frame> &frames, const SendCompletionHandler &send_completion_handler) {
+#if FUNAPI_HAVE_MMSG
+  size_t index = 0;
+
+  while (index < frames.size()) {
+    const size_t count = std::min(frames.size() - index, static_cast<size_t>(kMaxSendPackets));
+
+    struct mmsghdr msgs[kMaxSendPackets];
+    struct iovec buffers[kMaxSendPackets];
+    memset(msgs, 0, sizeof(msgs));
+
+    for (size_t i = 0; i < count; ++i) {
+      const Frame &frame = frames[index + i];
+      buffers[i].iov_base = const_cast<uint8_t*>(frame.data.get());
+      buffers[i].iov_len = frame.size;
+
+      msgs[i].msg_hdr.msg_name = addrinfo_res_->ai_addr;
+      msgs[i].msg_hdr.msg_namelen = addrinfo_res_->ai_addrlen;
+      msgs[i].msg_hdr.msg_iov = &buffers[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int nPackets = sendmmsg(socket_, msgs, static_cast<unsigned int>(count), 0);
+
+    if (nPackets <= 0) {
+      int error_code = FunapiUtil::GetSocketErrorCode();
+      if (nPackets == 0 || error_code == EWOULDBLOCK || error_code == EAGAIN) {
+        SetWaitWritable(true);
+        break;
+      }
+
+      fun::string error_string = FunapiUtil::GetSocketErrorString(error_code);
+      send_completion_handler(true, error_code, error_string, -1);
+      CloseSocket();
+      break;
+    }
+
+    // 일부만 보낸 경우 나머지는 다음 sendmmsg 에서 보낸다.
+    index += nPackets;
+
+    for (int i = 0; i < nPackets; ++i) {
+      send_completion_handler(false, 0, "", static_cast<int>(msgs[i].msg_len));
+    }
+
+    if (socket_ < 0) {
+      break;
+    }
+  }
+#else // FUNAPI_HAVE_MMSG
+  size_t index = 0;
+
+  while (index < frames.size()) {
+    const Frame &frame = frames[index];
+    if (!Send(frame.data.get(), frame.size, send_completion_handler)) {
+      break;
+    }
+
+    ++index;
+
+    if (socket_ < 0) {
+      break;
+    }
+  }
+#endif // FUNAPI_HAVE_MMSG
+
+  if (index == frames.size()) {
+    SetWaitWritable(false);
+  }
+
+  frames.erase(frames.begin(), frames.begin() + index);
+
+  return frames.empty();
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // FunapiSocket implementation.
 
-bool FunapiSocket::Poll() {
-  return FunapiSocketImpl::Poll();
+bool FunapiSocket::Poll(const int network_thread_index) {
+  return FunapiSocketImpl::Poll(network_thread_index);
+}
+
+
+void FunapiSocket::AddTimer(const int network_thread_index,
+                            const std::chrono::steady_clock::time_point &expired_time,
+                            const TimerHandler &handler) {
+  FunapiSocketImpl::AddTimer(network_thread_index, expired_time, handler);
+}
+
+
+uint64_t FunapiSocket::GetRecvBufferAllocationCount() {
+  return FunapiSocketImpl::GetRecvBufferAllocationCount();
+}
+
+
+uint64_t FunapiSocket::GetTlsSessionResumedCount() {
+  return FunapiTlsSessionCache::Get().GetResumedCount();
+}
+
+
+uint64_t FunapiSocket::GetTlsFullHandshakeCount() {
+  return FunapiTlsSessionCache::Get().GetFullHandshakeCount();
+}
+
+
+void FunapiSocket::ClearTlsSessionCache() {
+  FunapiTlsSessionCache::Get().Clear();
 }
 
 
@@ -1394,6 +2904,13 @@ std::shared_ptr<FunapiAddrInfo> FunapiAddrInfo::Create() {
 }
 
 
+std::shared_ptr<FunapiAddrInfo> FunapiAddrInfo::Create(struct addrinfo *addrinfo_res) {
+  auto addrinfo = std::make_shared<FunapiAddrInfo>();
+  addrinfo->impl_->SetAddrInfo(addrinfo_res, true);
+  return addrinfo;
+}
+
+
 fun::string FunapiAddrInfo::GetString() {
   return impl_->GetString();
 }
@@ -1475,6 +2992,21 @@ bool FunapiTcp::Send(const fun::vector<uint8_t> &body, const SendCompletionHandl
 }
 
 
+bool FunapiTcp::Send(fun::vector<Frame> &frames, const SendCompletionHandler &send_handler) {
+  return impl_->Send(frames, send_handler);
+}
+
+
+void FunapiTcp::RequestSend() {
+  impl_->RequestSend();
+}
+
+
+void FunapiTcp::SetUseKernelTLS(const bool use_kernel_tls) {
+  impl_->SetUseKernelTLS(use_kernel_tls);
+}
+
+
 int FunapiTcp::GetSocket() {
   return impl_->GetSocket();
 }
@@ -1504,6 +3036,7 @@ FunapiUdp::FunapiUdp(const char* hostname_or_ip,
                                         send_handler,
                                         recv_handler)) {
   FunapiSocketImpl::Add(impl_);
+  impl_->Init();
 }
 
 
@@ -1525,7 +3058,22 @@ std::shared_ptr<FunapiUdp> FunapiUdp::Create(const char* hostname_or_ip,
 
 
 bool FunapiUdp::Send(const fun::vector<uint8_t> &body, const SendCompletionHandler &send_handler) {
-  return impl_->Send(body, send_handler);
+  return impl_->Send(body.data(), body.size(), send_handler);
+}
+
+
+bool FunapiUdp::Send(const uint8_t *data, const size_t size, const SendCompletionHandler &send_handler) {
+  return impl_->Send(data, size, send_handler);
+}
+
+
+bool FunapiUdp::Send(fun::vector<Frame> &frames, const SendCompletionHandler &send_handler) {
+  return impl_->Send(frames, send_handler);
+}
+
+
+void FunapiUdp::RequestSend() {
+  impl_->RequestSend();
 }
 
 
@@ -13,7 +13,33 @@ namespace fun {
 
 class FunapiSocket {
  public:
-  static bool Poll();
+  typedef std::function<void()> TimerHandler;
+
+  // 전송할 프레임. data 가 가리키는 메모리는 data 의 소유자가 살아 있는 동안 유지되어야 한다.
+  // 소켓은 프레임을 복사하지 않고 보낼 때까지 참조만 보관한다.
+  struct Frame {
+    std::shared_ptr<const uint8_t> data;
+    size_t size;
+  };
+
+  // network_thread_index 는 FunapiThread::GetNetworkThreadId() 의 번호이다.
+  // 소켓은 생성된 네트워크 스레드의 Poll() 에서만 처리된다.
+  static bool Poll(const int network_thread_index = 0);
+
+  // Poll() 을 수행하는 네트워크 스레드에서 expired_time 이후에 handler 를 호출한다.
+  // Poll() 은 가장 가까운 만료 시각까지만 대기한다.
+  static void AddTimer(const int network_thread_index,
+                       const std::chrono::steady_clock::time_point &expired_time,
+                       const TimerHandler &handler);
+
+  // 수신 버퍼를 새로 할당한 횟수. 버퍼는 네트워크 스레드마다 재사용되므로 정상 상태에서는 더 늘어나지 않는다.
+  static uint64_t GetRecvBufferAllocationCount();
+
+  // TLS 연결 중 저장된 세션을 재사용한 횟수와 전체 handshake 를 한 횟수.
+  // 세션은 host:port 마다 하나씩 프로세스 전체에서 공유한다.
+  static uint64_t GetTlsSessionResumedCount();
+  static uint64_t GetTlsFullHandshakeCount();
+  static void ClearTlsSessionCache();
 };
 
 
@@ -25,6 +51,9 @@ class FunapiAddrInfo : public std::enable_shared_from_this<FunapiAddrInfo> {
 
   static std::shared_ptr<FunapiAddrInfo> Create();
 
+  // addrinfo_res 는 getaddrinfo 의 결과이며 소멸될 때 freeaddrinfo 로 해제된다.
+  static std::shared_ptr<FunapiAddrInfo> Create(struct addrinfo *addrinfo_res);
+
   fun::string GetString();
   std::shared_ptr<FunapiAddrInfoImpl> GetImpl();
 
@@ -55,6 +84,8 @@ class FunapiTcp : public std::enable_shared_from_this<FunapiTcp> {
                              const fun::string &error_string,
                              const int sent_length)> SendCompletionHandler;
 
+  typedef FunapiSocket::Frame Frame;
+
   FunapiTcp();
   virtual ~FunapiTcp();
 
@@ -84,6 +115,17 @@ class FunapiTcp : public std::enable_shared_from_this<FunapiTcp> {
   bool Send(const fun::vector<uint8_t> &body,
             const SendCompletionHandler &send_completion_handler);
 
+  // frames 는 비워진다.
+  bool Send(fun::vector<Frame> &frames,
+            const SendCompletionHandler &send_completion_handler);
+
+  // 보낼 메시지가 생겼음을 알린다. 다음 Poll() 에서 이 소켓의 SendHandler 가 호출된다.
+  void RequestSend();
+
+  // Connect() 전에 호출한다. TLS handshake 가 끝나면 암호화를 커널(kTLS)에 맡기고
+  // 평문 소켓과 같은 경로로 보낸다. 지원하지 않는 환경에서는 OpenSSL 로 암호화한다.
+  void SetUseKernelTLS(const bool use_kernel_tls);
+
   int GetSocket();
 
 #ifdef FUNAPI_PLATFORM_WINDOWS
@@ -117,6 +159,8 @@ class FunapiUdp : public std::enable_shared_from_this<FunapiUdp> {
                              const fun::string &error_string,
                              const int sent_length)> SendCompletionHandler;
 
+  typedef FunapiSocket::Frame Frame;
+
   FunapiUdp() = delete;
   FunapiUdp(const char* hostname_or_ip,
             const int port,
@@ -132,6 +176,16 @@ class FunapiUdp : public std::enable_shared_from_this<FunapiUdp> {
                                            const RecvHandler &recv_handler);
 
   bool Send(const fun::vector<uint8_t> &body, const SendCompletionHandler &send_completion_handler);
+  bool Send(const uint8_t *data, const size_t size, const SendCompletionHandler &send_completion_handler);
+
+  // 프레임마다 데이터그램 하나로 보내고 send_completion_handler 도 프레임마다 호출된다.
+  // 보낸 프레임은 frames 에서 빠지고 보내지 못한 프레임은 순서대로 남는다.
+  // 송신 버퍼가 가득 찼으면 쓰기 가능해질 때 SendHandler 가 다시 호출된다.
+  // 모두 보냈으면 true 를 돌려준다.
+  bool Send(fun::vector<Frame> &frames, const SendCompletionHandler &send_completion_handler);
+
+  // 보낼 메시지가 생겼음을 알린다. 다음 Poll() 에서 이 소켓의 SendHandler 가 호출된다.
+  void RequestSend();
 
   int GetSocket();
 #ifdef FUNAPI_PLATFORM_WINDOWS
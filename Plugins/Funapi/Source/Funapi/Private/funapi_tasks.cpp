@@ -13,6 +13,7 @@
 #include "funapi_utils.h"
 #include "funapi_session.h"
 #include "funapi_socket.h"
+#include "funapi_send_flag_manager.h"
 #include "funapi_announcement.h"
 #include "funapi_downloader.h"
 
@@ -154,10 +155,22 @@ class FunapiThreadImpl : public FunapiTasksImpl {
   bool run_ = false;
   std::condition_variable_any condition_;
   fun::string thread_id_;
+  bool is_network_ = false;
+  int network_thread_index_ = 0;
 };
 
 
 FunapiThreadImpl::FunapiThreadImpl(const fun::string &thread_id) : thread_id_(thread_id) {
+  for (int i = 0; i < FunapiThread::kMaxNetworkThreadCount; ++i)
+  {
+    if (thread_id_.compare(FunapiThread::GetNetworkThreadId(i)) == 0)
+    {
+      is_network_ = true;
+      network_thread_index_ = i;
+      break;
+    }
+  }
+
   Initialize();
 }
 
@@ -182,12 +195,24 @@ void FunapiThreadImpl::Finalize() {
 void FunapiThreadImpl::Push(const TaskHandler &task)
 {
   FunapiTasksImpl::Push(task);
-  condition_.notify_one();
+  if (is_network_)
+  {
+    // 네트워크 스레드는 소켓 이벤트나 타이머를 기다리고 있으므로 깨워준다.
+    FunapiSendFlagManager::Get().Signal(network_thread_index_);
+  }
+  else
+  {
+    condition_.notify_one();
+  }
 }
 
 
 void FunapiThreadImpl::JoinThread() {
   run_ = false;
+  if (is_network_)
+  {
+    FunapiSendFlagManager::Get().Signal(network_thread_index_);
+  }
 #ifndef FUNAPI_UE4_PLATFORM_WINDOWS
   condition_.notify_all();
 #endif
@@ -197,17 +222,11 @@ void FunapiThreadImpl::JoinThread() {
 
 
 void FunapiThreadImpl::Thread() {
-  bool is_network = false;
-  if (thread_id_.compare("_network") == 0)
-  {
-    is_network = true;
-  }
-
   while (run_)
   {
-    if (is_network)
+    if (is_network_)
     {
-      FunapiSocket::Poll();
+      FunapiSocket::Poll(network_thread_index_);
     }
     else
     {
@@ -269,6 +288,31 @@ void FunapiThread::Join() {
 }
 
 
+const int FunapiThread::kMaxNetworkThreadCount;
+static std::atomic<int> network_thread_count(1);
+
+
+void FunapiThread::SetNetworkThreadCount(const int count) {
+  network_thread_count = std::max(1, std::min(count, kMaxNetworkThreadCount));
+}
+
+
+int FunapiThread::GetNetworkThreadCount() {
+  return network_thread_count;
+}
+
+
+fun::string FunapiThread::GetNetworkThreadId(const int index) {
+  if (index == 0) {
+    return "_network";
+  }
+
+  fun::stringstream ss;
+  ss << "_network" << index;
+  return ss.str();
+}
+
+
 std::shared_ptr<FunapiThread> FunapiThread::Get(const fun::string &thread_id) {
   static fun::unordered_map<fun::string, std::shared_ptr<FunapiThread>> map_threads;
   static std::mutex threads_mutex;
@@ -120,6 +120,21 @@ bool FunapiUtil::DecodeBase64(const fun::string &in, fun::vector<uint8_t> &out)
 
   return false;
 }
+
+
+fun::string FunapiUtil::EncodeBase64(const fun::vector<uint8_t> &in) {
+  fun::string ret;
+  char *buffer = nullptr;
+  cocos2d::base64Encode(in.data(), (unsigned int)in.size(), &buffer);
+  if (buffer) {
+    ret = buffer;
+
+    free (buffer);
+    buffer = nullptr;
+  }
+
+  return ret;
+}
 #endif
 
 #ifdef FUNAPI_UE4
@@ -134,6 +149,15 @@ bool FunapiUtil::DecodeBase64(const fun::string &in, fun::vector<uint8_t> &out)
 
   return ret;
 }
+
+
+fun::string FunapiUtil::EncodeBase64(const fun::vector<uint8_t> &in) {
+  TArray<uint8> temp_array;
+  temp_array.Append(in.data(), in.size());
+
+  FString encoded = FBase64::Encode(temp_array);
+  return fun::string(TCHAR_TO_UTF8(*encoded));
+}
 #endif // FUNAPI_UE4
 
 
@@ -337,10 +361,7 @@ FunapiTimer::FunapiTimer(time_t seconds) {
 
 
 bool FunapiTimer::IsExpired() const {
-  if (time_ == 0)
-    return false;
-
-  if (time(NULL) > time_)
+  if (std::chrono::steady_clock::now() >= expired_time_)
     return true;
 
   return false;
@@ -348,10 +369,15 @@ bool FunapiTimer::IsExpired() const {
 
 
 void FunapiTimer::SetTimer(const time_t seconds) {
-  time_ = time(NULL) + seconds;
+  expired_time_ = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
 };
 
 
+FunapiTimer::TimePoint FunapiTimer::GetExpiredTime() const {
+  return expired_time_;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // DebugUtils implementation.
 
@@ -55,12 +55,16 @@ template <typename T> class FunapiEvent
 class FunapiTimer
 {
  public:
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
   FunapiTimer(time_t seconds = 0);
   bool IsExpired() const;
   void SetTimer(const time_t seconds);
 
+  TimePoint GetExpiredTime() const;
+
  private:
-  time_t time_ = 0;
+  TimePoint expired_time_;
 };
 
 
@@ -86,6 +90,7 @@ class FunapiUtil
   static fun::string BytesFromString(const fun::string &uuid);
 
   static bool DecodeBase64(const fun::string &in, fun::vector<uint8_t> &out);
+  static fun::string EncodeBase64(const fun::vector<uint8_t> &in);
 
   static int GetSocketErrorCode();
   static fun::string GetSocketErrorString(const int code);
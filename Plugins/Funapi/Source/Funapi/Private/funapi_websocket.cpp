@@ -58,7 +58,8 @@ class FunapiWebsocketImpl : public std::enable_shared_from_this<FunapiWebsocketI
                const SendHandler &send_handler,
                const RecvHandler &recv_handler);
 
-  bool Send(const fun::vector<uint8_t> &body,
+  bool Send(const uint8_t *data,
+            const size_t size,
             const bool is_binary,
             const SendCompletionHandler &send_completion_handler);
 
@@ -299,7 +300,8 @@ void FunapiWebsocketImpl::Connect(const char* hostname_or_ip,
 }
 
 
-bool FunapiWebsocketImpl::Send(const fun::vector<uint8_t> &body,
+bool FunapiWebsocketImpl::Send(const uint8_t *data,
+                               const size_t size,
                                const bool is_binary,
                                const SendCompletionHandler &send_completion_handler) {
 #if FUNAPI_HAVE_WEBSOCKET
@@ -307,13 +309,13 @@ bool FunapiWebsocketImpl::Send(const fun::vector<uint8_t> &body,
     is_binary_ = is_binary;
     send_completion_handler_ = send_completion_handler;
 
-    send_buffer_length_ = body.size();
+    send_buffer_length_ = size;
     if (send_buffer_length_ > FUNAPI_WEBSOCKET_MAX_SEND_BUFFER - LWS_PRE) {
       send_buffer_length_ = FUNAPI_WEBSOCKET_MAX_SEND_BUFFER - LWS_PRE;
     }
 
     memset(send_buffer_, 0x00, LWS_PRE);
-    memcpy(send_buffer_ + LWS_PRE, body.data(), send_buffer_length_);
+    memcpy(send_buffer_ + LWS_PRE, data, send_buffer_length_);
 
     return true;
   }
@@ -420,7 +422,15 @@ void FunapiWebsocket::Connect(const char* hostname_or_ip,
 bool FunapiWebsocket::Send(const fun::vector<uint8_t> &body,
                            const bool is_binary,
                            const SendCompletionHandler &send_completion_handler) {
-  return impl_->Send(body, is_binary, send_completion_handler);
+  return impl_->Send(body.data(), body.size(), is_binary, send_completion_handler);
+}
+
+
+bool FunapiWebsocket::Send(const uint8_t *data,
+                           const size_t size,
+                           const bool is_binary,
+                           const SendCompletionHandler &send_completion_handler) {
+  return impl_->Send(data, size, is_binary, send_completion_handler);
 }
 
 
@@ -56,6 +56,11 @@ class FunapiWebsocket : public std::enable_shared_from_this<FunapiWebsocket> {
             const bool is_binary,
             const SendCompletionHandler &send_completion_handler);
 
+  bool Send(const uint8_t *data,
+            const size_t size,
+            const bool is_binary,
+            const SendCompletionHandler &send_completion_handler);
+
   void Update();
 
  private:
@@ -10,6 +10,10 @@
 #include "funapi_plugin.h"
 
 #define kProtocolCompressionField "C"
+#define kProtocolStreamCompressionField "CS"
+#define kStreamCompressionVersionField "CSV"
+#define kCompressionDictionaryField "CD"
+#define kCompressionDictionaryOfferField "CDO"
 
 namespace fun {
 
@@ -19,12 +23,61 @@ enum class FUNAPI_API CompressionType : int {
 #endif
 #if FUNAPI_HAVE_ZLIB
   kDeflate,  // DEFLATE
+#endif
+#if FUNAPI_HAVE_LZ4
+  kLz4,      // LZ4 (block format)
 #endif
   kDefault,
   kNone,
 };
 
 
+enum class FUNAPI_API CompressionPolicy : int {
+  kAdaptive = 0,  // 압축 효과를 메시지 타입마다 추정해서 효과가 없으면 압축을 쉰다.
+  kAlways,
+  kNever,
+};
+
+
+// 메시지 타입별 압축 규칙. threshold 가 0 이상이면 이 타입은 SetThreshold() 값 대신 사용한다.
+struct FUNAPI_API CompressionRule {
+  fun::string msg_type;
+  CompressionPolicy policy;
+  int threshold;
+};
+
+
+// 메시지 타입별 압축 통계. 압축률은 압축 후 크기 / 압축 전 크기이다.
+struct FUNAPI_API CompressionStatistics {
+  fun::string msg_type;
+  CompressionPolicy policy;
+  uint64_t compressed_count;       // 압축해서 보낸 메시지 수
+  uint64_t not_compressed_count;   // 압축을 시도했지만 작아지지 않아 그대로 보낸 메시지 수
+  uint64_t skipped_count;          // 정책이나 추정 결과로 압축을 시도하지 않은 메시지 수
+  uint64_t original_bytes;         // 압축을 시도한 메시지의 압축 전 크기 합
+  uint64_t sent_bytes;             // 압축을 시도한 메시지의 보낸 크기 합
+  uint64_t compress_microseconds;  // 압축에 걸린 시간 합
+  double ratio;                    // 최근 압축률 추정값
+  bool paused;                     // 효과가 없어 압축을 쉬고 있는지
+};
+
+
+#if FUNAPI_HAVE_ZSTD && FUNAPI_HAVE_ZDICT
+// FunapiCompression::TrainZstdDictionary() 의 결과.
+// 압축률(압축 후 크기 / 압축 전 크기)은 학습에 쓰지 않은 표본으로 잰다.
+struct FUNAPI_API ZstdDictionaryReport {
+  uint32_t dict_id;
+  size_t dict_size;
+  size_t train_sample_count;
+  size_t test_sample_count;
+  double ratio_without_dict;
+  double ratio_with_dict;
+};
+#endif
+
+
+class FunapiHeaderView;
+class FunapiHeaderWriter;
 class FunapiCompressionImpl;
 class FUNAPI_API FunapiCompression : public std::enable_shared_from_this<FunapiCompression> {
  public:
@@ -33,20 +86,79 @@ class FUNAPI_API FunapiCompression : public std::enable_shared_from_this<FunapiC
   FunapiCompression();
   virtual ~FunapiCompression();
 
+  static const int kStreamCompressionVersion = 1;
+
   void SetCompressionType(const CompressionType type);
   void SetThreshold(int threshold);
 #if FUNAPI_HAVE_ZSTD
   void SetZstdDictBase64String(const fun::string &zstd_dict_base64string);
 #endif
+#if FUNAPI_HAVE_ZSTD
+  // 사전 ID 로 구분하는 사전을 등록하고 사전 ID 를 반환한다. 사전 ID 가 없는 사전은 등록하지 않고 0 을 반환한다.
+  // 사전 ID 로 압축한 메시지는 헤더의 CD 필드에 사전 ID 를 붙이므로 여러 버전의 사전을 같이 등록해 둘 수 있다.
+  uint32_t AddZstdDictBase64String(const fun::string &zstd_dict_base64string);
+  // 보낼 메시지를 압축할 사전. 0 이면 SetZstdDictBase64String() 의 사전을 쓴다.
+  // 등록하지 않은 사전 ID 이면 false 를 반환한다. 스트림 압축에는 쓰이지 않는다.
+  bool SetZstdDictId(const uint32_t dict_id);
+  uint32_t GetZstdDictId();
+  // 마지막으로 등록한 사전 ID. 없으면 0 이다.
+  uint32_t GetLatestZstdDictId();
+#endif
+
+#if FUNAPI_HAVE_ZSTD && FUNAPI_HAVE_ZDICT
+  // samples 로 dict_capacity 크기 이하의 사전을 학습한다. 표본 10 개 중 하나는 학습에서 빼고
+  // 압축률을 재는 데 쓴다. dict_id 가 0 이 아니면 사전 ID 를 그 값으로 정한다.
+  static bool TrainZstdDictionary(const fun::vector<fun::vector<uint8_t>> &samples,
+                                  const size_t dict_capacity,
+                                  const uint32_t dict_id,
+                                  fun::string &zstd_dict_base64string,
+                                  ZstdDictionaryReport &report);
+#endif
+
+  // 사전 학습용 표본을 모은다. 보내고 받는 메시지 sample_interval 개마다 하나씩
+  // 압축 전 본문을 복사하고 모은 크기가 max_bytes 를 넘으면 멈춘다.
+  void StartCapture(const size_t sample_interval, const size_t max_bytes);
+  void StopCapture();
+  bool IsCapturing();
+  fun::vector<fun::vector<uint8_t>> GetCapturedSamples();
+
+#if FUNAPI_HAVE_LZ4
+  // 사전의 마지막 64KB 를 압축 전 데이터처럼 참조한다. zstd 로 만든 사전을 그대로 써도 된다.
+  void SetLz4DictBase64String(const fun::string &lz4_dict_base64string);
+#endif
 
   bool Compress(HeaderFields &header_fields, fun::vector<uint8_t> &body);
+  // body 의 offset 이후를 본문으로 보고 압축한다. offset 앞의 내용은 유지된다.
+  bool Compress(FunapiHeaderWriter &header, fun::vector<uint8_t> &body, const size_t offset);
+  // msg_type 의 압축 정책을 따르고 통계를 남긴다.
+  bool Compress(FunapiHeaderWriter &header, fun::vector<uint8_t> &body, const size_t offset,
+                const fun::string &msg_type);
   bool Decompress(HeaderFields &header_fields, fun::vector<uint8_t> &body);
+  bool Decompress(const FunapiHeaderView &header, fun::vector<uint8_t> &body);
+  // in 을 복사하지 않고 out 에 압축을 푼다. 압축하지 않은 메시지는 out 에 그대로 복사한다.
+  // out 은 재사용할 수 있고, 뒤에 NUL 을 붙여도 재할당되지 않도록 1 바이트 더 확보해 둔다.
+  bool Decompress(const FunapiHeaderView &header,
+                  const uint8_t *in, const size_t in_size,
+                  fun::vector<uint8_t> &out);
 
   void SetHeaderFieldsForHttpSend (HeaderFields &header_fields);
   void SetHeaderFieldsForHttpRecv (HeaderFields &header_fields);
 
   bool HasCompression(const CompressionType type);
 
+  // 규칙이 없는 메시지 타입은 kAdaptive 를 따른다.
+  void SetPolicy(const CompressionRule &rule);
+  fun::vector<CompressionStatistics> GetStatistics();
+
+  // 스트림 압축은 연결 동안 방향마다 하나의 스트림을 유지하고 메시지마다 flush 한다.
+  // 이전 메시지를 참조하므로 압축한 프레임은 모두 순서대로 보내야 한다.
+  // 스트림으로 압축한 메시지는 C 대신 CS 필드에 압축 전 길이를 쓴다.
+  void SetStreaming(const bool streaming);
+  bool IsStreaming();
+
+  // 새 연결을 시작할 때 호출한다. 두 방향의 스트림을 버리고 메시지 단위 압축으로 돌아간다.
+  void ResetStream();
+
  private:
   std::shared_ptr<FunapiCompressionImpl> impl_;
 };
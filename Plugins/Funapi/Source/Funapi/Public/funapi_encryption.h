@@ -21,6 +21,8 @@ enum class FUNAPI_API EncryptionType : int {
   kAes128Encryption,
 };
 
+class FunapiHeaderView;
+class FunapiHeaderWriter;
 class FunapiEncryptionImpl;
 class FUNAPI_API FunapiEncryption : public std::enable_shared_from_this<FunapiEncryption> {
  public:
@@ -35,7 +37,15 @@ class FUNAPI_API FunapiEncryption : public std::enable_shared_from_this<FunapiEn
   bool Encrypt(HeaderFields &header_fields,
                fun::vector<uint8_t> &body,
                const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
+  // body 의 offset 이후를 본문으로 보고 제자리에서 암호화한다.
+  bool Encrypt(FunapiHeaderWriter &header,
+               fun::vector<uint8_t> &body,
+               const size_t offset,
+               const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
   bool Decrypt(HeaderFields &header_fields, fun::vector<uint8_t> &body, fun::vector<EncryptionType>& encryption_types);
+  bool Decrypt(const FunapiHeaderView &header, fun::vector<uint8_t> &body, fun::vector<EncryptionType>& encryption_types);
+  // 수신 버퍼 안의 본문을 복사하지 않고 제자리에서 복호화한다.
+  bool Decrypt(const FunapiHeaderView &header, uint8_t *data, const size_t size, fun::vector<EncryptionType>& encryption_types);
 
   void SetHeaderFieldsForHttpSend (HeaderFields &header_fields);
   void SetHeaderFieldsForHttpRecv (HeaderFields &header_fields);
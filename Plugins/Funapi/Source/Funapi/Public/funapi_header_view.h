@@ -0,0 +1,224 @@
+// Copyright (C) 2020 iFunFactory Inc. All Rights Reserved.
+//
+// This work is confidential and proprietary to iFunFactory Inc. and
+// must not be used, disclosed, copied, or distributed without the prior
+// consent of iFunFactory Inc.
+
+#ifndef SRC_FUNAPI_HEADER_VIEW_H_
+#define SRC_FUNAPI_HEADER_VIEW_H_
+
+#include "funapi_plugin.h"
+
+// Funapi header-related constants.
+#define kVersionHeaderField "VER"
+#define kPluginVersionHeaderField "PVER"
+#define kEncryptionHeaderField "ENC"
+#define kBinaryHeaderField "BIN"
+
+namespace fun {
+
+// 바이너리 헤더 형식. 텍스트 헤더는 필드 이름(ASCII)으로 시작하므로 첫 바이트의 최상위 비트로 구분한다.
+//
+//   byte 0  : 0x80 | 프로토콜 버전(VER)
+//   byte 1  : 플래그
+//             0x07  암호화 타입 - 100 (0 이면 암호화하지 않음)
+//             0x08  압축 전 길이(C) varint
+//             0x10  ENC 필드 문자열 (varint 길이 + 바이트, handshake 가 있는 경우)
+//             0x20  PVER varint
+//             0x40  추가 필드 (varint 개수 + (varint 길이 + 이름, varint 길이 + 값) 반복)
+//             0x80  C 가 스트림 압축 전 길이(CS)
+//   varint  : 본문 길이(LEN)
+//   이후 플래그 순서대로 선택 필드
+//
+// 바이너리 헤더는 연결마다 첫 메시지의 텍스트 헤더에 "BIN:<버전>" 을 넣어 제안하고
+// 서버가 같은 필드로 응답한 뒤부터 사용한다.
+
+// 수신한 메시지의 헤더 필드를 복사하지 않고 가리키는 헤더.
+// 필드는 헤더를 파싱한 버퍼를 가리키므로 그 버퍼가 바뀌기 전까지만 유효하다.
+// VER, LEN, C(압축 전 길이), ENC 필드는 추가할 때 미리 해석해 둔다.
+class FUNAPI_API FunapiHeaderView {
+ public:
+  static const int kMaxFields = 16;
+
+  static const int kBinaryHeaderVersion = 1;
+  static const uint8_t kBinaryHeaderMarker = 0x80;
+  static const uint8_t kBinaryEncryptionTypeMask = 0x07;
+  static const uint8_t kBinaryCompressedFlag = 0x08;
+  static const uint8_t kBinaryEncryptionFieldFlag = 0x10;
+  static const uint8_t kBinaryPluginVersionFlag = 0x20;
+  static const uint8_t kBinaryExtraFieldsFlag = 0x40;
+  static const uint8_t kBinaryStreamCompressedFlag = 0x80;
+
+  struct Field {
+    const char *name;
+    size_t name_length;
+    const char *value;
+    size_t value_length;
+  };
+
+  typedef fun::map<fun::string, fun::string> HeaderFields;
+
+  FunapiHeaderView();
+
+  void Clear();
+
+  // 필드 수가 kMaxFields 를 넘으면 false 를 반환한다.
+  bool Add(const char *name, const size_t name_length,
+           const char *value, const size_t value_length);
+
+  // 바이너리 헤더를 파싱한 결과.
+  enum class BinaryParseResult : int {
+    kComplete = 0,
+    kIncomplete,  // 헤더가 아직 다 도착하지 않았다.
+    kInvalid,
+  };
+
+  static bool IsBinaryHeader(const uint8_t first_byte);
+
+  // data 앞부분의 바이너리 헤더를 파싱하고 헤더 길이를 header_size 에 쓴다.
+  // 숫자 필드는 값만 보관하고 필드 목록에는 ENC 와 추가 필드만 들어간다.
+  BinaryParseResult ParseBinary(const uint8_t *data,
+                                const size_t size,
+                                size_t &header_size);
+
+  // HTTP 응답처럼 다른 필드가 섞여 있는 경우 프로토콜 필드(VER, LEN, C, ENC)만 추가한다.
+  bool AddProtocolFields(const HeaderFields &header_fields);
+
+  int GetFieldCount() const;
+  const Field& GetField(const int index) const;
+  const Field* Find(const char *name) const;
+
+  bool HasVersion() const;
+  long GetVersion() const;
+
+  bool HasLength() const;
+  bool IsLengthValid() const;
+  size_t GetLength() const;
+
+  // 압축되지 않은 메시지는 0 을 반환한다.
+  size_t GetUncompressedLength() const;
+
+  // 연결 단위 스트림으로 압축된 메시지인지(CS 필드) 확인한다.
+  bool IsStreamCompressed() const;
+  // 사전 ID 로 고른 zstd 사전으로 압축했으면 그 사전 ID, 아니면 0.
+  uint32_t GetDictionaryId() const;
+
+  const Field* GetEncryption() const;
+
+  fun::string ToString() const;
+
+  // 10진수 문자열. 숫자가 아닌 문자가 있거나 값이 size_t 를 넘으면 false 를 반환한다.
+  static bool ParseNumber(const char *str, const size_t length, size_t &number);
+
+  // LEB128 형식의 varint. 값이 size_t 를 넘으면 false 를 반환한다.
+  static bool ParseVarint(const uint8_t *&ptr, const uint8_t *end, size_t &number);
+
+ private:
+  bool ParseBinaryString(const uint8_t *&ptr, const uint8_t *end,
+                         const char *&str, size_t &length);
+
+  Field fields_[kMaxFields];
+  int field_count_ = 0;
+
+  bool has_version_ = false;
+  bool has_length_ = false;
+  int encryption_index_ = -1;
+
+  bool binary_ = false;
+  long plugin_version_number_ = -1;
+
+  // 바이너리 헤더의 암호화 타입을 ENC 필드 값으로 바꿔 둔다.
+  char encryption_value_[8];
+
+  long version_number_ = -1;
+  bool length_valid_ = false;
+  size_t length_number_ = 0;
+  size_t uncompressed_length_ = 0;
+  bool stream_compressed_ = false;
+  uint32_t dictionary_id_ = 0;
+};
+
+
+// 보낼 메시지의 헤더.
+// 문자열 변환 없이 숫자 필드를 보관하다가 Write() 에서 바로 버퍼에 쓴다.
+class FUNAPI_API FunapiHeaderWriter {
+ public:
+  // 본문 앞에 비워 두는 공간. 일반적인 헤더는 이 안에 들어간다.
+  static const size_t kHeadroom = 64;
+
+  FunapiHeaderWriter();
+
+  // 바이너리 헤더로 쓴다. 필드는 텍스트 헤더와 같다.
+  void SetBinary(const bool binary);
+  bool IsBinary() const;
+
+  // BIN, CSV 처럼 연결 옵션을 제안하는 숫자 필드를 더한다. 바이너리 헤더에서는 추가 필드로 쓴다.
+  // name 은 Write() 가 끝날 때까지 유지되어야 한다. kMaxExtraFields 를 넘으면 false 를 반환한다.
+  static const int kMaxExtraFields = 4;
+  bool AddField(const char *name, const size_t number);
+  bool FindField(const char *name, size_t &number) const;
+
+  void SetVersion(const int version);
+  void SetPluginVersion(const int plugin_version);
+
+  void SetLength(const size_t length);
+  size_t GetLength() const;
+
+  void SetUncompressedLength(const size_t length);
+  size_t GetUncompressedLength() const;
+
+  // 압축 전 길이를 C 대신 CS 필드로 쓴다.
+  void SetStreamCompressed(const bool stream_compressed);
+
+  // handshake 가 있으면 "<type>-<handshake>" 로 쓴다.
+  // handshake 는 Write() 가 끝날 때까지 유지되어야 한다.
+  void SetEncryption(const int encryption_type,
+                     const char *handshake = nullptr,
+                     const size_t handshake_length = 0);
+
+  size_t GetSize() const;
+
+  // GetSize() 만큼의 바이트를 out 에 쓴다.
+  size_t Write(uint8_t *out) const;
+
+  fun::string ToString() const;
+
+  // std::to_chars 처럼 10진수 문자열을 쓰고 길이를 반환한다.
+  static size_t FormatNumber(char *out, size_t number);
+  static size_t GetNumberLength(size_t number);
+
+  static size_t WriteVarint(uint8_t *out, size_t number);
+  static size_t GetVarintLength(size_t number);
+
+ private:
+  size_t WriteField(char *out, const char *name, const size_t number) const;
+
+  size_t GetBinarySize() const;
+  size_t WriteBinary(uint8_t *out) const;
+  size_t GetEncryptionValueLength() const;
+  bool IsCompactEncryption() const;
+
+  struct ExtraField {
+    const char *name;
+    size_t number;
+  };
+
+  bool binary_ = false;
+  ExtraField extra_fields_[kMaxExtraFields];
+  int extra_field_count_ = 0;
+
+  int version_ = 0;
+  int plugin_version_ = -1;
+  size_t length_ = 0;
+  size_t uncompressed_length_ = 0;
+  bool stream_compressed_ = false;
+
+  bool has_encryption_ = false;
+  int encryption_type_ = 0;
+  const char *handshake_ = nullptr;
+  size_t handshake_length_ = 0;
+};
+
+}  // namespace fun
+
+#endif  // SRC_FUNAPI_HEADER_VIEW_H_
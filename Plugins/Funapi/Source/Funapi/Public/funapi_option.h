@@ -13,6 +13,8 @@ namespace fun {
 
 enum class FUNAPI_API EncryptionType : int;
 enum class FUNAPI_API CompressionType : int;
+enum class FUNAPI_API CompressionPolicy : int;
+struct FUNAPI_API CompressionRule;
 
 class FUNAPI_API FunapiTransportOption : public std::enable_shared_from_this<FunapiTransportOption> {
  public:
@@ -49,6 +51,17 @@ class FUNAPI_API FunapiTcpTransportOption : public FunapiTransportOption {
   void SetSequenceNumberValidation(const bool validation);
   bool GetSequenceNumberValidation();
 
+  // 연결마다 첫 메시지에서 바이너리 헤더를 제안하고 서버가 수락하면
+  // 텍스트 헤더(VER, LEN 등) 대신 고정 형식의 바이너리 헤더를 사용한다.
+  // 서버가 응답하지 않으면 텍스트 헤더를 그대로 사용한다.
+  void SetUseBinaryHeader(const bool use_binary_header);
+  bool GetUseBinaryHeader();
+
+  // 압축을 사용할 때 연결마다 서버와 협상해서 이전 메시지를 참조하는 스트림 압축을 사용한다.
+  // 스트림은 연결이 끊기면 버리고 재연결할 때 다시 협상한다.
+  void SetUseStreamCompression(const bool use_stream_compression);
+  bool GetUseStreamCompression();
+
   void SetConnectTimeout(const int seconds);
   int GetConnectTimeout();
 
@@ -58,9 +71,27 @@ class FUNAPI_API FunapiTcpTransportOption : public FunapiTransportOption {
   void SetCompressionType(const CompressionType type);
   fun::vector<CompressionType> GetCompressionTypes();
 
+  // msg_type 메시지의 압축 정책. threshold 가 0 이상이면 이 타입은 기본 임계값 대신 사용한다.
+  // 규칙이 없는 메시지 타입은 CompressionPolicy::kAdaptive 를 따른다.
+  void SetCompressionPolicy(const fun::string &msg_type,
+                            const CompressionPolicy policy,
+                            const int threshold = -1);
+  fun::vector<CompressionRule> GetCompressionRules();
+
 #if FUNAPI_HAVE_ZSTD
   // void SetZstdDictBase64String(const fun::string &zstd_dict_base64string);
   fun::string GetZstdDictBase64String();
+
+  // 사전 ID 가 있는 zstd 사전을 등록한다. 연결할 때 마지막으로 등록한 사전을 서버에 제안하고
+  // 서버가 같은 사전 ID 로 응답하면 그 사전으로 압축한다. 응답이 없으면 기존 방식으로 압축한다.
+  void AddZstdDictBase64String(const fun::string &zstd_dict_base64string);
+  fun::vector<fun::string> GetZstdDictBase64Strings();
+#endif
+
+#if FUNAPI_HAVE_LZ4
+  // CompressionType::kLz4 의 사전. 서버에도 같은 사전을 설정해야 한다.
+  void SetLz4DictBase64String(const fun::string &lz4_dict_base64string);
+  fun::string GetLz4DictBase64String();
 #endif
 
   void SetEncryptionType(const EncryptionType type, const fun::string &public_key);
@@ -68,8 +99,13 @@ class FUNAPI_API FunapiTcpTransportOption : public FunapiTransportOption {
 
 #if FUNAPI_HAVE_TCP_TLS
   void SetUseTLS(const bool use_tls);
+
+  // Linux 에서 TLS handshake 이후 송신 암호화를 커널(kTLS)에 맡긴다.
+  // 커널이나 cipher 가 지원하지 않으면 기존처럼 OpenSSL 로 암호화한다.
+  void SetUseKernelTLS(const bool use_kernel_tls);
 #endif
   bool GetUseTLS();
+  bool GetUseKernelTLS();
 
 #ifdef FUNAPI_UE4_PLATFORM_PS4
   void SetCACert(const fun::string &cert);
@@ -97,11 +133,24 @@ class FUNAPI_API FunapiUdpTransportOption : public FunapiTransportOption {
   void SetCompressionType(const CompressionType type);
   fun::vector<CompressionType> GetCompressionTypes();
 
+  // msg_type 메시지의 압축 정책. threshold 가 0 이상이면 이 타입은 기본 임계값 대신 사용한다.
+  // 규칙이 없는 메시지 타입은 CompressionPolicy::kAdaptive 를 따른다.
+  void SetCompressionPolicy(const fun::string &msg_type,
+                            const CompressionPolicy policy,
+                            const int threshold = -1);
+  fun::vector<CompressionRule> GetCompressionRules();
+
 #if FUNAPI_HAVE_ZSTD
   // void SetZstdDictBase64String(const fun::string &zstd_dict_base64string);
   fun::string GetZstdDictBase64String();
 #endif
 
+#if FUNAPI_HAVE_LZ4
+  // CompressionType::kLz4 의 사전. 서버에도 같은 사전을 설정해야 한다.
+  void SetLz4DictBase64String(const fun::string &lz4_dict_base64string);
+  fun::string GetLz4DictBase64String();
+#endif
+
  private:
   std::shared_ptr<FunapiUdpTransportOptionImpl> impl_;
 };
@@ -161,6 +210,13 @@ class FUNAPI_API FunapiWebsocketTransportOption : public FunapiTransportOption {
   void SetCompressionType(const CompressionType type);
   fun::vector<CompressionType> GetCompressionTypes();
 
+  // msg_type 메시지의 압축 정책. threshold 가 0 이상이면 이 타입은 기본 임계값 대신 사용한다.
+  // 규칙이 없는 메시지 타입은 CompressionPolicy::kAdaptive 를 따른다.
+  void SetCompressionPolicy(const fun::string &msg_type,
+                            const CompressionPolicy policy,
+                            const int threshold = -1);
+  fun::vector<CompressionRule> GetCompressionRules();
+
 #if FUNAPI_HAVE_ZSTD
   // void SetZstdDictBase64String(const fun::string &zstd_dict_base64string);
   fun::string GetZstdDictBase64String();
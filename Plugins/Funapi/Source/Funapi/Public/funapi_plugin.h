@@ -48,6 +48,7 @@
 #include <memory>
 #include <condition_variable>
 #include <thread>
+#include <atomic>
 #include <chrono>
 #include <algorithm>
 #include <random>
@@ -0,0 +1,54 @@
+// Copyright (C) 2020 iFunFactory Inc. All Rights Reserved.
+//
+// This work is confidential and proprietary to iFunFactory Inc. and
+// must not be used, disclosed, copied, or distributed without the prior
+// consent of iFunFactory Inc.
+
+#ifndef SRC_FUNAPI_RESOLVER_H_
+#define SRC_FUNAPI_RESOLVER_H_
+
+#include "funapi_plugin.h"
+
+namespace fun {
+
+class FunapiAddrInfo;
+
+// NOTE: 호스트 이름은 _resolver 스레드에서 조회하고 결과를 프로세스 전체에서 공유한다.
+// 실패한 조회도 잠시 캐시해서 같은 주소로 재연결을 반복할 때마다 기다리지 않도록 한다.
+class FUNAPI_API FunapiResolver {
+ public:
+  typedef std::function<void(const bool is_failed,
+                             const int error_code,
+                             const fun::string &error_string,
+                             std::shared_ptr<FunapiAddrInfo> addrinfo)> ResolveHandler;
+
+  // handler 는 캐시에 결과가 있어도 항상 network_thread_index 번 네트워크 스레드에서 호출된다.
+  // socktype 은 SOCK_STREAM 또는 SOCK_DGRAM 이다.
+  static void Resolve(const fun::string &hostname_or_ip,
+                      const int port,
+                      const int socktype,
+                      const int network_thread_index,
+                      const ResolveHandler &handler);
+
+  // 결과를 캐시에만 넣는다. 리다이렉트 대상처럼 곧 연결할 주소를 미리 조회할 때 사용한다.
+  static void Prefetch(const fun::string &hostname_or_ip,
+                       const int port,
+                       const int socktype);
+
+  // 기본값은 성공한 결과 60 초, 실패한 결과 5 초이다.
+  // getaddrinfo 는 DNS 레코드의 TTL 을 알려주지 않으므로 고정된 시간을 사용한다.
+  static void SetCacheTTL(const time_t positive_seconds,
+                          const time_t negative_seconds);
+  static void ClearCache();
+
+  // hosts 파일처럼 hostname 을 ip 로 고정한다. DNS 없이 테스트할 때 사용한다.
+  static void SetHostEntry(const fun::string &hostname, const fun::string &ip);
+  static void RemoveHostEntry(const fun::string &hostname);
+
+  // getaddrinfo 를 호출한 횟수. 캐시된 결과를 사용했는지 확인할 때 사용한다.
+  static uint64_t GetLookupCount();
+};
+
+}  // namespace fun
+
+#endif  // SRC_FUNAPI_RESOLVER_H_
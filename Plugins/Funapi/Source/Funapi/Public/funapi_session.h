@@ -77,6 +77,7 @@ extern FUNAPI_API fun::string TransportProtocolToString(TransportProtocol protoc
 class FunapiSessionOption;
 class FunapiSessionImpl;
 class FunapiUnsentMessage;
+class FunapiSharedPayload;
 class FUNAPI_API FunapiSession : public std::enable_shared_from_this<FunapiSession>
 {
 public:
@@ -142,6 +143,33 @@ public:
                      const TransportProtocol protocol = TransportProtocol::kDefault,
                      const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
 
+    // 미리 직렬화해 둔 본문을 보낸다. 같은 payload 를 여러 세션에 보낼 수 있다.
+    void SendMessage(std::shared_ptr<FunapiSharedPayload> payload,
+                     const TransportProtocol protocol = TransportProtocol::kDefault,
+                     const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
+
+    // 넘겨준 메시지를 복사하지 않고 그대로 보낸다. 호출한 뒤 json, message 는 비어 있다.
+    void SendMessage(const fun::string &msg_type,
+                     rapidjson::Document &&json,
+                     const TransportProtocol protocol = TransportProtocol::kDefault,
+                     const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
+
+    void SendMessage(FunMessage &&message,
+                     const TransportProtocol protocol = TransportProtocol::kDefault,
+                     const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
+
+    void SendMessage(std::unique_ptr<FunMessage> message,
+                     const TransportProtocol protocol = TransportProtocol::kDefault,
+                     const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
+
+    // 이미 직렬화한 본문을 보낸다. json 은 '{' 로 시작해서 '}' 로 끝나는 객체, protobuf 는 FunMessage 이다.
+    // msg_type 이 있으면 본문에 메시지 타입을 덧붙인다.
+    void SendMessage(const FunEncoding encoding,
+                     const fun::string &msg_type,
+                     fun::vector<uint8_t> &&body,
+                     const TransportProtocol protocol = TransportProtocol::kDefault,
+                     const EncryptionType encryption_type = EncryptionType::kDefaultEncryption);
+
     bool IsConnected(const TransportProtocol protocol) const;
     bool IsConnected() const;
     bool IsReliableSession() const;
@@ -155,6 +183,17 @@ public:
 
     int64_t GetPingTime();
 
+    // 메시지 타입별 압축 통계. 트랜스포트가 새로 만들어지면 (리다이렉트 등) 처음부터 다시 센다.
+    fun::vector<CompressionStatistics> GetCompressionStatistics(const TransportProtocol protocol) const;
+
+    // zstd 사전 학습용으로 protocol 트랜스포트가 보내고 받는 메시지 본문을 모은다.
+    // 모은 표본은 FunapiCompression::TrainZstdDictionary() 로 사전을 만드는 데 쓴다.
+    void StartCompressionCapture(const TransportProtocol protocol,
+                                 const size_t sample_interval,
+                                 const size_t max_bytes);
+    void StopCompressionCapture(const TransportProtocol protocol);
+    fun::vector<fun::vector<uint8_t>> GetCompressionCapture(const TransportProtocol protocol) const;
+
     void AddSessionEventCallback(const SessionEventHandler &handler);
     void AddTransportEventCallback(const TransportEventHandler &handler);
     void AddProtobufRecvCallback(const ProtobufRecvHandler &handler);
@@ -186,6 +225,12 @@ public:
 
     static void UpdateAll();
 
+    // TLS 연결에서 저장된 세션을 재사용한 횟수와 전체 handshake 를 한 횟수.
+    // 세션은 host:port 마다 하나씩 프로세스 전체에서 공유한다.
+    static uint64_t GetTlsSessionResumedCount();
+    static uint64_t GetTlsFullHandshakeCount();
+    static void ClearTlsSessionCache();
+
 private:
     std::shared_ptr<FunapiSessionImpl> impl_;
 };
@@ -203,6 +248,37 @@ public:
     virtual void SetDiscard(const bool discard) = 0;
 };
 
+
+// 여러 세션에 같은 메시지를 보낼 때 본문을 한 번만 직렬화해서 공유한다.
+// 세션마다 다른 필드(sid, seq, ack)는 보낼 때 세션별로 직렬화해서 본문에 덧붙인다.
+class FunapiSharedPayloadImpl;
+class FUNAPI_API FunapiSharedPayload : public std::enable_shared_from_this<FunapiSharedPayload>
+{
+public:
+    FunapiSharedPayload() = delete;
+    FunapiSharedPayload(const fun::string &msg_type, const fun::string &json_string);
+    FunapiSharedPayload(const FunMessage &message);
+    virtual ~FunapiSharedPayload() = default;
+
+    static std::shared_ptr<FunapiSharedPayload> Create(const fun::string &msg_type,
+                                                       const fun::string &json_string);
+    static std::shared_ptr<FunapiSharedPayload> Create(const FunMessage &message);
+
+    FunEncoding GetEncoding() const;
+    const fun::string& GetMsgType() const;
+    int32_t GetMsgType2() const;
+    size_t GetSize() const;
+
+    // 본문이 json 객체가 아니거나 예약 필드(_msgtype, _sid, _seq, _ack)가 있으면 false.
+    // 유효하지 않은 payload 는 보내지 않는다.
+    bool IsValid() const;
+
+    std::shared_ptr<FunapiSharedPayloadImpl> GetImpl() const;
+
+private:
+    std::shared_ptr<FunapiSharedPayloadImpl> impl_;
+};
+
 }  // namespace fun
 
 #endif  // SRC_FUNAPI_SESSION_H_
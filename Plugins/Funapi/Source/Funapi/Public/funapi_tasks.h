@@ -43,6 +43,14 @@ class FUNAPI_API FunapiThread : public std::enable_shared_from_this<FunapiThread
   static std::shared_ptr<FunapiThread> Create(const fun::string &thread_id);
   static std::shared_ptr<FunapiThread> Get(const fun::string &thread_id);
 
+  // NOTE: 소켓 I/O 를 처리하는 네트워크 스레드의 개수를 지정한다.
+  // 세션은 생성될 때 하나의 네트워크 스레드에 고정된다.
+  // 세션을 생성하기 전에 호출해야 하며 기본값은 1 이다.
+  static const int kMaxNetworkThreadCount = 16;
+  static void SetNetworkThreadCount(const int count);
+  static int GetNetworkThreadCount();
+  static fun::string GetNetworkThreadId(const int index);
+
   void Push(const TaskHandler &task);
   int Size();
   void Join();
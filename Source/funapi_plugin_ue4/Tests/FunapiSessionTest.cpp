@@ -11,6 +11,8 @@
 #include "funapi_multicasting.h"
 #include "funapi_tasks.h"
 #include "funapi_compression.h"
+#include "funapi_header_view.h"
+#include "funapi_resolver.h"
 
 #include <sstream>
 #include <thread>
@@ -939,6 +941,160 @@ bool FFunapiSessionTestReliabilityProtobuf::RunTest(const FString& Parameters)
 }
 
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiSessionTestReliabilityRetransmitCompressed, "Funapi.SessionReliability.SR_RetransmitCompressed", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiSessionTestReliabilityRetransmitCompressed::RunTest(const FString& Parameters)
+{
+#if FUNAPI_HAVE_ZSTD
+  // 사전 ID 로 압축해서 보낸 메시지를 재접속 후 다시 보낸다.
+  // 재접속 직후에는 사전과 스트림 압축을 다시 협상하므로 이전 연결에서 압축한 본문을 쓸 수 없고,
+  // 압축하지 않은 본문을 보낼 때 이전 연결의 C, CD 필드가 남아 있으면 서버가 메시지를 풀지 못한다.
+  static char dict[] = {
+    "N6Qw7OaV4zEcENhIgAAAAAAA2pAu8cEmbIanlFJKKU0jSZMxINMBAABCIJRW"
+    "+QIAAARAzIeVRcZN0YNRQRiFKgAAAIAAAAAAAAAAAAAAAAAAACRs5KZSRDquS4oAAAAAAAAAAAAAAA"
+    "EAAAAEAAAACAAAADksIl9tc2d0NTI1ODc4OSwiX21zZ196IjotOTAuOTAwMDAxLTIuNSwibG9va196"
+    "IjotOTBvb2tfeCI6LTIuNSwibDAzODE0Njk3MjcsImxvb2tfIjotOS4xMDAwMDAzODE0Njk5MDksIm"
+    "Rpcl96IjotOS4xMDAwMDE1MjU4Nzg5MDksImRpX3giOi0zMy45MDAwMDE1MjUyNDIxOSwiZGlyX3gi"
+    "Oi0zMy4xOTk5OTY5NDgyNDIxOSwicG9zX3oiOi03Ny4xOTk5OTYwOTI2NTEzNywicG9zX3oxMS4xOT"
+    "k5OTk4MDkyNjUxM29zX3giOi0xMS4xOTk5ImlkIjo0NDI4OCwicG9zX3hzdF9tb3ZlIn17ImlkIjo0"
+    "NHBlIjoicmVxdWVzdF9tb3ZlNDgsIl9tc2d0eXBlIjoicmUyMzcwNjA1NDgsIl9tc3oiOi0xNi43OT"
+    "k5OTkyMzEuNSwibG9va196IjotMTYuImxvb2tfeCI6NjEuNSwibG9feiI6LTMwLjUsImxvb2tfeC0z"
+    "OS41LCJkaXJfeiI6LTMwNSwiZGlyX3giOi0zOS41LCJwb3NfeiI6NTEuNSwiZGlyXzIzNzA2MDU1LC"
+    "Jwb3NfeiI6LTU0LjI5OTk5OTIzNzA2MDU0LCJwb3NfeCI6LTU0LjI5OXsiaWQiOjE0NDg0LCJwb3Nf"
+  };
+
+  const int send_count = 20;
+  fun::string server_address = g_server_address;
+  fun::FunEncoding encoding = fun::FunEncoding::kJson;
+  uint16_t port = 10231;
+  bool with_session_reliability = true;
+
+  auto send_function =[](
+    const std::shared_ptr<fun::FunapiSession>& s,
+    int number)
+  {
+    rapidjson::Document msg;
+    msg.SetObject();
+
+    fun::stringstream ss;
+    ss << "{\"pos_x\":31.01,\"pos_z\":45.5293984741,\"dir_x\":-14.199799809265137,\"look_x\":1.100000381469727,\"id\":" << number;
+
+    fun::string temp_messsage = ss.str();
+    rapidjson::Value message_node(temp_messsage.c_str(), msg.GetAllocator());
+    msg.AddMember(rapidjson::StringRef("message"), message_node, msg.GetAllocator());
+
+    // Convert JSON document to fun::string
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    msg.Accept(writer);
+    fun::string json_string = buffer.GetString();
+
+    s->SendMessage("echo", json_string);
+  };
+
+  auto session = fun::FunapiSession::Create(server_address.c_str(), with_session_reliability);
+  bool is_ok = true;
+  bool is_working = true;
+  bool is_opened = false;
+  int recv_count = 0;
+
+  session->AddSessionEventCallback(
+    [&is_opened](
+      const std::shared_ptr<fun::FunapiSession> &s,
+      const fun::TransportProtocol protocol,
+      const fun::SessionEventType type,
+      const fun::string &session_id,
+      const std::shared_ptr<fun::FunapiError> &error)
+  {
+    if (type == fun::SessionEventType::kOpened) {
+      is_opened = true;
+    }
+  });
+
+  session->AddTransportEventCallback(
+    [&is_ok, &is_working](
+      const std::shared_ptr<fun::FunapiSession> &s,
+      const fun::TransportProtocol protocol,
+      const fun::TransportEventType type,
+      const std::shared_ptr<fun::FunapiError> &error)
+  {
+    if (type == fun::TransportEventType::kConnectionFailed) {
+      is_ok = false;
+      is_working = false;
+    }
+    else if (type == fun::TransportEventType::kConnectionTimedOut) {
+      is_ok = false;
+      is_working = false;
+    }
+    else if (type == fun::TransportEventType::kStopped && error) {
+      // 압축을 풀지 못한 서버가 연결을 끊은 경우
+      is_ok = false;
+      is_working = false;
+    }
+
+    verify(type != fun::TransportEventType::kConnectionFailed);
+    verify(type != fun::TransportEventType::kConnectionTimedOut);
+  });
+
+  session->AddJsonRecvCallback(
+    [&is_working, &is_ok, &recv_count, send_count](
+      const std::shared_ptr<fun::FunapiSession> &s,
+      const fun::TransportProtocol protocol,
+      const fun::string &msg_type, const fun::string &json_string)
+  {
+    if (msg_type.compare("echo") == 0) {
+      ++recv_count;
+      if (recv_count >= send_count) {
+        is_working = false;
+      }
+    }
+  });
+
+  auto option = fun::FunapiTcpTransportOption::Create();
+  option->SetCompressionType(fun::CompressionType::kZstd);
+  option->SetUseStreamCompression(true);
+  option->AddZstdDictBase64String(dict);
+  session->Connect(fun::TransportProtocol::kTcp, port, encoding, option);
+
+  while (!is_opened && is_working) {
+    session->Update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(16)); // 60fps
+  }
+
+  // 응답을 받기 전에 끊어서 보낸 메시지가 재전송 대기열에 남도록 한다.
+  for (int i = 0; i < send_count; ++i) {
+    send_function(session, i);
+  }
+  session->Update();
+  session->Close(fun::TransportProtocol::kTcp);
+
+  while (session->IsConnected(fun::TransportProtocol::kTcp)) {
+    session->Update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(16)); // 60fps
+  }
+
+  session->Connect(fun::TransportProtocol::kTcp);
+
+  auto start = std::chrono::steady_clock::now();
+  while (is_working) {
+    session->Update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(16)); // 60fps
+
+    if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10)) {
+      is_ok = false;
+      is_working = false;
+    }
+  }
+
+  session->Close();
+
+  return is_ok;
+#else
+  return true;
+#endif
+}
+
+
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiSessionTestMulticastReliabilityJson, "Funapi.Multicast.MC_SR_Json", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
 
 bool FFunapiSessionTestMulticastReliabilityJson::RunTest(const FString& Parameters) {
@@ -2724,124 +2880,1442 @@ bool FFunapiCompressionTestDict::RunTest(const FString& Parameters) {
 }
 
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiTestTLSJson, "Funapi.TLS.Json", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+// 압축 테스트에 사용하는 메시지. 같은 필드가 반복되므로 압축이 잘 된다.
+static fun::string MakeCompressionTestMessage(const int index) {
+  fun::stringstream ss;
+  ss << "{\"id\":" << 12000 + index
+     << ",\"pos_x\":" << 31.01 + index << ",\"pos_z\":45.5293984741"
+     << ",\"dir_x\":-14.199799809265137,\"dir_z\":11.899918530274"
+     << ",\"look_x\":1.100000381469727,\"look_z\":11.600100381469727"
+     << ",\"name\":\"player_" << index % 7 << "\",\"state\":\"moving\",\"hp\":" << 100 - index % 100
+     << ",\"_msgtype\":\"request_move\"}";
+  return ss.str();
+}
 
-bool FFunapiTestTLSJson::RunTest(const FString& Parameters) {
-#if FUNAPI_HAVE_TCP_TLS
-  fun::string send_string = "Json Echo Message";
-  fun::string server_address = g_server_address;
 
-  auto session = fun::FunapiSession::Create(server_address.c_str(), false);
-  bool is_ok = true;
-  bool is_working = true;
+// 보내는 쪽처럼 바이너리 헤더와 압축한 본문을 frame 에 쓴다. 본문을 압축했으면 true 를 반환한다.
+static bool CompressFrameForTest(fun::FunapiCompression &compression,
+                                 const fun::string &msg_type,
+                                 const fun::string &body_string,
+                                 fun::vector<uint8_t> &frame) {
+  fun::FunapiHeaderWriter header;
+  header.SetBinary(true);
+  header.SetVersion(1);
+  header.SetLength(body_string.length());
 
-  session->AddSessionEventCallback
-  ([&send_string]
-  (const std::shared_ptr<fun::FunapiSession> &s,
-    const fun::TransportProtocol protocol,
-    const fun::SessionEventType type,
-    const fun::string &session_id,
-    const std::shared_ptr<fun::FunapiError> &error)
-  {
-  });
+  fun::vector<uint8_t> body(body_string.cbegin(), body_string.cend());
+  compression.Compress(header, body, 0, msg_type);
 
-  session->AddTransportEventCallback
-  ([&is_ok, &is_working]
-  (const std::shared_ptr<fun::FunapiSession> &s,
-    const fun::TransportProtocol protocol,
-    const fun::TransportEventType type,
-    const std::shared_ptr<fun::FunapiError> &error)
-  {
-    if (type == fun::TransportEventType::kConnectionFailed) {
-      is_ok = false;
-      is_working = false;
-    }
-    else if (type == fun::TransportEventType::kConnectionTimedOut) {
-      is_ok = false;
-      is_working = false;
-    }
+  frame.resize(header.GetSize());
+  header.Write(frame.data());
+  frame.insert(frame.end(), body.cbegin(), body.cend());
 
-    verify(type != fun::TransportEventType::kConnectionFailed);
-    verify(type != fun::TransportEventType::kConnectionTimedOut);
-  });
+  return header.GetUncompressedLength() != 0;
+}
 
-  session->AddJsonRecvCallback
-  ([&is_working, &is_ok, &send_string]
-  (const std::shared_ptr<fun::FunapiSession> &s,
-    const fun::TransportProtocol protocol,
-    const fun::string &msg_type, const fun::string &json_string)
-  {
-    if (msg_type.compare("echo") == 0) {
-      is_ok = false;
 
-      rapidjson::Document msg_recv;
-      msg_recv.Parse<0>(json_string.c_str());
+// 받는 쪽처럼 frame 의 헤더를 읽고 본문의 압축을 out 에 푼다.
+static bool DecompressFrameForTest(fun::FunapiCompression &compression,
+                                   const fun::vector<uint8_t> &frame,
+                                   fun::vector<uint8_t> &out) {
+  fun::FunapiHeaderView header;
+  size_t header_size = 0;
+  if (header.ParseBinary(frame.data(), frame.size(), header_size) !=
+      fun::FunapiHeaderView::BinaryParseResult::kComplete) {
+    return false;
+  }
 
-      verify(msg_recv.HasMember("message"));
+  if (header.GetLength() != frame.size() - header_size) {
+    return false;
+  }
 
-      fun::string recv_string = msg_recv["message"].GetString();
+  return compression.Decompress(header, frame.data() + header_size, header.GetLength(), out);
+}
 
-      if (send_string.compare(recv_string) == 0) {
-        is_ok = true;
-        is_working = false;
-      }
-    }
-  });
 
-  auto option = fun::FunapiTcpTransportOption::Create();
-  option->SetUseTLS(true);
-  FString ca_cert_path = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir());
-  ca_cert_path += "Saved/Certificate/cacert.pem";
-  option->SetCACertFilePath(TCHAR_TO_UTF8(*ca_cert_path));
-  session->Connect(fun::TransportProtocol::kTcp, 10801, fun::FunEncoding::kJson, option);
+static bool RoundTripForTest(fun::FunapiCompression &sender,
+                             fun::FunapiCompression &receiver,
+                             const fun::string &msg_type,
+                             const fun::string &body_string) {
+  fun::vector<uint8_t> frame;
+  fun::vector<uint8_t> out;
+  CompressFrameForTest(sender, msg_type, body_string, frame);
 
-  // send
-  {
-    for (int i = 0; i < 10; ++i) {
-      // std::to_string is not supported on android, using fun::stringstream instead.
-      fun::stringstream ss_temp;
-      ss_temp <<  "hello world - " << static_cast<int>(i);
-      fun::string temp_string = ss_temp.str();
+  if (!DecompressFrameForTest(receiver, frame, out)) {
+    return false;
+  }
 
-      rapidjson::Document msg;
-      msg.SetObject();
-      rapidjson::Value message_node(temp_string.c_str(), msg.GetAllocator());
-      msg.AddMember("message", message_node, msg.GetAllocator());
+  return fun::string(out.cbegin(), out.cend()) == body_string;
+}
 
-      // Convert JSON document to fun::string
-      rapidjson::StringBuffer buffer;
-      rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-      msg.Accept(writer);
-      fun::string json_string = buffer.GetString();
 
-      session->SendMessage("echo", json_string);
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiCompressionTestContextReuse, "Funapi.Experimental.CompressionContextReuse", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiCompressionTestContextReuse::RunTest(const FString& Parameters) {
+  fun::vector<fun::CompressionType> types;
+#if FUNAPI_HAVE_ZSTD
+  types.push_back(fun::CompressionType::kZstd);
+#endif
+#if FUNAPI_HAVE_ZLIB
+  types.push_back(fun::CompressionType::kDeflate);
+#endif
+
+  for (auto type : types) {
+    auto sender = std::make_shared<fun::FunapiCompression>();
+    auto receiver = std::make_shared<fun::FunapiCompression>();
+    sender->SetCompressionType(type);
+    receiver->SetCompressionType(type);
+
+    // 압축 효과 추정은 시간에 따라 달라지므로 항상 압축한다.
+    fun::CompressionRule rule;
+    rule.msg_type = "request_move";
+    rule.policy = fun::CompressionPolicy::kAlways;
+    rule.threshold = -1;
+    sender->SetPolicy(rule);
+
+    // 압축한 메시지와 압축되지 않는 메시지를 섞어서 재사용한 context 에 이전 상태가 남지 않는지 확인한다.
+    for (int i = 0; i < 200; ++i) {
+      fun::string body_string = MakeCompressionTestMessage(i);
+      if (i % 10 == 0) {
+        body_string.clear();
+        uint32_t seed = 2463534242u + i;
+        for (int j = 0; j < 256; ++j) {
+          seed ^= seed << 13;
+          seed ^= seed >> 17;
+          seed ^= seed << 5;
+          body_string.push_back(static_cast<char>(seed & 0xFF));
+        }
+      }
+
+      if (!RoundTripForTest(*sender, *receiver, "request_move", body_string)) {
+        return false;
+      }
     }
-  }
-  {
-    rapidjson::Document msg;
-    msg.SetObject();
-    rapidjson::Value message_node(send_string.c_str(), msg.GetAllocator());
-    msg.AddMember("message", message_node, msg.GetAllocator());
 
-    // Convert JSON document to fun::string
-    rapidjson::StringBuffer buffer;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-    msg.Accept(writer);
-    fun::string json_string = buffer.GetString();
+    fun::vector<fun::CompressionStatistics> statistics = sender->GetStatistics();
+    if (statistics.size() != 1 ||
+        statistics[0].compressed_count != 180 ||
+        statistics[0].not_compressed_count != 20) {
+      return false;
+    }
 
-    session->SendMessage("echo", json_string);
-  }
-  // //
+    // context 는 여러 스레드가 나눠 쓴다.
+    std::atomic<bool> is_ok(true);
+    fun::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.push_back(std::thread([&is_ok, sender, receiver, t]() {
+        for (int i = 0; i < 200 && is_ok; ++i) {
+          if (!RoundTripForTest(*sender, *receiver, "request_move", MakeCompressionTestMessage(t * 1000 + i))) {
+            is_ok = false;
+          }
+        }
+      }));
+    }
 
-  while (is_working) {
-    session->Update();
-    std::this_thread::sleep_for(std::chrono::milliseconds(16)); // 60fps
-  }
+    for (auto &t : threads) {
+      t.join();
+    }
 
-  session->Close();
+    if (!is_ok) {
+      return false;
+    }
+  }
 
-  return is_ok;
-#else
   return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiCompressionTestStream, "Funapi.Experimental.CompressionStream", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiCompressionTestStream::RunTest(const FString& Parameters) {
+  fun::vector<fun::CompressionType> types;
+#if FUNAPI_HAVE_ZSTD
+  types.push_back(fun::CompressionType::kZstd);
+#endif
+#if FUNAPI_HAVE_ZLIB
+  types.push_back(fun::CompressionType::kDeflate);
 #endif
-}
\ No newline at end of file
+#if FUNAPI_HAVE_LZ4
+  types.push_back(fun::CompressionType::kLz4);
+#endif
+
+  fun::CompressionRule rule;
+  rule.msg_type = "request_move";
+  rule.policy = fun::CompressionPolicy::kAlways;
+  rule.threshold = -1;
+
+  for (auto type : types) {
+    auto sender = std::make_shared<fun::FunapiCompression>();
+    auto receiver = std::make_shared<fun::FunapiCompression>();
+    auto per_message_sender = std::make_shared<fun::FunapiCompression>();
+    sender->SetCompressionType(type);
+    receiver->SetCompressionType(type);
+    per_message_sender->SetCompressionType(type);
+    sender->SetPolicy(rule);
+    per_message_sender->SetPolicy(rule);
+
+    // 서버가 CSV 필드로 스트림 압축을 받아들인 뒤의 상태
+    sender->SetStreaming(true);
+
+    size_t stream_bytes = 0;
+    size_t per_message_bytes = 0;
+    fun::vector<uint8_t> frame;
+    fun::vector<uint8_t> out;
+
+    for (int i = 0; i < 100; ++i) {
+      fun::string body_string = MakeCompressionTestMessage(i);
+
+      CompressFrameForTest(*sender, "request_move", body_string, frame);
+      stream_bytes += frame.size();
+
+      fun::FunapiHeaderView header;
+      size_t header_size = 0;
+      header.ParseBinary(frame.data(), frame.size(), header_size);
+      if (!header.IsStreamCompressed() || header.GetUncompressedLength() != body_string.length()) {
+        return false;
+      }
+
+      if (!DecompressFrameForTest(*receiver, frame, out) ||
+          fun::string(out.cbegin(), out.cend()) != body_string) {
+        return false;
+      }
+
+      CompressFrameForTest(*per_message_sender, "request_move", body_string, frame);
+      per_message_bytes += frame.size();
+    }
+
+    // 앞선 메시지를 참조하므로 메시지 단위로 압축한 것보다 작아야 한다.
+    if (stream_bytes >= per_message_bytes) {
+      return false;
+    }
+
+    // 손상된 프레임은 스트림을 어긋나게 하므로 복원하지 못한다. 트랜스포트는 이 실패로 연결을 끊는다.
+    CompressFrameForTest(*sender, "request_move", MakeCompressionTestMessage(100), frame);
+    {
+      fun::FunapiHeaderView header;
+      size_t header_size = 0;
+      header.ParseBinary(frame.data(), frame.size(), header_size);
+      std::fill(frame.begin() + header_size, frame.end(), 0xFF);
+    }
+
+    if (DecompressFrameForTest(*receiver, frame, out)) {
+      return false;
+    }
+
+    // 다시 연결하면 두 쪽 모두 스트림을 새로 시작한다.
+    sender->ResetStream();
+    receiver->ResetStream();
+    sender->SetStreaming(true);
+
+    for (int i = 0; i < 10; ++i) {
+      if (!RoundTripForTest(*sender, *receiver, "request_move", MakeCompressionTestMessage(i))) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiCompressionTestPolicy, "Funapi.Experimental.CompressionPolicy", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiCompressionTestPolicy::RunTest(const FString& Parameters) {
+#if FUNAPI_HAVE_ZSTD || FUNAPI_HAVE_ZLIB
+#if FUNAPI_HAVE_ZSTD
+  const fun::CompressionType type = fun::CompressionType::kZstd;
+#else
+  const fun::CompressionType type = fun::CompressionType::kDeflate;
+#endif
+
+  auto sender = std::make_shared<fun::FunapiCompression>();
+  auto receiver = std::make_shared<fun::FunapiCompression>();
+  sender->SetCompressionType(type);
+  receiver->SetCompressionType(type);
+
+  // 압축하지 않는 타입
+  fun::CompressionRule never_rule;
+  never_rule.msg_type = "never";
+  never_rule.policy = fun::CompressionPolicy::kNever;
+  never_rule.threshold = -1;
+  sender->SetPolicy(never_rule);
+
+  // 기본 threshold(128) 보다 작은 메시지도 압축하는 타입
+  fun::CompressionRule small_rule;
+  small_rule.msg_type = "small";
+  small_rule.policy = fun::CompressionPolicy::kAlways;
+  small_rule.threshold = 16;
+  sender->SetPolicy(small_rule);
+
+  fun::string small_string = "{\"message\":\"hello hello hello hello hello hello hello hello\"}";
+  fun::string incompressible_string;
+  uint32_t seed = 2463534242u;
+  for (int i = 0; i < 512; ++i) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    incompressible_string.push_back(static_cast<char>(seed & 0xFF));
+  }
+
+  fun::vector<uint8_t> frame;
+  fun::vector<uint8_t> out;
+  for (int i = 0; i < 100; ++i) {
+    if (CompressFrameForTest(*sender, "never", MakeCompressionTestMessage(i), frame) ||
+        !DecompressFrameForTest(*receiver, frame, out) ||
+        fun::string(out.cbegin(), out.cend()) != MakeCompressionTestMessage(i)) {
+      return false;
+    }
+
+    if (!RoundTripForTest(*sender, *receiver, "small", small_string)) {
+      return false;
+    }
+
+    // 규칙이 없는 타입은 kAdaptive 를 따르므로 효과가 없는 압축을 쉰다.
+    if (!RoundTripForTest(*sender, *receiver, "adaptive", incompressible_string)) {
+      return false;
+    }
+  }
+
+  fun::vector<fun::CompressionStatistics> statistics = sender->GetStatistics();
+  if (statistics.size() != 3) {
+    return false;
+  }
+
+  for (auto &s : statistics) {
+    if (s.msg_type == "never") {
+      if (s.compressed_count != 0 || s.skipped_count != 100) {
+        return false;
+      }
+    }
+    else if (s.msg_type == "small") {
+      if (s.compressed_count != 100 || s.sent_bytes >= s.original_bytes) {
+        return false;
+      }
+    }
+    else if (s.msg_type == "adaptive") {
+      if (s.policy != fun::CompressionPolicy::kAdaptive || !s.paused ||
+          s.skipped_count == 0 || s.compressed_count != 0) {
+        return false;
+      }
+    }
+    else {
+      return false;
+    }
+  }
+
+  return true;
+#else
+  return true;
+#endif
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiCompressionTestLz4, "Funapi.Experimental.CompressionLz4", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiCompressionTestLz4::RunTest(const FString& Parameters) {
+#if FUNAPI_HAVE_LZ4
+  static char dict[] = {
+    "N6Qw7OaV4zEcENhIgAAAAAAA2pAu8cEmbIanlFJKKU0jSZMxINMBAABCIJRW"
+    "+QIAAARAzIeVRcZN0YNRQRiFKgAAAIAAAAAAAAAAAAAAAAAAACRs5KZSRDquS4oAAAAAAAAAAAAAAA"
+    "EAAAAEAAAACAAAADksIl9tc2d0NTI1ODc4OSwiX21zZ196IjotOTAuOTAwMDAxLTIuNSwibG9va196"
+    "IjotOTBvb2tfeCI6LTIuNSwibDAzODE0Njk3MjcsImxvb2tfIjotOS4xMDAwMDAzODE0Njk5MDksIm"
+    "Rpcl96IjotOS4xMDAwMDE1MjU4Nzg5MDksImRpX3giOi0zMy45MDAwMDE1MjUyNDIxOSwiZGlyX3gi"
+    "Oi0zMy4xOTk5OTY5NDgyNDIxOSwicG9zX3oiOi03Ny4xOTk5OTYwOTI2NTEzNywicG9zX3oxMS4xOT"
+    "k5OTk4MDkyNjUxM29zX3giOi0xMS4xOTk5ImlkIjo0NDI4OCwicG9zX3hzdF9tb3ZlIn17ImlkIjo0"
+    "NHBlIjoicmVxdWVzdF9tb3ZlNDgsIl9tc2d0eXBlIjoicmUyMzcwNjA1NDgsIl9tc3oiOi0xNi43OT"
+    "k5OTkyMzEuNSwibG9va196IjotMTYuImxvb2tfeCI6NjEuNSwibG9feiI6LTMwLjUsImxvb2tfeC0z"
+    "OS41LCJkaXJfeiI6LTMwNSwiZGlyX3giOi0zOS41LCJwb3NfeiI6NTEuNSwiZGlyXzIzNzA2MDU1LC"
+    "Jwb3NfeiI6LTU0LjI5OTk5OTIzNzA2MDU0LCJwb3NfeCI6LTU0LjI5OXsiaWQiOjE0NDg0LCJwb3Nf"
+  };
+
+  fun::CompressionRule rule;
+  rule.msg_type = "request_move";
+  rule.policy = fun::CompressionPolicy::kAlways;
+  rule.threshold = -1;
+
+  auto sender = std::make_shared<fun::FunapiCompression>();
+  auto receiver = std::make_shared<fun::FunapiCompression>();
+  sender->SetCompressionType(fun::CompressionType::kLz4);
+  receiver->SetCompressionType(fun::CompressionType::kLz4);
+  sender->SetPolicy(rule);
+
+  // zstd 로 만든 사전을 그대로 쓴다.
+  auto dict_sender = std::make_shared<fun::FunapiCompression>();
+  auto dict_receiver = std::make_shared<fun::FunapiCompression>();
+  dict_sender->SetLz4DictBase64String(dict);
+  dict_receiver->SetLz4DictBase64String(dict);
+  dict_sender->SetPolicy(rule);
+
+  if (!dict_sender->HasCompression(fun::CompressionType::kLz4)) {
+    return false;
+  }
+
+  size_t bytes = 0;
+  size_t dict_bytes = 0;
+  fun::vector<uint8_t> frame;
+  fun::vector<uint8_t> out;
+
+  for (int i = 0; i < 100; ++i) {
+    fun::string body_string = MakeCompressionTestMessage(i);
+
+    if (!CompressFrameForTest(*sender, "request_move", body_string, frame) ||
+        !DecompressFrameForTest(*receiver, frame, out) ||
+        fun::string(out.cbegin(), out.cend()) != body_string) {
+      return false;
+    }
+    bytes += frame.size();
+
+    if (!CompressFrameForTest(*dict_sender, "request_move", body_string, frame) ||
+        !DecompressFrameForTest(*dict_receiver, frame, out) ||
+        fun::string(out.cbegin(), out.cend()) != body_string) {
+      return false;
+    }
+    dict_bytes += frame.size();
+  }
+
+  // 사전에 있는 필드 이름을 참조하므로 더 작아진다.
+  if (dict_bytes >= bytes) {
+    return false;
+  }
+
+  // 블록 하나보다 큰 메시지
+  fun::string large_string;
+  for (int i = 0; large_string.length() < 200 * 1024; ++i) {
+    large_string += MakeCompressionTestMessage(i);
+  }
+
+  if (!RoundTripForTest(*sender, *receiver, "request_move", large_string) ||
+      !RoundTripForTest(*dict_sender, *dict_receiver, "request_move", large_string)) {
+    return false;
+  }
+
+  // 손상된 프레임
+  CompressFrameForTest(*sender, "request_move", MakeCompressionTestMessage(0), frame);
+  {
+    fun::FunapiHeaderView header;
+    size_t header_size = 0;
+    header.ParseBinary(frame.data(), frame.size(), header_size);
+    std::fill(frame.begin() + header_size, frame.end(), 0xFF);
+  }
+
+  return !DecompressFrameForTest(*receiver, frame, out);
+#else
+  return true;
+#endif
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiCompressionTestDictRegistry, "Funapi.Experimental.CompressionDictRegistry", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiCompressionTestDictRegistry::RunTest(const FString& Parameters) {
+  fun::vector<uint8_t> frame;
+  fun::vector<uint8_t> out;
+
+  // 보내는 메시지 2 개마다 하나씩 압축 전 본문을 모은다.
+  {
+    auto compression = std::make_shared<fun::FunapiCompression>();
+    compression->StartCapture(2, 1024 * 1024);
+    for (int i = 0; i < 400; ++i) {
+      CompressFrameForTest(*compression, "request_move", MakeCompressionTestMessage(i), frame);
+    }
+
+    fun::vector<fun::vector<uint8_t>> samples = compression->GetCapturedSamples();
+    if (samples.size() != 200) {
+      return false;
+    }
+
+    for (size_t i = 0; i < samples.size(); ++i) {
+      if (fun::string(samples[i].cbegin(), samples[i].cend()) != MakeCompressionTestMessage(static_cast<int>(i) * 2)) {
+        return false;
+      }
+    }
+
+    // 모은 크기가 max_bytes 를 넘으면 멈춘다.
+    compression->StartCapture(1, 1024);
+    for (int i = 0; i < 100; ++i) {
+      CompressFrameForTest(*compression, "request_move", MakeCompressionTestMessage(i), frame);
+    }
+
+    size_t captured_bytes = 0;
+    for (auto &sample : compression->GetCapturedSamples()) {
+      captured_bytes += sample.size();
+    }
+
+    if (compression->IsCapturing() || captured_bytes == 0 || captured_bytes > 1024) {
+      return false;
+    }
+  }
+
+#if FUNAPI_HAVE_ZSTD && FUNAPI_HAVE_ZDICT
+  // 모은 표본으로 사전 ID 가 다른 사전 두 개를 학습한다.
+  fun::string dict_strings[2];
+  for (int d = 0; d < 2; ++d) {
+    auto compression = std::make_shared<fun::FunapiCompression>();
+    compression->StartCapture(1, 1024 * 1024);
+    for (int i = 0; i < 1000; ++i) {
+      CompressFrameForTest(*compression, "request_move", MakeCompressionTestMessage(d * 1000 + i), frame);
+    }
+
+    fun::ZstdDictionaryReport report;
+    if (!fun::FunapiCompression::TrainZstdDictionary(compression->GetCapturedSamples(),
+                                                     4096, 1001 + d, dict_strings[d], report)) {
+      return false;
+    }
+
+    if (report.dict_id != static_cast<uint32_t>(1001 + d) ||
+        report.test_sample_count != 100 ||
+        report.ratio_with_dict >= report.ratio_without_dict) {
+      return false;
+    }
+  }
+
+  fun::CompressionRule rule;
+  rule.msg_type = "request_move";
+  rule.policy = fun::CompressionPolicy::kAlways;
+  rule.threshold = -1;
+
+  // 받는 쪽은 두 버전의 사전을 모두 등록해 둔다.
+  auto receiver = std::make_shared<fun::FunapiCompression>();
+  if (receiver->AddZstdDictBase64String(dict_strings[0]) != 1001 ||
+      receiver->AddZstdDictBase64String(dict_strings[1]) != 1002 ||
+      receiver->GetLatestZstdDictId() != 1002) {
+    return false;
+  }
+
+  // 보내는 쪽은 CDO 필드로 마지막에 등록한 사전을 제안하고, 서버가 답한 사전 ID 로 압축한다.
+  auto sender = std::make_shared<fun::FunapiCompression>();
+  sender->SetPolicy(rule);
+  if (sender->AddZstdDictBase64String(dict_strings[0]) != 1001 ||
+      sender->GetLatestZstdDictId() != 1001 ||
+      sender->SetZstdDictId(1002) ||
+      !sender->SetZstdDictId(1001)) {
+    return false;
+  }
+
+  fun::vector<uint8_t> old_frame;
+  fun::string old_string = MakeCompressionTestMessage(5000);
+  CompressFrameForTest(*sender, "request_move", old_string, old_frame);
+  {
+    fun::FunapiHeaderView header;
+    size_t header_size = 0;
+    header.ParseBinary(old_frame.data(), old_frame.size(), header_size);
+    if (header.GetDictionaryId() != 1001) {
+      return false;
+    }
+  }
+
+  // 새 사전으로 바꾼 뒤에도 이전 사전으로 압축한 메시지를 풀 수 있다.
+  if (sender->AddZstdDictBase64String(dict_strings[1]) != 1002 || !sender->SetZstdDictId(1002)) {
+    return false;
+  }
+
+  for (int i = 0; i < 10; ++i) {
+    fun::string body_string = MakeCompressionTestMessage(6000 + i);
+    CompressFrameForTest(*sender, "request_move", body_string, frame);
+
+    fun::FunapiHeaderView header;
+    size_t header_size = 0;
+    header.ParseBinary(frame.data(), frame.size(), header_size);
+    if (header.GetDictionaryId() != 1002 ||
+        !DecompressFrameForTest(*receiver, frame, out) ||
+        fun::string(out.cbegin(), out.cend()) != body_string) {
+      return false;
+    }
+  }
+
+  if (!DecompressFrameForTest(*receiver, old_frame, out) ||
+      fun::string(out.cbegin(), out.cend()) != old_string) {
+    return false;
+  }
+
+  // 사전을 모르는 쪽은 풀지 못한다.
+  auto unknown_receiver = std::make_shared<fun::FunapiCompression>();
+  unknown_receiver->SetCompressionType(fun::CompressionType::kZstd);
+  if (DecompressFrameForTest(*unknown_receiver, frame, out)) {
+    return false;
+  }
+#endif
+
+  return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiCompressionTestDecompressReuse, "Funapi.Experimental.CompressionDecompressReuse", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiCompressionTestDecompressReuse::RunTest(const FString& Parameters) {
+  fun::vector<fun::CompressionType> types;
+#if FUNAPI_HAVE_ZSTD
+  types.push_back(fun::CompressionType::kZstd);
+#endif
+#if FUNAPI_HAVE_ZLIB
+  types.push_back(fun::CompressionType::kDeflate);
+#endif
+#if FUNAPI_HAVE_LZ4
+  types.push_back(fun::CompressionType::kLz4);
+#endif
+
+  fun::CompressionRule rule;
+  rule.msg_type = "request_move";
+  rule.policy = fun::CompressionPolicy::kAlways;
+  rule.threshold = -1;
+
+  for (auto type : types) {
+    auto sender = std::make_shared<fun::FunapiCompression>();
+    auto receiver = std::make_shared<fun::FunapiCompression>();
+    sender->SetCompressionType(type);
+    receiver->SetCompressionType(type);
+    sender->SetPolicy(rule);
+
+    // 가장 큰 메시지를 먼저 받은 뒤로는 같은 버퍼를 다시 할당하지 않고 쓴다.
+    fun::string large_string;
+    for (int i = 0; i < 20; ++i) {
+      large_string += MakeCompressionTestMessage(i);
+    }
+
+    fun::vector<uint8_t> frame;
+    fun::vector<uint8_t> out;
+    if (!CompressFrameForTest(*sender, "request_move", large_string, frame) ||
+        !DecompressFrameForTest(*receiver, frame, out) ||
+        fun::string(out.cbegin(), out.cend()) != large_string) {
+      return false;
+    }
+
+    const uint8_t *out_data = out.data();
+    for (int i = 0; i < 100; ++i) {
+      fun::string body_string = MakeCompressionTestMessage(i);
+
+      // 압축하지 않은 메시지는 그대로 복사한다.
+      const bool compressed = (i % 5 != 0);
+      if (compressed) {
+        CompressFrameForTest(*sender, "request_move", body_string, frame);
+      }
+      else {
+        CompressFrameForTest(*sender, "not_compressed", fun::string(body_string.cbegin(), body_string.cbegin() + 100), frame);
+        body_string.resize(100);
+      }
+
+      if (!DecompressFrameForTest(*receiver, frame, out) ||
+          fun::string(out.cbegin(), out.cend()) != body_string) {
+        return false;
+      }
+
+      // 트랜스포트가 뒤에 NUL 을 붙여도 재할당되지 않는다.
+      out.push_back('\0');
+      if (out.data() != out_data) {
+        return false;
+      }
+    }
+
+    // 손상된 메시지는 실패를 반환한다.
+    CompressFrameForTest(*sender, "request_move", MakeCompressionTestMessage(0), frame);
+    {
+      fun::FunapiHeaderView header;
+      size_t header_size = 0;
+      header.ParseBinary(frame.data(), frame.size(), header_size);
+      std::fill(frame.begin() + header_size, frame.end(), 0xFF);
+    }
+
+    if (DecompressFrameForTest(*receiver, frame, out)) {
+      return false;
+    }
+
+    // 실패한 뒤에도 다음 메시지는 풀 수 있다.
+    if (!RoundTripForTest(*sender, *receiver, "request_move", MakeCompressionTestMessage(1))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiHeaderTestMalformed, "Funapi.Experimental.HeaderMalformed", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiHeaderTestMalformed::RunTest(const FString& Parameters) {
+  size_t number = 0;
+
+  if (!fun::FunapiHeaderView::ParseNumber("1234", 4, number) || number != 1234) {
+    return false;
+  }
+
+  fun::stringstream ss;
+  ss << static_cast<size_t>(-1);
+  fun::string max_string = ss.str();
+  if (!fun::FunapiHeaderView::ParseNumber(max_string.c_str(), max_string.length(), number) ||
+      number != static_cast<size_t>(-1)) {
+    return false;
+  }
+
+  // size_t 를 넘는 값
+  fun::string overflow_string = max_string + "0";
+  if (fun::FunapiHeaderView::ParseNumber(overflow_string.c_str(), overflow_string.length(), number)) {
+    return false;
+  }
+
+  fun::string long_string = "99999999999999999999999";
+  if (fun::FunapiHeaderView::ParseNumber(long_string.c_str(), long_string.length(), number)) {
+    return false;
+  }
+
+  if (fun::FunapiHeaderView::ParseNumber("12a", 3, number) ||
+      fun::FunapiHeaderView::ParseNumber("", 0, number)) {
+    return false;
+  }
+
+  // 잘못된 LEN 필드는 길이로 사용하지 않는다.
+  fun::FunapiHeaderView header;
+  header.Add("LEN", 3, long_string.c_str(), long_string.length());
+  if (!header.HasLength() || header.IsLengthValid()) {
+    return false;
+  }
+
+  // size_t 를 넘는 varint
+  uint8_t varint[16];
+  memset(varint, 0xFF, sizeof(varint));
+  varint[sizeof(varint) - 1] = 0x01;
+  const uint8_t *ptr = varint;
+  if (fun::FunapiHeaderView::ParseVarint(ptr, varint + sizeof(varint), number)) {
+    return false;
+  }
+
+  return true;
+}
+
+
+#ifndef FUNAPI_UE4_PLATFORM_PS4
+// 조회가 끝날 때까지 기다린다. 결과는 캐시에 있어도 네트워크 스레드에서 받는다.
+// 캐시를 사용했는지는 GetLookupCount() 로 확인한다.
+static bool ResolveForTest(const fun::string &hostname,
+                           const int port,
+                           bool &is_failed) {
+  std::mutex result_mutex;
+  bool is_done = false;
+  is_failed = true;
+
+  fun::FunapiResolver::Resolve(hostname, port, SOCK_STREAM, 0,
+    [&result_mutex, &is_done, &is_failed]
+    (const bool failed,
+     const int error_code,
+     const fun::string &error_string,
+     std::shared_ptr<fun::FunapiAddrInfo> addrinfo)
+  {
+    std::unique_lock<std::mutex> lock(result_mutex);
+    is_failed = failed;
+    is_done = true;
+  });
+
+  for (int i = 0; i < 300; ++i) {
+    {
+      std::unique_lock<std::mutex> lock(result_mutex);
+      if (is_done) {
+        return true;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(16));
+  }
+
+  return false;
+}
+#endif // FUNAPI_UE4_PLATFORM_PS4
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiResolverTestCacheHit, "Funapi.Resolver.CacheHit", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiResolverTestCacheHit::RunTest(const FString& Parameters) {
+#ifndef FUNAPI_UE4_PLATFORM_PS4
+  // DNS 없이 조회되도록 hosts 항목을 사용한다.
+  fun::string hostname = "funapi-resolver-hit.test";
+  fun::FunapiResolver::SetCacheTTL(60, 5);
+  fun::FunapiResolver::SetHostEntry(hostname, "127.0.0.1");
+
+  bool is_failed = true;
+  uint64_t lookup_count = fun::FunapiResolver::GetLookupCount();
+
+  bool is_ok = ResolveForTest(hostname, 8012, is_failed);
+  is_ok = is_ok && !is_failed;
+  is_ok = is_ok && (fun::FunapiResolver::GetLookupCount() == lookup_count + 1);
+
+  // 두 번째 조회는 getaddrinfo 없이 캐시에서 끝난다.
+  is_ok = is_ok && ResolveForTest(hostname, 8012, is_failed);
+  is_ok = is_ok && !is_failed;
+  is_ok = is_ok && (fun::FunapiResolver::GetLookupCount() == lookup_count + 1);
+
+  fun::FunapiResolver::RemoveHostEntry(hostname);
+
+  return is_ok;
+#else
+  return true;
+#endif
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiResolverTestExpiry, "Funapi.Resolver.Expiry", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiResolverTestExpiry::RunTest(const FString& Parameters) {
+#ifndef FUNAPI_UE4_PLATFORM_PS4
+  fun::string hostname = "funapi-resolver-expiry.test";
+  fun::FunapiResolver::SetCacheTTL(1, 1);
+  fun::FunapiResolver::SetHostEntry(hostname, "127.0.0.1");
+
+  bool is_failed = true;
+  uint64_t lookup_count = fun::FunapiResolver::GetLookupCount();
+
+  bool is_ok = ResolveForTest(hostname, 8012, is_failed);
+  is_ok = is_ok && !is_failed;
+  is_ok = is_ok && (fun::FunapiResolver::GetLookupCount() == lookup_count + 1);
+
+  // TTL 이 지나면 다시 조회한다.
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+  is_ok = is_ok && ResolveForTest(hostname, 8012, is_failed);
+  is_ok = is_ok && !is_failed;
+  is_ok = is_ok && (fun::FunapiResolver::GetLookupCount() == lookup_count + 2);
+
+  fun::FunapiResolver::RemoveHostEntry(hostname);
+  fun::FunapiResolver::SetCacheTTL(60, 5);
+
+  return is_ok;
+#else
+  return true;
+#endif
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiResolverTestFailure, "Funapi.Resolver.Failure", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiResolverTestFailure::RunTest(const FString& Parameters) {
+#ifndef FUNAPI_UE4_PLATFORM_PS4
+  // hosts 항목은 AI_NUMERICHOST 로 조회하므로 ip 가 아닌 값은 DNS 없이 항상 실패한다.
+  fun::string hostname = "funapi-resolver-failure.test";
+  fun::FunapiResolver::SetCacheTTL(60, 5);
+  fun::FunapiResolver::SetHostEntry(hostname, "not-an-ip");
+
+  bool is_failed = false;
+  uint64_t lookup_count = fun::FunapiResolver::GetLookupCount();
+
+  bool is_ok = ResolveForTest(hostname, 8012, is_failed);
+  is_ok = is_ok && is_failed;
+  is_ok = is_ok && (fun::FunapiResolver::GetLookupCount() == lookup_count + 1);
+
+  // 실패한 결과도 잠시 캐시한다.
+  is_ok = is_ok && ResolveForTest(hostname, 8012, is_failed);
+  is_ok = is_ok && is_failed;
+  is_ok = is_ok && (fun::FunapiResolver::GetLookupCount() == lookup_count + 1);
+
+  fun::FunapiResolver::RemoveHostEntry(hostname);
+
+  return is_ok;
+#else
+  return true;
+#endif
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiSharedPayloadTestValidation, "Funapi.SharedPayload.Validation", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiSharedPayloadTestValidation::RunTest(const FString& Parameters) {
+  auto valid = fun::FunapiSharedPayload::Create("echo", "{\"message\":\"hello\"}");
+  if (!valid->IsValid()) {
+    return false;
+  }
+
+  auto padded = fun::FunapiSharedPayload::Create("echo", " \n{\"message\":\"hello\"}\t ");
+  if (!padded->IsValid() || padded->GetSize() != valid->GetSize()) {
+    return false;
+  }
+
+  // 중첩된 객체의 같은 이름은 예약 필드가 아니다.
+  auto nested = fun::FunapiSharedPayload::Create("echo", "{\"data\":{\"_sid\":\"x\"}}");
+  if (!nested->IsValid()) {
+    return false;
+  }
+
+  fun::vector<fun::string> invalid_bodies = {
+    "", "hello", "[1,2]", "{\"message\":", "{} {}",
+    "{\"_msgtype\":\"echo\"}", "{\"_sid\":\"x\"}", "{\"_seq\":1}", "{\"_ack\":1}",
+  };
+
+  for (auto &body : invalid_bodies) {
+    if (fun::FunapiSharedPayload::Create("echo", body)->IsValid()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiTestTLSJson, "Funapi.TLS.Json", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiTestTLSJson::RunTest(const FString& Parameters) {
+#if FUNAPI_HAVE_TCP_TLS
+  fun::string send_string = "Json Echo Message";
+  fun::string server_address = g_server_address;
+
+  auto session = fun::FunapiSession::Create(server_address.c_str(), false);
+  bool is_ok = true;
+  bool is_working = true;
+
+  session->AddSessionEventCallback
+  ([&send_string]
+  (const std::shared_ptr<fun::FunapiSession> &s,
+    const fun::TransportProtocol protocol,
+    const fun::SessionEventType type,
+    const fun::string &session_id,
+    const std::shared_ptr<fun::FunapiError> &error)
+  {
+  });
+
+  session->AddTransportEventCallback
+  ([&is_ok, &is_working]
+  (const std::shared_ptr<fun::FunapiSession> &s,
+    const fun::TransportProtocol protocol,
+    const fun::TransportEventType type,
+    const std::shared_ptr<fun::FunapiError> &error)
+  {
+    if (type == fun::TransportEventType::kConnectionFailed) {
+      is_ok = false;
+      is_working = false;
+    }
+    else if (type == fun::TransportEventType::kConnectionTimedOut) {
+      is_ok = false;
+      is_working = false;
+    }
+
+    verify(type != fun::TransportEventType::kConnectionFailed);
+    verify(type != fun::TransportEventType::kConnectionTimedOut);
+  });
+
+  session->AddJsonRecvCallback
+  ([&is_working, &is_ok, &send_string]
+  (const std::shared_ptr<fun::FunapiSession> &s,
+    const fun::TransportProtocol protocol,
+    const fun::string &msg_type, const fun::string &json_string)
+  {
+    if (msg_type.compare("echo") == 0) {
+      is_ok = false;
+
+      rapidjson::Document msg_recv;
+      msg_recv.Parse<0>(json_string.c_str());
+
+      verify(msg_recv.HasMember("message"));
+
+      fun::string recv_string = msg_recv["message"].GetString();
+
+      if (send_string.compare(recv_string) == 0) {
+        is_ok = true;
+        is_working = false;
+      }
+    }
+  });
+
+  auto option = fun::FunapiTcpTransportOption::Create();
+  option->SetUseTLS(true);
+  FString ca_cert_path = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir());
+  ca_cert_path += "Saved/Certificate/cacert.pem";
+  option->SetCACertFilePath(TCHAR_TO_UTF8(*ca_cert_path));
+  session->Connect(fun::TransportProtocol::kTcp, 10801, fun::FunEncoding::kJson, option);
+
+  // send
+  {
+    for (int i = 0; i < 10; ++i) {
+      // std::to_string is not supported on android, using fun::stringstream instead.
+      fun::stringstream ss_temp;
+      ss_temp <<  "hello world - " << static_cast<int>(i);
+      fun::string temp_string = ss_temp.str();
+
+      rapidjson::Document msg;
+      msg.SetObject();
+      rapidjson::Value message_node(temp_string.c_str(), msg.GetAllocator());
+      msg.AddMember("message", message_node, msg.GetAllocator());
+
+      // Convert JSON document to fun::string
+      rapidjson::StringBuffer buffer;
+      rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+      msg.Accept(writer);
+      fun::string json_string = buffer.GetString();
+
+      session->SendMessage("echo", json_string);
+    }
+  }
+  {
+    rapidjson::Document msg;
+    msg.SetObject();
+    rapidjson::Value message_node(send_string.c_str(), msg.GetAllocator());
+    msg.AddMember("message", message_node, msg.GetAllocator());
+
+    // Convert JSON document to fun::string
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    msg.Accept(writer);
+    fun::string json_string = buffer.GetString();
+
+    session->SendMessage("echo", json_string);
+  }
+  // //
+
+  while (is_working) {
+    session->Update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(16)); // 60fps
+  }
+
+  session->Close();
+
+  return is_ok;
+#else
+  return true;
+#endif
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiTestTLSSessionResumption, "Funapi.TLS.SessionResumption", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFunapiTestTLSSessionResumption::RunTest(const FString& Parameters) {
+#if FUNAPI_HAVE_TCP_TLS
+  fun::string server_address = g_server_address;
+
+  FString ca_cert_path = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir());
+  ca_cert_path += "Saved/Certificate/cacert.pem";
+  fun::string cert_file_path = TCHAR_TO_UTF8(*ca_cert_path);
+
+  // 연결해서 echo 를 한 번 주고받은 뒤 닫는다.
+  // TLS 1.3 은 handshake 가 끝난 뒤에 세션 ticket 을 보내므로 응답까지 기다린다.
+  auto connect_and_echo = [&server_address, &cert_file_path]()->bool
+  {
+    auto session = fun::FunapiSession::Create(server_address.c_str(), false);
+    bool is_ok = true;
+    bool is_working = true;
+
+    session->AddTransportEventCallback
+    ([&is_ok, &is_working]
+    (const std::shared_ptr<fun::FunapiSession> &s,
+      const fun::TransportProtocol protocol,
+      const fun::TransportEventType type,
+      const std::shared_ptr<fun::FunapiError> &error)
+    {
+      if (type == fun::TransportEventType::kConnectionFailed ||
+          type == fun::TransportEventType::kConnectionTimedOut) {
+        is_ok = false;
+        is_working = false;
+      }
+    });
+
+    session->AddJsonRecvCallback
+    ([&is_working]
+    (const std::shared_ptr<fun::FunapiSession> &s,
+      const fun::TransportProtocol protocol,
+      const fun::string &msg_type, const fun::string &json_string)
+    {
+      if (msg_type.compare("echo") == 0) {
+        is_working = false;
+      }
+    });
+
+    auto option = fun::FunapiTcpTransportOption::Create();
+    option->SetUseTLS(true);
+    option->SetCACertFilePath(cert_file_path);
+    session->Connect(fun::TransportProtocol::kTcp, 10801, fun::FunEncoding::kJson, option);
+
+    session->SendMessage("echo", "{\"message\":\"TLS session resumption\"}");
+
+    auto start = std::chrono::steady_clock::now();
+    while (is_working) {
+      session->Update();
+      std::this_thread::sleep_for(std::chrono::milliseconds(16)); // 60fps
+
+      if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10)) {
+        is_ok = false;
+        is_working = false;
+      }
+    }
+
+    session->Close();
+
+    return is_ok;
+  };
+
+  fun::FunapiSession::ClearTlsSessionCache();
+
+  uint64_t full_handshake_count = fun::FunapiSession::GetTlsFullHandshakeCount();
+  uint64_t resumed_count = fun::FunapiSession::GetTlsSessionResumedCount();
+
+  // 처음 연결은 캐시된 세션이 없으므로 전체 handshake 를 한다.
+  if (!connect_and_echo()) {
+    return false;
+  }
+
+  if (fun::FunapiSession::GetTlsFullHandshakeCount() != full_handshake_count + 1 ||
+      fun::FunapiSession::GetTlsSessionResumedCount() != resumed_count) {
+    return false;
+  }
+
+  // 같은 서버로 다시 연결하면 저장된 세션을 재사용한다.
+  if (!connect_and_echo()) {
+    return false;
+  }
+
+  return fun::FunapiSession::GetTlsSessionResumedCount() == resumed_count + 1;
+#else
+  return true;
+#endif
+}
+
+
+// 여러 세션이 동시에 echo 를 주고받을 때 초당 처리한 메시지 수를 돌려준다. 실패하면 0 이다.
+// 모든 세션이 연결된 뒤부터 재고, 세션마다 kWindow 개의 메시지를 보낸 상태를 유지한다.
+static double EchoThroughputForTest(const int network_thread_count,
+                                    const int session_count,
+                                    const int message_count) {
+  const int kWindow = 8;
+  const fun::string send_string = "Benchmark Echo Message";
+
+  fun::FunapiThread::SetNetworkThreadCount(network_thread_count);
+
+  fun::vector<std::shared_ptr<fun::FunapiSession>> sessions;
+  fun::vector<int> sent_counts(session_count, 0);
+  int opened_count = 0;
+  int received_count = 0;
+  bool is_failed = false;
+
+  auto send_message = [&send_string](const std::shared_ptr<fun::FunapiSession> &s) {
+    FunMessage msg;
+    msg.set_msgtype("pbuf_echo");
+    PbufEchoMessage *echo = msg.MutableExtension(pbuf_echo);
+    echo->set_msg(send_string.c_str());
+    s->SendMessage(msg);
+  };
+
+  for (int i = 0; i < session_count; ++i) {
+    auto session = fun::FunapiSession::Create(g_server_address.c_str(), false);
+
+    session->AddSessionEventCallback(
+      [&opened_count](
+        const std::shared_ptr<fun::FunapiSession> &s,
+        const fun::TransportProtocol protocol,
+        const fun::SessionEventType type,
+        const fun::string &session_id,
+        const std::shared_ptr<fun::FunapiError> &error)
+    {
+      if (type == fun::SessionEventType::kOpened) {
+        ++opened_count;
+      }
+    });
+
+    session->AddTransportEventCallback(
+      [&is_failed](
+        const std::shared_ptr<fun::FunapiSession> &s,
+        const fun::TransportProtocol protocol,
+        const fun::TransportEventType type,
+        const std::shared_ptr<fun::FunapiError> &error)
+    {
+      if (type == fun::TransportEventType::kConnectionFailed ||
+          type == fun::TransportEventType::kConnectionTimedOut ||
+          type == fun::TransportEventType::kDisconnected) {
+        is_failed = true;
+      }
+    });
+
+    session->AddProtobufRecvCallback(
+      [i, message_count, &sent_counts, &received_count, &send_message](
+        const std::shared_ptr<fun::FunapiSession> &s,
+        const fun::TransportProtocol protocol,
+        const FunMessage &message)
+    {
+      if (message.msgtype().compare("pbuf_echo") != 0) {
+        return;
+      }
+
+      ++received_count;
+      if (sent_counts[i] < message_count) {
+        ++sent_counts[i];
+        send_message(s);
+      }
+    });
+
+    auto option = fun::FunapiTcpTransportOption::Create();
+    option->SetDisableNagle(true);
+    session->Connect(fun::TransportProtocol::kTcp, 10204, fun::FunEncoding::kProtobuf, option);
+
+    sessions.push_back(session);
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  while (opened_count < session_count && !is_failed && std::chrono::steady_clock::now() < deadline) {
+    fun::FunapiSession::UpdateAll();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  double messages_per_second = 0;
+  if (opened_count == session_count && !is_failed) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < session_count; ++i) {
+      for (int j = 0; j < kWindow && sent_counts[i] < message_count; ++j) {
+        ++sent_counts[i];
+        send_message(sessions[i]);
+      }
+    }
+
+    const int total_count = session_count * message_count;
+    deadline = start + std::chrono::seconds(120);
+    while (received_count < total_count && !is_failed && std::chrono::steady_clock::now() < deadline) {
+      fun::FunapiSession::UpdateAll();
+    }
+
+    if (received_count == total_count) {
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      messages_per_second = total_count / elapsed.count();
+    }
+  }
+
+  for (auto &session : sessions) {
+    session->Close();
+  }
+
+  fun::FunapiThread::SetNetworkThreadCount(1);
+
+  return messages_per_second;
+}
+
+
+// 네트워크 스레드 수에 따른 처리량을 비교한다. 서버가 필요하고 오래 걸리므로 꺼 두고 필요할 때 직접 실행한다.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiBenchmarkNetworkThreads, "Funapi.Benchmark.NetworkThreads", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter | EAutomationTestFlags::Disabled)
+
+bool FFunapiBenchmarkNetworkThreads::RunTest(const FString& Parameters) {
+  const int kSessionCount = 64;
+  const int kMessageCount = 1000;
+
+  for (int thread_count : { 1, 2, 4 }) {
+    double messages_per_second = EchoThroughputForTest(thread_count, kSessionCount, kMessageCount);
+    if (messages_per_second == 0) {
+      return false;
+    }
+
+    UE_LOG(LogFunapiExample, Display, TEXT("NetworkThreads: %d thread(s), %d sessions - %.0f msg/s"),
+           thread_count, kSessionCount, messages_per_second);
+  }
+
+  return true;
+}
+
+
+// 연결된 세션으로 메시지를 한꺼번에 보내고 모두 돌려받을 때까지 메시지 하나에 걸린 시간을 잰다.
+// 인코딩은 FunapiSession 의 실제 전송 경로에서 하므로 변경 전후의 빌드에서 각각 실행해서 비교한다.
+// 서버가 필요하고 결과를 로그로만 남기므로 꺼 두고 필요할 때 직접 실행한다.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiBenchmarkFrameEncode, "Funapi.Benchmark.FrameEncode", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter | EAutomationTestFlags::Disabled)
+
+bool FFunapiBenchmarkFrameEncode::RunTest(const FString& Parameters) {
+  const int kMessageCount = 10000;
+  const size_t kPayloadSize = 200;
+  const fun::string send_string(kPayloadSize, 'a');
+
+  auto session = fun::FunapiSession::Create(g_server_address.c_str(), false);
+  bool is_opened = false;
+  bool is_failed = false;
+  int received_count = 0;
+
+  session->AddSessionEventCallback(
+    [&is_opened](
+      const std::shared_ptr<fun::FunapiSession> &s,
+      const fun::TransportProtocol protocol,
+      const fun::SessionEventType type,
+      const fun::string &session_id,
+      const std::shared_ptr<fun::FunapiError> &error)
+  {
+    if (type == fun::SessionEventType::kOpened) {
+      is_opened = true;
+    }
+  });
+
+  session->AddTransportEventCallback(
+    [&is_failed](
+      const std::shared_ptr<fun::FunapiSession> &s,
+      const fun::TransportProtocol protocol,
+      const fun::TransportEventType type,
+      const std::shared_ptr<fun::FunapiError> &error)
+  {
+    if (type == fun::TransportEventType::kConnectionFailed ||
+        type == fun::TransportEventType::kConnectionTimedOut ||
+        type == fun::TransportEventType::kDisconnected) {
+      is_failed = true;
+    }
+  });
+
+  session->AddProtobufRecvCallback(
+    [&received_count](
+      const std::shared_ptr<fun::FunapiSession> &s,
+      const fun::TransportProtocol protocol,
+      const FunMessage &message)
+  {
+    if (message.msgtype().compare("pbuf_echo") == 0) {
+      ++received_count;
+    }
+  });
+
+  session->Connect(fun::TransportProtocol::kTcp, 10204, fun::FunEncoding::kProtobuf);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!is_opened && !is_failed && std::chrono::steady_clock::now() < deadline) {
+    session->Update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  bool is_ok = false;
+  if (is_opened && !is_failed) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < kMessageCount; ++i) {
+      FunMessage msg;
+      msg.set_msgtype("pbuf_echo");
+      PbufEchoMessage *echo = msg.MutableExtension(pbuf_echo);
+      echo->set_msg(send_string.c_str());
+      session->SendMessage(msg);
+    }
+
+    deadline = start + std::chrono::seconds(60);
+    while (received_count < kMessageCount && !is_failed && std::chrono::steady_clock::now() < deadline) {
+      session->Update();
+    }
+
+    if (received_count == kMessageCount) {
+      std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+      UE_LOG(LogFunapiExample, Display, TEXT("FrameEncode: %d messages of %d-byte body - %.2f us/msg"),
+             kMessageCount, static_cast<int>(kPayloadSize), elapsed.count() / kMessageCount);
+      is_ok = true;
+    }
+  }
+
+  session->Close();
+
+  return is_ok;
+}
+
+
+// UDP 로 burst_count 개씩 echo 를 보내고 받아서 초당 받은 메시지 수를 돌려준다. 실패하면 0 이다.
+// 한 번의 Update() 에서 보낸 메시지는 FunapiUdpTransport 가 묶어서 보낸다.
+// 데이터그램은 잃어버릴 수 있으므로 burst 마다 최대 100ms 까지만 기다린다.
+static double UdpEchoRateForTest(const int burst_count, const int round_count) {
+  const fun::string send_string = "Benchmark Udp Echo Message";
+
+  auto session = fun::FunapiSession::Create(g_server_address.c_str(), false);
+  bool is_opened = false;
+  bool is_started = false;
+  bool is_failed = false;
+  int received_count = 0;
+
+  session->AddSessionEventCallback(
+    [&is_opened](
+      const std::shared_ptr<fun::FunapiSession> &s,
+      const fun::TransportProtocol protocol,
+      const fun::SessionEventType type,
+      const fun::string &session_id,
+      const std::shared_ptr<fun::FunapiError> &error)
+  {
+    if (type == fun::SessionEventType::kOpened) {
+      is_opened = true;
+    }
+  });
+
+  session->AddTransportEventCallback(
+    [&is_started, &is_failed](
+      const std::shared_ptr<fun::FunapiSession> &s,
+      const fun::TransportProtocol protocol,
+      const fun::TransportEventType type,
+      const std::shared_ptr<fun::FunapiError> &error)
+  {
+    if (type == fun::TransportEventType::kStarted && protocol == fun::TransportProtocol::kUdp) {
+      is_started = true;
+    }
+    else if (type == fun::TransportEventType::kConnectionFailed ||
+             type == fun::TransportEventType::kConnectionTimedOut ||
+             type == fun::TransportEventType::kDisconnected) {
+      is_failed = true;
+    }
+  });
+
+  session->AddJsonRecvCallback(
+    [&received_count](
+      const std::shared_ptr<fun::FunapiSession> &s,
+      const fun::TransportProtocol protocol,
+      const fun::string &msg_type,
+      const fun::string &json_string)
+  {
+    if (protocol == fun::TransportProtocol::kUdp && msg_type.compare("echo") == 0) {
+      ++received_count;
+    }
+  });
+
+  // 세션 아이디를 TCP 로 받은 다음에 UDP 로 보낼 수 있다.
+  session->Connect(fun::TransportProtocol::kTcp, 10201, fun::FunEncoding::kJson);
+  session->Connect(fun::TransportProtocol::kUdp, 11202, fun::FunEncoding::kJson);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!(is_opened && is_started) && !is_failed && std::chrono::steady_clock::now() < deadline) {
+    session->Update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  double messages_per_second = 0;
+  if (is_opened && is_started && !is_failed) {
+    fun::string json_string;
+    {
+      rapidjson::Document msg;
+      msg.SetObject();
+      rapidjson::Value message_node(send_string.c_str(), msg.GetAllocator());
+      msg.AddMember("message", message_node, msg.GetAllocator());
+
+      rapidjson::StringBuffer buffer;
+      rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+      msg.Accept(writer);
+      json_string = buffer.GetString();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int round = 0; round < round_count && !is_failed; ++round) {
+      const int expected_count = received_count + burst_count;
+
+      for (int i = 0; i < burst_count; ++i) {
+        session->SendMessage("echo", json_string, fun::TransportProtocol::kUdp);
+      }
+
+      deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+      while (received_count < expected_count && !is_failed && std::chrono::steady_clock::now() < deadline) {
+        session->Update();
+      }
+    }
+
+    if (received_count > 0 && !is_failed) {
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      messages_per_second = received_count / elapsed.count();
+    }
+
+    UE_LOG(LogFunapiExample, Display, TEXT("UdpBatching: received %d of %d messages"),
+           received_count, burst_count * round_count);
+  }
+
+  session->Close();
+
+  return messages_per_second;
+}
+
+
+// FunapiSession 의 UDP transport 로 echo 를 묶어서 주고받을 때의 초당 메시지 수를 잰다.
+// FUNAPI_HAVE_MMSG 를 0 으로 빌드하면 sendto/recvfrom 으로 하나씩 보낼 때와 비교할 수 있다.
+// 서버가 필요하고 결과를 로그로만 남기므로 꺼 두고 필요할 때 직접 실행한다.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFunapiBenchmarkUdpBatching, "Funapi.Benchmark.UdpBatching", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter | EAutomationTestFlags::Disabled)
+
+bool FFunapiBenchmarkUdpBatching::RunTest(const FString& Parameters) {
+  const int kBurstCount = 32;
+  const int kRoundCount = 2000;
+
+  double messages_per_second = UdpEchoRateForTest(kBurstCount, kRoundCount);
+  if (messages_per_second == 0) {
+    return false;
+  }
+
+  UE_LOG(LogFunapiExample, Display, TEXT("UdpBatching: bursts of %d, FUNAPI_HAVE_MMSG=%d - %.0f msg/s"),
+         kBurstCount, FUNAPI_HAVE_MMSG, messages_per_second);
+
+  return true;
+}